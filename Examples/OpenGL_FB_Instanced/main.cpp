@@ -15,6 +15,7 @@
 #include <OpenGL/image_manager.hpp>
 #include <OpenGL/opengl_vertex_input.hpp>
 #include <OpenGL/camera.hpp>
+#include <OpenGL/opengl_frame_constants.hpp>
 
 #include <UI/ui.hpp>
 #include <UI/io.hpp>
@@ -87,16 +88,27 @@ int main() {
     );
 
     IOHandler io_handler(map_chunk);
+    auto frame_constants = opengl::frame_uniform_buffer_t::create();
 
     while (!glfwWindowShouldClose(win)) {
         glfwPollEvents();
         opengl::Context::instance().draw_background();
 
-        map_chunk.render(camera);
+        frame_constants.update(opengl::frame_constants_t::create(camera));
+        frame_constants.bind();
+        map_chunk.render();
 
+        opengl::GpuProfiler::instance().end_frame();
+        opengl::Context::instance().end_frame();
         glfwSwapBuffers(win);
     }
 
+    for (const auto& zone : opengl::GpuProfiler::instance().zones()) {
+        std::cout << zone.path << ": " << zone.avg_ms << " ms avg, "
+                  << zone.max_ms << " ms max" << std::endl;
+    }
+    opengl::GpuProfiler::instance().free();
+    frame_constants.free();
     glfwDestroyWindow(win);
     glfwTerminate();
     return 0;
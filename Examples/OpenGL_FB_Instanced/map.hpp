@@ -7,6 +7,7 @@
 #include <OpenGL/image_manager.hpp>
 #include <OpenGL/opengl_vertex_input.hpp>
 #include <OpenGL/camera.hpp>
+#include <OpenGL/opengl_gpu_profiler.hpp>
 
 using maybe_texdata_t = opengl::TextureManager::maybe_texture_t<
     opengl::texture_data_t
@@ -230,14 +231,14 @@ public:
         };
     }
 
-    void render(const opengl::Camera& cam) {
+    // projection and view come from the FrameConstants uniform block
+    void render() {
+        opengl::GpuZone zone("map_chunk");
         auto pr = main_render.impl.program;
 
         opengl::use(pr);
         opengl::buffer_bind_guard bind_vao({ .vao = main_render.impl.vao });
         opengl::activate_texture(tex_activation());
-        opengl::set_mat4(pr, "projection", cam.projection());
-        opengl::set_mat4(pr, "view", cam.view());
         opengl::draw_instance_elements({
             .vao           = main_render.impl.vao,
             .count         = main_render.impl.ebo_count,
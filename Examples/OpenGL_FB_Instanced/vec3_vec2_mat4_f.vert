@@ -6,8 +6,12 @@ layout(location = 1) in vec2 in_uv;
 layout(location = 2) in mat4 ins_model;
 layout(location = 6) in float ins_tile_index;
 
-uniform mat4 projection;
-uniform mat4 view;
+layout (std140, binding = 0) uniform FrameConstants {
+    mat4 projection;
+    mat4 view;
+    vec4 light_position;
+    vec4 light_color;
+};
 
 out vec2 uv;
 flat out float tile_index;
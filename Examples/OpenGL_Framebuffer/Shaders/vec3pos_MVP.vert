@@ -2,9 +2,14 @@
 
 layout (location = 0) in vec3 in_pos;
 
+layout (std140, binding = 0) uniform FrameConstants {
+    mat4 projection;
+    mat4 view;
+    vec4 light_position;
+    vec4 light_color;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main() {
     gl_Position = projection * view * model * vec4(in_pos, 1.0);
@@ -5,9 +5,14 @@ layout (location = 1) in vec2 in_tex;
 
 out vec2 uv;
 
+layout (std140, binding = 0) uniform FrameConstants {
+    mat4 projection;
+    mat4 view;
+    vec4 light_position;
+    vec4 light_color;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main() {
     gl_Position = projection * view * model * vec4(in_pos, 1.0);
@@ -14,6 +14,8 @@
 #include <OpenGL/opengl_proc.hpp>
 #include <OpenGL/opengl_vertex_input.hpp>
 #include <OpenGL/camera.hpp>
+#include <OpenGL/opengl_frame_constants.hpp>
+#include <OpenGL/opengl_frame_graph.hpp>
 
 #include <UI/io.hpp>
 
@@ -97,26 +99,19 @@ int main() {
     GLuint fbuff_vao = opengl::gen_vertex_array();
     std::vector<GLuint> fbuff_vbo = fbuffer_input_t::gen_buffers(fbuff_vao,
                                                                  fbuff_input);
-    opengl::framebuffer_data_t fbuff_data {
-        .fbo              = opengl::gen_framebuffer(),
-        .attachment_point = GL_COLOR_ATTACHMENT0,
-        .texture          = {
-            .id         = opengl::gen_texture(),
-            .target     = GL_TEXTURE_2D,
-            .w          = GLint(WIDTH * 0.5f),
-            .h          = GLint(HEIGHT),
-            .format     = GL_RGBA,
-            .type       = GL_UNSIGNED_BYTE,
-            .wrap_s     = GL_CLAMP_TO_EDGE,
-            .wrap_t     = GL_CLAMP_TO_EDGE,
-            .min_filter = GL_LINEAR,
-            .mag_filter = GL_LINEAR
-        }
+    // the offscreen target is a transient, multisampled graph resource,
+    // the screen pass samples its resolved twin
+    opengl::FrameGraph graph;
+    const opengl::attachment_desc_t fbuff_desc {
+        .size = {GLint(WIDTH * 0.5f), GLint(HEIGHT)},
+        .samples = 4
     };
-    opengl::set_texture_meta(nullptr, fbuff_data.texture);
-    opengl::attach_texture(fbuff_data, fbuff_data.texture);
 
     glm::mat4 one(1.0);
+    auto frame_constants = opengl::frame_uniform_buffer_t::create();
+    frame_constants.update(opengl::frame_constants_t::create(one, one));
+    frame_constants.bind();
+
     const glm::mat4 fbuff_scale = glm::scale(one, {0.5, 0.5, 0.5});
     const glm::mat4 main_scale = glm::scale(one, {0.5, 1.0, 0.0});
     glm::mat4 main_model = one;
@@ -126,40 +121,48 @@ int main() {
         opengl::Context::instance().draw_background();
 
         fbuff_model = glm::translate(one, {-rot_value(), rot_vertically_value(), 0.0});
-        opengl::use(fbuff_program);
-        opengl::set_mat4(fbuff_program, "projection", one);
-        opengl::set_mat4(fbuff_program, "view", one);
-        opengl::set_mat4(fbuff_program, "model", fbuff_model * fbuff_scale);
-        opengl::draw_array_framebuffer({
-            .fbo = fbuff_data.fbo,
-            .vao = fbuff_vao,
-            .count = fbuff_input.size(),
-            .viewport = {0, 0, fbuff_data.texture.w, fbuff_data.texture.h},
-            .screen_viewport = {0, 0, WIDTH, HEIGHT},
-            .background = {0.0, 0.0, 0.0, 0.3}
-        });
-        opengl::use(0);
-
         main_model = glm::translate(one, {rot_value(), 0.0, 0.0});
-        opengl::use(program);
-        opengl::set_mat4(program, "projection", one);
-        opengl::set_mat4(program, "view", one);
-        opengl::set_mat4(program, "model", main_model * main_scale);
-        opengl::activate_texture({
-            .tex_unit     = GL_TEXTURE0,
-            .sampler_type = fbuff_data.texture.target,
-            .id           = fbuff_data.texture.id,
-            .program      = program,
-            .sampler_name = "tex"
+
+        graph.reset();
+        auto fbuff = graph.create("fbuff", fbuff_desc);
+        graph.add_pass("fbuff", [&](auto& pass) {
+            pass.write(fbuff);
+        }, [&](const auto&) {
+            opengl::background({0.0, 0.0, 0.0, 0.3}, GL_COLOR_BUFFER_BIT);
+            opengl::use(fbuff_program);
+            opengl::set_mat4(fbuff_program, "model", fbuff_model * fbuff_scale);
+            opengl::draw(opengl::draw_array_command_t{
+                .vao = fbuff_vao,
+                .count = fbuff_input.size()
+            });
+            opengl::use(0);
         });
-        opengl::draw(opengl::draw_array_command_t{
-            .vao = vao,
-            .count = scene_input.size()
+        graph.add_pass("screen", [&](auto& pass) {
+            pass.read(fbuff);
+            pass.side_effect();
+        }, [&](const auto& ctx) {
+            opengl::use(program);
+            opengl::set_mat4(program, "model", main_model * main_scale);
+            opengl::activate_texture({
+                .tex_unit     = GL_TEXTURE0,
+                .sampler_type = GL_TEXTURE_2D,
+                .id           = ctx.texture(fbuff),
+                .program      = program,
+                .sampler_name = "tex"
+            });
+            opengl::draw(opengl::draw_array_command_t{
+                .vao = vao,
+                .count = scene_input.size()
+            });
+            opengl::use(0);
         });
-        opengl::use(0);
+        graph.compile();
+        graph.execute();
         glfwSwapBuffers(win);
     }
 
+    graph.free();
+    frame_constants.free();
     glfwDestroyWindow(win);
     glfwTerminate();
 }
\ No newline at end of file
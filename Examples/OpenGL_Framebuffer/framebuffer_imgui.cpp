@@ -21,6 +21,7 @@
 #include <OpenGL/opengl_proc.hpp>
 #include <OpenGL/opengl_vertex_input.hpp>
 #include <OpenGL/camera.hpp>
+#include <OpenGL/opengl_gpu_profiler.hpp>
 
 
 namespace fs = std::filesystem;
@@ -102,7 +103,11 @@ std::vector<ui::widget_sptr_t> create_ui() {
         ImGuiWindowFlags_NoScrollWithMouse,
         {canvas}
     );
-    return {window};
+    auto gpu_window = ui::Window::create(
+        {60, 60}, {38, 38}, "GPU", ImGuiWindowFlags_NoResize,
+        {ui::GpuProfilerView::create({100, 100}, "gpu_zones")}
+    );
+    return {window, gpu_window};
 }
 
 
@@ -138,9 +143,12 @@ int main() {
 
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        opengl::GpuProfiler::instance().end_frame();
+        opengl::Context::instance().end_frame();
         glfwSwapBuffers(win);
     }
 
+    opengl::GpuProfiler::instance().free();
     glfwDestroyWindow(win);
     glfwTerminate();
     return EXIT_SUCCESS;
@@ -0,0 +1,7 @@
+#version 450 core
+
+layout (location = 0) in vec3 aPos;
+
+void main() {
+    gl_Position = vec4(aPos, 1.0);
+}
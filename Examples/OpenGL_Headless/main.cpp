@@ -0,0 +1,67 @@
+#include <format>
+#include <vector>
+#include <iostream>
+#include <filesystem>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <UI/headless.hpp>
+#include <OpenGL/opengl_proc.hpp>
+#include <OpenGL/opengl_vertex_input.hpp>
+#include <OpenGL/opengl_render_data.hpp>
+#include <OpenGL/opengl_framebuffer_data.hpp>
+
+
+namespace fs = std::filesystem;
+
+static constexpr int WIDTH = 320;
+static constexpr int HEIGHT = 240;
+static constexpr int FRAMES = 4;
+
+
+// Renders a few frames without a window and writes them as images, runs on
+// machines with no display and no GPU (Mesa llvmpipe). llvmpipe stops at
+// OpenGL 4.5, so this asks for 4.5 and its shaders say #version 450.
+int main() {
+    auto headless = ui::headless_context_t::create(4, 5);
+    if (!headless.is_valid()) { return EXIT_FAILURE; }
+    auto& ctx = opengl::Context::instance();
+    ctx.initialize(headless.api(), true);
+
+    auto target = opengl::framebuffer_data_t::create(WIDTH, HEIGHT);
+    if (target.status() != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Offscreen target is incomplete" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto triangle = opengl::render_data_t::create<opengl::vec3pos>(
+        fs::path("./vec3pos.vert"),
+        fs::path("./fixed_color.frag"),
+        {{{-0.5f, -0.5f, 0.0f}}, {{0.5f, -0.5f, 0.0f}}, {{0.0f, 0.5f, 0.0f}}},
+        {0, 1, 2}
+    );
+
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        const float shade = float(frame) / FRAMES;
+        opengl::bind_fbo(target.fbo);
+        opengl::viewport(0, 0, WIDTH, HEIGHT);
+        opengl::background({shade, shade, shade, 1.0f},
+                           GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        opengl::use(triangle.program);
+        opengl::draw(triangle.draw_elements());
+        opengl::bind_fbo(0);
+
+        const auto image = target.read();
+        const auto path = fs::path(std::format("frame_{}", frame));
+        if (!opengl::ImageData::write(path, image)) {
+            std::cerr << "Could not write " << path << std::endl;
+        }
+        ctx.end_frame();
+    }
+
+    triangle.free();
+    target.free();
+    headless.free();
+    return EXIT_SUCCESS;
+}
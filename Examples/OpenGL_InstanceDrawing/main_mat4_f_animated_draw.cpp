@@ -1,4 +1,5 @@
 #include <array>
+#include <algorithm>
 #include <vector>
 #include <filesystem>
 #include <iostream>
@@ -14,6 +15,7 @@
 #include <UI/ui.hpp>
 #include <OpenGL/texture.hpp>
 #include <OpenGL/opengl_proc.hpp>
+#include <OpenGL/opengl_stream_buffer.hpp>
 #include <OpenGL/opengl_vertex_input.hpp>
 #include <OpenGL/camera.hpp>
 
@@ -118,12 +120,11 @@ int main() {
         GL_DYNAMIC_DRAW
     );
     auto frames_converted = opengl::float_instanced::convert(frames);
-    GLuint f_i_buffer = opengl::float_instanced::gen_buffer(
-        vao,
-        frames_converted,
-        6,
-        GL_DYNAMIC_DRAW
+    // tile indices are rewritten every frame straight into mapped memory
+    auto frames_stream = opengl::StreamBuffer::create(
+        frames_converted.size() * sizeof(opengl::float_instanced)
     );
+    opengl::float_instanced::layout_stream(vao, 6);
 
     glm::mat4 proj(1.0), view(1.0);
 
@@ -171,16 +172,27 @@ int main() {
         glfwPollEvents();
         opengl::Context::instance().draw_background();
 
-        opengl::use(program);
-        opengl::activate_texture(tex_activation);
-        opengl::set_mat4(program, "projection", proj);
-        opengl::set_mat4(program, "view", view);
-        opengl::draw_instance_elements({
-            .vao           = vao,
-            .count         = GLsizei(elements.size()),
-            .instancecount = GLsizei(frames.size())
-        });
-        opengl::use(0);
+        auto f_i_frame = frames_stream.allocate<opengl::float_instanced>(
+            frames_converted.size()
+        );
+        // the ring is exhausted or the mapping failed, skip this frame
+        if (f_i_frame.is_valid()) {
+            std::copy(frames_converted.begin(), frames_converted.end(),
+                      f_i_frame.data.begin());
+            opengl::float_instanced::bind_stream(vao, 6, frames_stream.id(),
+                                                 f_i_frame.offset);
+
+            opengl::use(program);
+            opengl::activate_texture(tex_activation);
+            opengl::set_mat4(program, "projection", proj);
+            opengl::set_mat4(program, "view", view);
+            opengl::draw_instance_elements({
+                .vao           = vao,
+                .count         = GLsizei(elements.size()),
+                .instancecount = GLsizei(frames.size())
+            });
+            opengl::use(0);
+        }
 
         frames_converted[0] = is_odd ? 0.0 : 1.0;
         frames_converted[1] = is_odd ? 2.0 : 3.0;
@@ -191,15 +203,16 @@ int main() {
         if ((t1 - t0) > 1s) {
             t0 = t1;
             is_odd = !is_odd;
-            opengl::float_instanced::update(f_i_buffer, frames_converted);
         }
 
+        frames_stream.end_frame();
+        opengl::Context::instance().end_frame();
         glfwSwapBuffers(win);
     }
 
     opengl::free_vertex_buffers(buffers);
     opengl::free_vertex_buffer(mat_i_buffer);
-    opengl::free_vertex_buffer(f_i_buffer);
+    frames_stream.free();
     opengl::free_element_buffer(ebo);
     opengl::free_vertex_array(vao);
 
@@ -58,9 +58,8 @@ int main() {
     auto vertices = create_vertices();
     auto indices = create_indices();
 
-    auto buffers = decltype(vertices)::value_type::gen_buffers(vao, vertices);
-    opengl::bind_vao(vao);
-    opengl::bind_ebo(ebo, indices);
+    auto buffers = decltype(vertices)::value_type::gen_buffers(vao, vertices,
+                                                               ebo, indices);
 
     opengl::TextureArray texture(R"(.\fire.jpg)", 6, 6);
     if (!texture.read()) { return EXIT_FAILURE; }
@@ -11,6 +11,7 @@
 #include <OpenGL/opengl_proc.hpp>
 #include <OpenGL/opengl_vertex_input.hpp>
 #include <OpenGL/texture.hpp>
+#include <OpenGL/texture_manager.hpp>
 
 
 int WIDTH = 1280;
@@ -57,33 +58,20 @@ int main() {
     auto vertices = create_vertices();
     auto indices = create_indices();
 
-    auto buffers = decltype(vertices)::value_type::gen_buffers(vao, vertices);
-    opengl::bind_vao(vao);
-    opengl::bind_ebo(ebo, indices);
+    auto buffers = decltype(vertices)::value_type::gen_buffers(vao, vertices,
+                                                               ebo, indices);
 
-    auto image = opengl::ImageData::read("fire.jpg");
-    if (!image.is_valid()) {
-        std::cout << "No image read" << std::endl;
-        return EXIT_FAILURE;
-    }
-    opengl::texture_data_array_2d_t tex_data {
-        .tex_data = {
-            .id         = opengl::gen_texture(GL_TEXTURE_2D_ARRAY),
-            .target     = GL_TEXTURE_2D_ARRAY,
-            .w          = image.w,
-            .h          = image.h,
-            .format     = GL_RGBA,
-            .type       = GL_UNSIGNED_BYTE,
-            .wrap_s     = GL_CLAMP_TO_EDGE,
-            .wrap_t     = GL_CLAMP_TO_EDGE,
-            .min_filter = GL_LINEAR,
-            .mag_filter = GL_LINEAR
-        },
+    // The sheet streams in, the loop draws the placeholder until then
+    opengl::TextureManager textures;
+    textures.request("fire", {
+        .path = "fire.jpg",
         .tile_count_w = 6,
         .tile_count_h = 6
-    };
-
-    opengl::set_texture_2d_array_meta(image.data, tex_data);
+    }, [](const std::string& key, opengl::TextureState state) {
+        if (state == opengl::TextureState::FAILED) {
+            std::cout << "No image read: " << key << std::endl;
+        }
+    });
 
     glm::mat4 projection(1.0);
     glm::mat4 view(1.0);
@@ -92,6 +80,10 @@ int main() {
     uint64_t count = 0;
     while (!glfwWindowShouldClose(window)) {
         frame_preprocess(vao);
+        textures.poll();
+        const auto& tex_data = textures.get_or_placeholder<
+            opengl::texture_data_array_2d_t
+        >("fire");
         opengl::Context::instance().draw_background();
         opengl::use(program);
         opengl::activate_texture({
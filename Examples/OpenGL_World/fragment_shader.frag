@@ -2,13 +2,16 @@
 
 in vec3 position;
 in vec3 normal;
+flat in vec4 color;
 
 out vec4 FragColor;
 
-uniform vec4 color;
-
-uniform vec4 light_color;
-uniform vec3 light_position;
+layout (std140, binding = 0) uniform FrameConstants {
+    mat4 projection;
+    mat4 view;
+    vec4 light_position;
+    vec4 light_color;
+};
 
 
 vec4 eval_ambient_color() {
@@ -17,7 +20,7 @@ vec4 eval_ambient_color() {
 }
 
 vec4 eval_diffuse_color() {
-    vec3 light_dir = normalize(light_position - position);
+    vec3 light_dir = normalize(light_position.xyz - position);
     float diff = max(dot(normal, light_dir), 0.0);
     return diff * light_color;
 }
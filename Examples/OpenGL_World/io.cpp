@@ -95,16 +95,12 @@ void GlobalListener::consume(const ui::FramebufferEvent& event) {
 }
 
 void GlobalListener::pick_pixel() {
-    GLuint index;
     int x = _last_mouse_event.xpos;
     int y = _scene.height() - (int)_last_mouse_event.ypos - 1;
-    SAFE_CALL(glReadPixels(
-        x, y,
-        1, 1,
-        GL_STENCIL_INDEX,
-        GL_UNSIGNED_INT,
-        &index
-    ));
+    _scene.pick(x, y, [this](GLuint index) { activate(index); });
+}
+
+void GlobalListener::activate(GLuint index) {
     if (_scene.activate_index(index)) {
         std::cout << "item activated: " << index << std::endl;
         auto* active_item = _scene.active_item();
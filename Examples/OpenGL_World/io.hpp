@@ -73,6 +73,7 @@ public:
 
 private:
     void pick_pixel();
+    void activate(GLuint index);
     bool is_item_active();
 
 private:
@@ -1,51 +1,56 @@
+#include <limits>
+#include <algorithm>
+
 #include <glm/gtx/transform.hpp>
 
 #include <OpenGL/opengl_proc.hpp>
+#include <OpenGL/opengl_gpu_profiler.hpp>
+#include <Profiler/profiler.hpp>
 
 #include "item.hpp"
 
 namespace fs = std::filesystem;
 
+ItemUniforms ItemUniforms::create(const opengl::Program& program) {
+    return {
+        .model = program.uniform("model")
+    };
+}
+
+static std::string material_key(const fs::path& vertex,
+                                const fs::path& fragment) {
+    return vertex.string() + "|" + fragment.string();
+}
+
+
 Item3D::Item3D(const fs::path& vertex,
                const fs::path& fragment,
                const glm::vec4& color,
                bool is_selectable)
-    : _program(opengl::create_program(vertex, fragment))
+    : _program(opengl::ProgramRegistry::instance().acquire(vertex, fragment))
+    , _material(material_key(vertex, fragment))
     , _color(color)
     , _is_selectable(is_selectable)
 {}
 
 Item3D::Item3D(ItemInputData&& data)
-    : _program(opengl::create_program(data.vertex, data.fragment))
+    : _program(opengl::ProgramRegistry::instance().acquire(data.vertex,
+                                                           data.fragment))
+    , _material(material_key(data.vertex, data.fragment))
     , _color(data.color)
-    , _selection_program(opengl::create_program(data.vertex, data.fragment))
+    , _selection_program(opengl::ProgramRegistry::instance().acquire(
+        data.vertex_selection,
+        data.fragment_selection
+    ))
     , _selection_color(data.selection_color)
     , _is_selectable(data.is_selectable)
 {}
 
 Item3D::~Item3D() {}
 
-void Item3D::finalyze() {
-    opengl::free_vertex_array(_vao);
-}
-
 void Item3D::open(const std::string& path) {
+    _mesh_path = path;
     _vertices = loader::Converter().read(path);
-    _vao = opengl::gen_vertex_array();
-    for (const auto& vertex_data : _vertices) {
-        _vertex_input.push_back(std::move(
-            loader::Vertices::value_type::gen_buffers(_vao, vertex_data)
-        ));
-    }
-}
-
-void Item3D::draw() const {
-    for (size_t i = 0; i < _vertices.size(); ++i) {
-        opengl::draw(opengl::draw_array_command_t{
-            .vao   = _vao,
-            .count = _vertices[i].size(),
-        });
-    }
 }
 
 void Item3D::modify(glm::mat4&& modificator) {
@@ -64,27 +69,29 @@ void Item3D::deactivate() {
     _is_active = false;
 }
 
-
-void pass_shader_uniforms(GLuint program, ShaderUniformData&& data,
-                          const Item3D& item) {
-    opengl::use(program);
-    opengl::set_vec4(program, "color", data.color);
-    opengl::set_vec3(program, "light_position", data.light_position);
-    opengl::set_vec4(program, "light_color", data.light_color);
-    opengl::set_mat4(program, "view", data.view);
-    opengl::set_mat4(program, "projection", data.projection);
-    opengl::set_mat4(program, "model", data.model);
-    item.draw();
+const ItemUniforms& Item3D::selection_uniforms() const {
+    if (!_selection_uniforms) {
+        _selection_uniforms = ItemUniforms::create(*selection_program());
+    }
+    return *_selection_uniforms;
 }
 
-void pass_selection_shader_uniforms(GLuint program,
-                                    SelectionShaderUniformData&& data,
-                                    const Item3D& item) {
-    opengl::use(program);
-    opengl::set_mat4(program, "model", data.model);
-    opengl::set_mat4(program, "view", data.view);
-    opengl::set_mat4(program, "projection", data.projection);
-    item.draw();
+
+void pass_selection_shader_uniforms(
+        Item3D& item, const std::vector<opengl::mesh_range_t>& meshes,
+        GLuint vao, SelectionShaderUniformData&& data) {
+    auto* program = item.selection_program();
+    if (program == nullptr) { return; }
+    opengl::use(program->id());
+    program->set(item.selection_uniforms().model, data.model);
+    // the pool only holds array meshes, see Scene::rebuild
+    for (const auto& mesh : meshes) {
+        opengl::draw(opengl::draw_array_command_t{
+            .vao   = vao,
+            .count = mesh.count,
+            .first = mesh.first
+        });
+    }
 }
 
 
@@ -101,31 +108,145 @@ Scene::Scene(opengl::Light&& light, opengl::Camera&& camera)
 {}
 
 Scene::~Scene() {
-    for (auto& item : _items) {
-        item.finalyze();
+    release_batches();
+    _pixels.free();
+    _frame_constants.free();
+}
+
+void Scene::release_batches() {
+    for (auto& [key, material] : _materials) {
+        material.batch.free();
     }
+    _materials.clear();
+    _meshes.free();
+    _mesh_ranges.clear();
+    _draw_list.clear();
 }
 
+// Packs the meshes of all items into one pool, meshes loaded from the same
+// file are stored once, and groups the items by material
+void Scene::rebuild() {
+    release_batches();
 
-void Scene::draw() {
     int stencil_ref = 1;
     for (auto& item : _items) {
-        SAFE_CALL(glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE));
-        SAFE_CALL(glStencilFunc(GL_ALWAYS, stencil_ref, 0xFF));
-        SAFE_CALL(glStencilMask(0xFF));
-        item.id(stencil_ref);
-        ++stencil_ref;
-        pass_shader_uniforms(item.program(), {
-            .color          = item.color(),
-            .light_position = _light.position(),
-            .light_color    = _light.color(),
-            .view           = _camera.view(),
-            .projection     = _camera.projection(),
-            .model          = item.model()
-        }, item);
+        item.id(stencil_ref++);
+
+        auto [meshes, is_new] = _mesh_ranges.try_emplace(item.mesh_path());
+        if (is_new) {
+            for (const auto& vertices : item.vertices()) {
+                meshes->second.push_back(_meshes.add(vertices));
+            }
+        }
+        auto [material, is_new_material] =
+            _materials.try_emplace(item.material());
+        if (is_new_material) {
+            material->second.program = item.program_ref();
+        }
+        _draw_list.push_back({
+            .item     = &item,
+            .material = &material->second,
+            .meshes   = &meshes->second
+        });
+    }
+    if (!_items.empty()) {
+        _meshes.upload();
+    }
+    _is_dirty = false;
+}
+
+
+void Scene::draw() {
+    PROFILE_ZONE("Scene::draw");
+    opengl::GpuZone zone("scene");
+    if (_frame_constants.ubo == 0) {
+        _frame_constants = opengl::frame_uniform_buffer_t::create();
+    }
+    _frame_constants.update(opengl::frame_constants_t::create(_camera,
+                                                              _light));
+    _frame_constants.bind();
+
+    // materials still compiling are skipped until their program resolves
+    opengl::ProgramCompiler::instance().poll();
+    _pixels.poll();
+    if (_is_dirty) { rebuild(); }
+    for (const auto& draw_item : _draw_list) {
+        const ItemDrawData data {
+            .model = draw_item.item->model(),
+            .color = draw_item.item->color()
+        };
+        for (const auto& mesh : *draw_item.meshes) {
+            draw_item.material->batch.push(mesh, data);
+        }
+    }
+    for (auto& [key, material] : _materials) {
+        auto* program = material.program ? material.program->program()
+                                         : nullptr;
+        if (program != nullptr) {
+            material.batch.submit(*program, _meshes.vao());
+        }
+        material.batch.clear();
     }
 }
 
+// Clicks this close to an item still pick it
+static constexpr int PICK_RADIUS = 2;
+
+// Non zero id closest to (x, y), 0 when the region holds none
+static GLuint closest_id(const std::vector<opengl::stencil_idx_t>& ids,
+                         const opengl::pixel_region_t& region, int x, int y) {
+    GLuint out = 0;
+    int best = std::numeric_limits<int>::max();
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (ids[i] == 0) { continue; }
+
+        const int dx = region.x + int(i % region.w) - x;
+        const int dy = region.y + int(i / region.w) - y;
+        if (dx * dx + dy * dy < best) {
+            best = dx * dx + dy * dy;
+            out = ids[i];
+        }
+    }
+    return out;
+}
+
+// Items are drawn one by one with their id as stencil reference, only on
+// click, the per frame pass is a single multi draw and cannot vary the ref.
+// The stencil comes back through _pixels, without waiting for the GPU.
+void Scene::pick(int x, int y, std::function<void(GLuint)> picked) {
+    if (_is_dirty) { rebuild(); }
+
+    const int left = std::max(x - PICK_RADIUS, 0);
+    const int bottom = std::max(y - PICK_RADIUS, 0);
+    const opengl::pixel_region_t region {
+        .x = left,
+        .y = bottom,
+        .w = std::min(x + PICK_RADIUS + 1, width()) - left,
+        .h = std::min(y + PICK_RADIUS + 1, height()) - bottom
+    };
+    if (region.w <= 0 || region.h <= 0) { return picked(0); }
+
+    auto& ctx = opengl::Context::instance();
+    ctx.stencil_op(GL_KEEP, GL_KEEP, GL_REPLACE);
+    ctx.stencil_mask(0xFF);
+    SAFE_CALL(glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE));
+    SAFE_CALL(glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT));
+    for (const auto& draw_item : _draw_list) {
+        auto& item = *draw_item.item;
+        if (item.selection_program() == nullptr) { continue; }
+        ctx.stencil_func(GL_ALWAYS, item.id(), 0xFF);
+        pass_selection_shader_uniforms(item, *draw_item.meshes,
+                                       _meshes.vao(),
+                                       {.model = item.model()});
+    }
+    SAFE_CALL(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+    ctx.stencil_func(GL_ALWAYS, 0, 0xFF);
+
+    _pixels.read_stencil(region, [=](auto&& ids) {
+        picked(closest_id(ids, region, x, y));
+    });
+}
+
 
 bool Scene::activate_index(GLuint index) {
     bool is_activated = false;
@@ -157,8 +278,10 @@ bool Scene::is_any_item_active() const {
 
 void Scene::append(Item3D&& item) {
     _items.push_back(std::move(item));
+    _is_dirty = true;
 }
 
 void Scene::clear() {
     _items.clear();
+    _is_dirty = true;
 }
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <map>
+#include <functional>
+#include <string>
+#include <optional>
+#include <unordered_map>
+
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -7,6 +13,11 @@
 #include <Loader/opengl_converter.hpp>
 #include <OpenGL/camera.hpp>
 #include <OpenGL/light.hpp>
+#include <OpenGL/opengl_program.hpp>
+#include <OpenGL/opengl_program_registry.hpp>
+#include <OpenGL/opengl_frame_constants.hpp>
+#include <OpenGL/opengl_indirect_batch.hpp>
+#include <OpenGL/opengl_pixel_reader.hpp>
 
 
 struct ItemInputData {
@@ -22,6 +33,15 @@ struct ItemInputData {
 };
 
 
+// Camera and light are read from the FrameConstants uniform block, the main
+// program reads model and color from the per draw storage buffer instead
+struct ItemUniforms {
+    opengl::uniform_handle_t model;
+
+    static ItemUniforms create(const opengl::Program& program);
+};
+
+
 class Item3D {
 public:
     static constexpr glm::vec3 SELECTION_SCALE = {1.1, 1.1, 1.1};
@@ -34,13 +54,19 @@ public:
     explicit Item3D(ItemInputData&& data);
     ~Item3D();
 
+    // Vertices stay on the CPU, Scene packs them into its MeshPool
     void open(const std::string& path);
-    void draw() const;
     void modify(glm::mat4&& modificator);
-    void finalyze();
 
     const glm::mat4& model() const { return _model; }
-    GLuint program() const { return _program; }
+    // Programs are shared between items and compile in the background,
+    // nullptr until they are linked
+    opengl::Program* program() const {
+        return _program ? _program->program() : nullptr;
+    }
+    const opengl::program_ref_t& program_ref() const { return _program; }
+    const std::string& material() const { return _material; }
+    const std::string& mesh_path() const { return _mesh_path; }
 
     void color(const glm::vec4& color) { _color = color; }
     const glm::vec4& color() const {
@@ -49,13 +75,19 @@ public:
 
     const std::vector<loader::Vertices>& vertices() const { return _vertices; }
 
-    GLuint selection_program() const { return _selection_program; }
+    opengl::Program* selection_program() const {
+        return _selection_program ? _selection_program->program() : nullptr;
+    }
     const glm::vec4& selection_color() const { return _selection_color; }
+    // Looked up on first use, the selection program has to be linked
+    const ItemUniforms& selection_uniforms() const;
 
     void id(int id) { if (_id == -1) { _id = id; } }
     int id() const { return _id; }
 
-    bool is_valid() const { return _vao != 0 && _program != 0; }
+    bool is_valid() const {
+        return !_vertices.empty() && _program && !_program->is_failed();
+    }
     bool is_active() const { return _is_active; }
 
     bool activate();
@@ -63,44 +95,45 @@ public:
 
 private:
     glm::mat4 _model {1.0};
-    GLuint _vao      {0};
-    GLuint _program  {0};
-    glm::vec4 _color {0.0, 0.0, 0.0, 0.5};
+    opengl::program_ref_t _program {};
+    std::string _material          {};
+    glm::vec4 _color         {0.0, 0.0, 0.0, 0.5};
 
-    GLuint _selection_program  {0};
-    glm::vec4 _selection_color {0.0, 0.0, 0.0, 1.0};
+    opengl::program_ref_t _selection_program {};
+    mutable std::optional<ItemUniforms> _selection_uniforms {};
+    glm::vec4 _selection_color               {0.0, 0.0, 0.0, 1.0};
 
     int _id         {-1};
     bool _is_active {false};
     bool _is_selectable;
 
-    std::vector<opengl::buffers_t> _vertex_input;
     std::vector<loader::Vertices> _vertices;
+    std::string _mesh_path;
 };
 
-struct ShaderUniformData {
-    glm::vec4 color;
-    glm::vec3 light_position;
-    glm::vec4 light_color;
-    glm::mat4 view;
-    glm::mat4 projection;
+struct SelectionShaderUniformData {
     glm::mat4 model;
 };
 
-void pass_shader_uniforms(GLuint program, ShaderUniformData&& data,
-                          const Item3D& item);
+// Draws the meshes of item from the pool VAO with its selection program
+void pass_selection_shader_uniforms(
+    Item3D& item,
+    const std::vector<opengl::mesh_range_t>& meshes,
+    GLuint vao,
+    SelectionShaderUniformData&& data
+);
 
-struct SelectionShaderUniformData {
+// std430 mirror of DrawData in vertex_shader.vert
+struct ItemDrawData {
     glm::mat4 model;
-    glm::mat4 view;
-    glm::mat4 projection;
+    glm::vec4 color;
 };
 
-void pass_selection_shader_uniforms(
-    GLuint program,
-    SelectionShaderUniformData&& data,
-    const Item3D& item
-);
+// Items sharing the shaders are drawn by one multi draw indirect call
+struct Material {
+    opengl::program_ref_t program;
+    opengl::IndirectBatch<ItemDrawData> batch;
+};
 
 class Scene {
 public:
@@ -110,6 +143,8 @@ public:
     ~Scene();
 
     void draw();
+    // picked gets the id a frame or two later, 0 when nothing was hit
+    void pick(int x, int y, std::function<void(GLuint)> picked);
 
     std::vector<Item3D>& items() { return _items; }
     opengl::Camera& camera() { return _camera; }
@@ -126,8 +161,29 @@ public:
 
     const opengl::Camera& camera() const { return _camera; }
 
+private:
+    using mesh_pool_t = opengl::MeshPool<loader::Vertices::value_type>;
+    using mesh_ranges_t = std::vector<opengl::mesh_range_t>;
+
+    struct DrawItem {
+        Item3D* item;
+        Material* material;
+        const mesh_ranges_t* meshes;
+    };
+
+    void rebuild();
+    void release_batches();
+
 private:
     std::vector<Item3D> _items;
     opengl::Light _light;
     opengl::Camera _camera;
+    opengl::frame_uniform_buffer_t _frame_constants;
+
+    mesh_pool_t _meshes;
+    std::unordered_map<std::string, mesh_ranges_t> _mesh_ranges;
+    std::map<std::string, Material> _materials;
+    std::vector<DrawItem> _draw_list;
+    opengl::PixelReader _pixels;
+    bool _is_dirty {true};
 };
@@ -1,3 +1,6 @@
+#include <iostream>
+#include <string_view>
+
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glad/glad.h>
@@ -5,9 +8,15 @@
 
 #include <UI/ui.hpp>
 #include <UI/io.hpp>
+#include <UI/widgets.hpp>
+#include <UI/imgui_widget_render.hpp>
 #include <OpenGL/opengl_proc.hpp>
+#include <OpenGL/opengl_program_cache.hpp>
+#include <OpenGL/opengl_gpu_profiler.hpp>
+#include <OpenGL/opengl_frame_recorder.hpp>
 #include <OpenGL/camera.hpp>
 #include <Loader/opengl_converter.hpp>
+#include <Profiler/profiler.hpp>
 
 #include "io.hpp"
 #include "item.hpp"
@@ -31,32 +40,83 @@ auto create_empty_scene() {
     };
 }
 
-int main() {
+// --capture <dir> writes every frame the encoders keep up with
+static opengl::FrameRecorder create_recorder(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string_view(argv[i]) == "--capture") {
+            return opengl::FrameRecorder::create({.output = argv[i + 1]});
+        }
+    }
+    return {};
+}
+
+int main(int argc, char** argv) {
     if (!ui::init_glfw(4, 6)) { return EXIT_FAILURE; }
 
     auto* window = ui::create_window(WIDTH, HEIGHT, "world");
     ui::io::IO::instance().bind(window);
     opengl::Context::instance().initialize(true);
     opengl::Context::instance().background(background);
+    opengl::ProgramCache::instance().directory("program_cache");
     auto& imgui_io = ui::imgui::init_imgui(window, "#version 460");
 
     GlobalListener g_listener(std::move(create_empty_scene()),
                               &ui::io::IO::instance());
 
     ui::imgui::Context ui_context(g_listener.scene());
+    ui::ImGuiWidgetRender widget_render;
+    auto gpu_window = ui::Window::create(
+        {70, 0}, {30, 30}, "GPU", ImGuiWindowFlags_NoResize,
+        {ui::GpuProfilerView::create({100, 100}, "gpu_zones")}
+    );
 
+    auto recorder = create_recorder(argc, argv);
+
+    PROFILE_THREAD("main");
     while (!glfwWindowShouldClose(window)) {
+        PROFILE_ZONE("frame");
         glfwPollEvents();
         opengl::Context::instance().draw_background();
         ui::imgui::pre_process();
 
         g_listener.scene().draw();
         ui_context.show_main_window();
+        gpu_window->accept(widget_render);
 
-        ui::imgui::render_imgui();
+        {
+            opengl::GpuZone zone("imgui");
+            ui::imgui::render_imgui();
+        }
+        opengl::GpuProfiler::instance().end_frame();
+        opengl::Context::instance().end_frame();
+        if (recorder.is_recording()) {
+            int w = 0, h = 0;
+            glfwGetFramebufferSize(window, &w, &h);
+            recorder.capture({.w = w, .h = h});
+            recorder.poll();
+        }
         glfwSwapBuffers(window);
     }
 
+    const auto& cache = opengl::ProgramCache::instance().stats();
+    std::cout << "program cache: " << cache.hits << " hits ("
+              << cache.load_ms << " ms), " << cache.misses << " misses ("
+              << cache.build_ms << " ms), " << cache.rejected << " rejected"
+              << std::endl;
+
+    if (recorder.is_recording()) {
+        recorder.finish();
+        const auto capture = recorder.stats();
+        std::cout << "capture: " << capture.encoded << " frames, "
+                  << capture.dropped_gpu + capture.dropped_encoder
+                  << " dropped" << std::endl;
+    }
+    recorder.free();
+
+#if RENDER_PROFILE
+    profiler::write_chrome_trace("world_trace.json");
+#endif
+    opengl::GpuProfiler::instance().free();
     ui::imgui::cleanup(window);
     return 0;
 }
@@ -5,14 +5,30 @@ layout (location = 1) in vec3 aNorm;
 
 out vec3 position;
 out vec3 normal;
+flat out vec4 color;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140, binding = 0) uniform FrameConstants {
+    mat4 projection;
+    mat4 view;
+    vec4 light_position;
+    vec4 light_color;
+};
+
+// Per item data of the multi draw, mirrors ItemDrawData in item.hpp
+struct DrawData {
+    mat4 model;
+    vec4 color;
+};
+
+layout (std430, binding = 0) readonly buffer DrawDataBlock {
+    DrawData draws[];
+};
 
 void main() {
+    mat4 model = draws[gl_DrawID].model;
     // note that we read the multiplication from right to left
     gl_Position = projection * view * model * vec4(aPos, 1.0);
     position = vec3(model * vec4(aPos, 1.0));
     normal = aNorm;
+    color = draws[gl_DrawID].color;
 }
@@ -4,11 +4,29 @@
 #include "comands.hpp"
 #include "image_data.hpp"
 #include "image_manager.hpp"
+#include "opengl_frame_constants.hpp"
 #include "opengl_framebuffer_data.hpp"
+#include "opengl_indirect_batch.hpp"
 #include "opengl_instanced_render_data.hpp"
 #include "opengl_proc.hpp"
+#include "opengl_program.hpp"
+#include "opengl_program_cache.hpp"
+#include "opengl_program_compiler.hpp"
+#include "opengl_program_registry.hpp"
+#include "opengl_gpu_profiler.hpp"
+#include "opengl_pixel_reader.hpp"
+#include "opengl_render_target.hpp"
+#include "opengl_frame_graph.hpp"
+#include "opengl_frame_recorder.hpp"
+#include "worker_pool.hpp"
 #include "opengl_render_data.hpp"
+#include "opengl_render_queue.hpp"
+#include "opengl_stream_buffer.hpp"
+#include "opengl_texture_units.hpp"
 #include "opengl_utils.hpp"
 #include "opengl_vertex_input.hpp"
 #include "texture.hpp"
+#include "texture_atlas.hpp"
 #include "texture_manager.hpp"
+#include "texture_mips.hpp"
+#include "texture_compression.hpp"
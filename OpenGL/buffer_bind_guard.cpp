@@ -5,24 +5,27 @@ namespace opengl {
 
 buffer_bind_guard::buffer_bind_guard(vao_bind_command_t&& cmd)
     : mode_(VAO_BINDER)
+    , previous_(Context::instance().bound_vao())
 {
-    SAFE_CALL(glBindVertexArray(cmd.vao))
+    Context::instance().bind_vertex_array(cmd.vao);
 }
 
 buffer_bind_guard::buffer_bind_guard(buff_bind_command_t&& cmd)
     : mode_(VBO_BINDER)
     , buff_type_(cmd.type)
+    , previous_(Context::instance().bound_buffer(cmd.type))
 {
-    SAFE_CALL(glBindBuffer(cmd.type, cmd.id));
+    Context::instance().bind_buffer(cmd.type, cmd.id);
 }
 
 buffer_bind_guard::~buffer_bind_guard() {
     switch (mode_) {
     case VAO_BINDER: {
-        SAFE_CALL(glBindVertexArray(0));
+        Context::instance().bind_vertex_array(previous_);
         break;
     } case VBO_BINDER: {
-        SAFE_CALL(glBindBuffer(buff_type_, 0));
+        Context::instance().bind_buffer(buff_type_, previous_);
+        break;
     } default:;
     }
 }
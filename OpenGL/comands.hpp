@@ -44,6 +44,7 @@ struct texture_activation_command_t final {
     GLuint id;           // texure_id
     GLuint program;
     std::string sampler_name;
+    GLuint sampler {0};  // sampler object, 0 for the texture's parameters
 };
 
 
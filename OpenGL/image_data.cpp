@@ -8,6 +8,8 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
+#include <Profiler/profiler.hpp>
+
 #include "texture.hpp"
 
 
@@ -107,6 +109,7 @@ ImageData ImageData::create(int w,
 }
 
 ImageData ImageData::read(const std::filesystem::path& path) {
+    PROFILE_ZONE("ImageData::read");
     if (!std::filesystem::exists(path)) {
         throw std::runtime_error(
             std::format("No image found {}", path.string())
@@ -223,4 +226,19 @@ void ImageData::dump() const {
     std::cout << std::endl;
 }
 
+uint64_t content_hash(const void* bytes, size_t size, uint64_t seed) {
+    const auto* data = static_cast<const byte_t*>(bytes);
+    for (size_t i = 0; i < size; ++i) {
+        seed = (seed ^ data[i]) * 1099511628211ull;
+    }
+    return seed;
+}
+
+uint64_t content_hash(const ImageData& image, uint64_t seed) {
+    const int32_t header[] = {image.w, image.h, int32_t(image.mode)};
+    seed = content_hash(header, sizeof(header), seed);
+    if (image.data == nullptr) { return seed; }
+    return content_hash(image.data, size_t(image.size()), seed);
+}
+
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 #include <filesystem>
 
 #include <glm/glm.hpp>
@@ -58,4 +59,11 @@ public:
     void dump() const;
 };
 
-}
\ No newline at end of file
+// FNV-1a of the bytes, pass the previous result as seed to hash several
+// buffers as one. Cache keys, not security.
+uint64_t content_hash(const void* bytes, size_t size,
+                      uint64_t seed = 14695981039346656037ull);
+uint64_t content_hash(const ImageData& image,
+                      uint64_t seed = 14695981039346656037ull);
+
+}
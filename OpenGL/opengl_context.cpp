@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <iostream>
 
 #include <glad/glad.h>
@@ -15,23 +18,75 @@ static inline GLint get(GLenum feature) {
     return val;
 }
 
+struct target_binding_t final {
+    GLenum target;
+    GLenum binding;
+};
+
+static constexpr std::array<target_binding_t, 11> TEXTURE_BINDINGS {{
+    {GL_TEXTURE_1D,                   GL_TEXTURE_BINDING_1D},
+    {GL_TEXTURE_2D,                   GL_TEXTURE_BINDING_2D},
+    {GL_TEXTURE_3D,                   GL_TEXTURE_BINDING_3D},
+    {GL_TEXTURE_1D_ARRAY,             GL_TEXTURE_BINDING_1D_ARRAY},
+    {GL_TEXTURE_2D_ARRAY,             GL_TEXTURE_BINDING_2D_ARRAY},
+    {GL_TEXTURE_RECTANGLE,            GL_TEXTURE_BINDING_RECTANGLE},
+    {GL_TEXTURE_CUBE_MAP,             GL_TEXTURE_BINDING_CUBE_MAP},
+    {GL_TEXTURE_CUBE_MAP_ARRAY,       GL_TEXTURE_BINDING_CUBE_MAP_ARRAY},
+    {GL_TEXTURE_BUFFER,               GL_TEXTURE_BINDING_BUFFER},
+    {GL_TEXTURE_2D_MULTISAMPLE,       GL_TEXTURE_BINDING_2D_MULTISAMPLE},
+    {GL_TEXTURE_2D_MULTISAMPLE_ARRAY, GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY}
+}};
+
+// GL_ELEMENT_ARRAY_BUFFER is VAO state and is tracked separately
+static constexpr std::array<target_binding_t, 12> BUFFER_BINDINGS {{
+    {GL_ARRAY_BUFFER,              GL_ARRAY_BUFFER_BINDING},
+    {GL_COPY_READ_BUFFER,          GL_COPY_READ_BUFFER_BINDING},
+    {GL_COPY_WRITE_BUFFER,         GL_COPY_WRITE_BUFFER_BINDING},
+    {GL_DISPATCH_INDIRECT_BUFFER,  GL_DISPATCH_INDIRECT_BUFFER_BINDING},
+    {GL_DRAW_INDIRECT_BUFFER,      GL_DRAW_INDIRECT_BUFFER_BINDING},
+    {GL_PIXEL_PACK_BUFFER,         GL_PIXEL_PACK_BUFFER_BINDING},
+    {GL_PIXEL_UNPACK_BUFFER,       GL_PIXEL_UNPACK_BUFFER_BINDING},
+    {GL_QUERY_BUFFER,              GL_QUERY_BUFFER_BINDING},
+    {GL_SHADER_STORAGE_BUFFER,     GL_SHADER_STORAGE_BUFFER_BINDING},
+    {GL_TEXTURE_BUFFER,            GL_TEXTURE_BUFFER_BINDING},
+    {GL_UNIFORM_BUFFER,            GL_UNIFORM_BUFFER_BINDING},
+    {GL_ATOMIC_COUNTER_BUFFER,     GL_ATOMIC_COUNTER_BUFFER_BINDING}
+}};
+
+template <size_t N>
+static inline int index_of(const std::array<target_binding_t, N>& table,
+                           GLenum target) {
+    for (size_t i = 0; i < N; ++i) {
+        if (table[i].target == target) { return int(i); }
+    }
+    return -1;
+}
+
 Context& Context::instance() {
     static Context self;
     return self;
 }
 
 void Context::initialize(bool to_dump) {
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    initialize(context_api_t {}, to_dump);
+}
+
+void Context::initialize(const context_api_t& api, bool to_dump) {
+    api_ = api;
+    auto load_proc = api_.load_proc ? api_.load_proc
+                                    : (GLADloadproc)glfwGetProcAddress;
+    if (!gladLoadGLLoader(load_proc)) {
         std::cerr << "Failed to initialize GLAD" << std::endl;
         initialized_ = false;
         std::terminate();
     }
-    SAFE_CALL(glDebugMessageCallback(utils::gl_debug_output, nullptr));
+    apply_error_mode();
+    sync_state();
     SAFE_CALL(glEnable(GL_MULTISAMPLE));
-    SAFE_CALL(glEnable(GL_STENCIL_TEST));
-    SAFE_CALL(glEnable(GL_DEPTH_TEST));
-    SAFE_CALL(glEnable(GL_BLEND));
-    SAFE_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+    enable_stencil_test(true);
+    enable_depth_test(true);
+    enable_blend(true);
+    blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     initialized_ = true;
     if (to_dump) { dump(); }
@@ -42,6 +97,7 @@ void Context::initialize_light(bool to_dump) {
         std::cerr << "Failed to initialize GLAD" << std::endl;
         std::terminate();
     }
+    sync_state();
     if (to_dump) { dump(); }
 }
 
@@ -67,8 +123,8 @@ void Context::dump() const {
 #undef PRINT_OPENGL_FEATURE_INTV
 }
 
-void Context::viewport(int width, int height) const {
-    SAFE_CALL(glViewport(0, 0, width, height));
+void Context::viewport(int width, int height) {
+    set_viewport({0, 0, width, height});
 }
 
 void Context::background(const glm::vec4& color) {
@@ -82,7 +138,70 @@ void Context::background(glm::u8vec4 color) {
     _background.a = float(color.a / 255.0f);
 }
 
+void Context::error_mode(ErrorMode mode) {
+#if !RENDER_GL_CHECK_CALLS
+    if (mode == ErrorMode::PER_CALL) {
+        std::cerr << "[Context] per call GL checks are not compiled in, "
+                  << "enable RENDER_GL_CHECK_CALLS. Using the debug callback"
+                  << std::endl;
+        mode = ErrorMode::DEBUG_CALLBACK;
+    }
+#endif
+    error_mode_ = mode;
+    if (initialized_) { apply_error_mode(); }
+}
+
+void Context::apply_error_mode() {
+    const GLint flags = get(GL_CONTEXT_FLAGS);
+    if (flags & GL_CONTEXT_FLAG_NO_ERROR_BIT) {
+        // errors are undefined behaviour in a no error context
+        error_mode_ = ErrorMode::OFF;
+    }
+
+    const bool callback = error_mode_ == ErrorMode::DEBUG_CALLBACK
+                          || error_mode_ == ErrorMode::PER_CALL;
+    if (callback) {
+        glEnable(GL_DEBUG_OUTPUT);
+        if (error_mode_ == ErrorMode::PER_CALL) {
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        } else {
+            glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        }
+        glDebugMessageCallback(utils::gl_debug_output, nullptr);
+        // GpuProfiler zones push and pop a debug group each, every one
+        // raises a notification
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE,
+                              GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr,
+                              GL_FALSE);
+    } else {
+        glDebugMessageCallback(nullptr, nullptr);
+        glDisable(GL_DEBUG_OUTPUT);
+    }
+}
+
+bool Context::check_errors(const char* where) {
+    // bounded, a lost context keeps reporting GL_CONTEXT_LOST
+    static constexpr int MAX_ERRORS = 16;
+
+    bool is_clean = true;
+    for (int i = 0; i < MAX_ERRORS; ++i) {
+        const GLenum error = glGetError();
+        if (error == GL_NO_ERROR) { break; }
+        on_gl_error(error, where, __FILE__, __LINE__);
+        is_clean = false;
+    }
+    return is_clean;
+}
+
+void Context::end_frame() {
+    if (error_mode_ == ErrorMode::PER_FRAME) {
+        check_errors("frame sweep");
+    }
+    ++frame_index_;
+}
+
 bool Context::is_context_active() const {
+    if (api_.is_current) { return api_.is_current(); }
     return glfwGetCurrentContext() != nullptr;
 }
 
@@ -100,23 +219,419 @@ void Context::draw_background() const {
 }
 
 GLint Context::active_program() const {
-    return get(GL_CURRENT_PROGRAM);
+    return state_.program;
 }
 
 GLint Context::bound_vao() const {
-    return get(GL_VERTEX_ARRAY_BINDING);
+    return state_.vao;
 }
 
 GLint Context::bound_texture_2d() const {
-    return get(GL_TEXTURE_BINDING_2D);
+    return bound_texture(state_.active_unit, GL_TEXTURE_2D);
+}
+
+GLint Context::bound_texture_2d_array() const {
+    return bound_texture(state_.active_unit, GL_TEXTURE_2D_ARRAY);
 }
 
 GLint Context::bound_framebuffer() const {
-    return get(GL_FRAMEBUFFER_BINDING);
+    return state_.draw_fbo;
 }
 
-GLint Context::bound_texture_2d_array() const {
-    return get(GL_TEXTURE_BINDING_2D_ARRAY);
+GLint Context::bound_read_framebuffer() const {
+    return state_.read_fbo;
+}
+
+GLint Context::bound_buffer(GLenum target) const {
+    if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        // only VAOs set up behind the cache's back cost a query
+        return state_.ebo == UNKNOWN ? get(GL_ELEMENT_ARRAY_BUFFER_BINDING)
+                                     : state_.ebo;
+    }
+    const int i = index_of(BUFFER_BINDINGS, target);
+    return i < 0 ? 0 : state_.buffers[i];
+}
+
+GLint Context::bound_texture(GLuint unit, GLenum target) const {
+    const int i = index_of(TEXTURE_BINDINGS, target);
+    if (i < 0 || unit >= MAX_TEXTURE_UNITS) { return 0; }
+    return state_.textures[unit][i];
+}
+
+GLuint Context::bound_sampler(GLuint unit) const {
+    return unit < MAX_TEXTURE_UNITS ? state_.samplers[unit] : 0;
+}
+
+
+bool Context::elide(bool redundant) {
+    if (redundant) {
+        ++stats_.elided;
+    } else {
+        ++stats_.issued;
+    }
+    return redundant;
+}
+
+void Context::use_program(GLuint id) {
+    if (elide(state_.program == id)) { return; }
+    SAFE_CALL(glUseProgram(id));
+    state_.program = id;
+}
+
+void Context::bind_vertex_array(GLuint id) {
+    if (elide(state_.vao == id)) { return; }
+    SAFE_CALL(glBindVertexArray(id));
+    state_.vao = id;
+    auto it = element_buffers_.find(id);
+    state_.ebo = it != element_buffers_.end() ? it->second : UNKNOWN;
+}
+
+void Context::vertex_array_element_buffer(GLuint vao, GLuint id) {
+    SAFE_CALL(glVertexArrayElementBuffer(vao, id));
+    ++stats_.issued;
+    element_buffers_[vao] = id;
+    if (state_.vao == vao) { state_.ebo = id; }
+}
+
+void Context::bind_buffer(GLenum target, GLuint id) {
+    if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        if (elide(state_.ebo == id)) { return; }
+        SAFE_CALL(glBindBuffer(target, id));
+        state_.ebo = id;
+        element_buffers_[state_.vao] = id;
+        return;
+    }
+
+    const int i = index_of(BUFFER_BINDINGS, target);
+    if (elide(i >= 0 && state_.buffers[i] == id)) { return; }
+    SAFE_CALL(glBindBuffer(target, id));
+    if (i >= 0) { state_.buffers[i] = id; }
+}
+
+void Context::bind_buffer_base(GLenum target, GLuint index, GLuint id) {
+    indexed_bindings_t* indexed = nullptr;
+    if (index < MAX_INDEXED_BINDINGS) {
+        if (target == GL_UNIFORM_BUFFER) {
+            indexed = &state_.uniform_buffers;
+        } else if (target == GL_SHADER_STORAGE_BUFFER) {
+            indexed = &state_.storage_buffers;
+        }
+    }
+
+    // glBindBufferBase also replaces the generic binding of the target
+    const int i = index_of(BUFFER_BINDINGS, target);
+    const bool redundant = indexed && (*indexed)[index] == id
+                           && i >= 0 && state_.buffers[i] == id;
+    if (elide(redundant)) { return; }
+    SAFE_CALL(glBindBufferBase(target, index, id));
+    if (indexed) { (*indexed)[index] = id; }
+    if (i >= 0) { state_.buffers[i] = id; }
+}
+
+void Context::bind_buffer_range(GLenum target, GLuint index, GLuint id,
+                                GLintptr offset, GLsizeiptr size) {
+    // ranges move every frame, only the generic binding is worth caching
+    SAFE_CALL(glBindBufferRange(target, index, id, offset, size));
+    ++stats_.issued;
+    if (index < MAX_INDEXED_BINDINGS) {
+        if (target == GL_UNIFORM_BUFFER) {
+            state_.uniform_buffers[index] = UNKNOWN;
+        } else if (target == GL_SHADER_STORAGE_BUFFER) {
+            state_.storage_buffers[index] = UNKNOWN;
+        }
+    }
+    const int i = index_of(BUFFER_BINDINGS, target);
+    if (i >= 0) { state_.buffers[i] = id; }
+}
+
+void Context::active_texture(GLuint unit) {
+    assert(unit < MAX_TEXTURE_UNITS);
+    if (elide(state_.active_unit == unit)) { return; }
+    SAFE_CALL(glActiveTexture(GL_TEXTURE0 + unit));
+    state_.active_unit = unit;
+}
+
+void Context::bind_texture(GLenum target, GLuint id) {
+    bind_texture(state_.active_unit, target, id);
+}
+
+void Context::bind_texture(GLuint unit, GLenum target, GLuint id) {
+    assert(unit < MAX_TEXTURE_UNITS);
+    const int i = index_of(TEXTURE_BINDINGS, target);
+    if (elide(i >= 0 && state_.textures[unit][i] == id)) { return; }
+    active_texture(unit);
+    SAFE_CALL(glBindTexture(target, id));
+    if (i >= 0) { state_.textures[unit][i] = id; }
+}
+
+void Context::bind_sampler(GLuint unit, GLuint id) {
+    assert(unit < MAX_TEXTURE_UNITS);
+    if (elide(state_.samplers[unit] == id)) { return; }
+    SAFE_CALL(glBindSampler(unit, id));
+    state_.samplers[unit] = id;
+}
+
+size_t Context::bind_textures(GLuint first,
+                              const texture_binding_t* bindings,
+                              size_t count) {
+    assert(first + count <= MAX_TEXTURE_UNITS);
+    GLuint textures[MAX_TEXTURE_UNITS], samplers[MAX_TEXTURE_UNITS];
+    size_t texture_run = 0, sampler_run = 0, changed = 0;
+
+    // a zero texture unbinds every target of the unit
+    auto texture_differs = [&](GLuint unit, const texture_binding_t& b) {
+        const auto& bound = state_.textures[unit];
+        if (b.texture == 0) {
+            return std::any_of(bound.begin(), bound.end(),
+                               [](GLuint id) { return id != 0; });
+        }
+        const int i = index_of(TEXTURE_BINDINGS, b.target);
+        return i < 0 || bound[i] != b.texture;
+    };
+
+    for (size_t i = 0; i <= count; ++i) {
+        const GLuint unit = first + GLuint(i);
+        const bool is_texture = i < count
+                                && texture_differs(unit, bindings[i]);
+        const bool is_sampler = i < count
+                                && state_.samplers[unit] != bindings[i].sampler;
+        if (is_texture) {
+            textures[texture_run++] = bindings[i].texture;
+            auto& bound = state_.textures[unit];
+            const int t = index_of(TEXTURE_BINDINGS, bindings[i].target);
+            if (bindings[i].texture == 0) {
+                bound.fill(0);
+            } else if (t >= 0) {
+                bound[t] = bindings[i].texture;
+            }
+        } else if (texture_run > 0) {
+            SAFE_CALL(glBindTextures(unit - GLuint(texture_run),
+                                     GLsizei(texture_run), textures));
+            ++stats_.issued;
+            texture_run = 0;
+        }
+        if (is_sampler) {
+            samplers[sampler_run++] = bindings[i].sampler;
+            state_.samplers[unit] = bindings[i].sampler;
+        } else if (sampler_run > 0) {
+            SAFE_CALL(glBindSamplers(unit - GLuint(sampler_run),
+                                     GLsizei(sampler_run), samplers));
+            ++stats_.issued;
+            sampler_run = 0;
+        }
+        if (i == count) { break; }
+        if (is_texture || is_sampler) {
+            ++changed;
+        } else {
+            ++stats_.elided;
+        }
+    }
+    return changed;
+}
+
+void Context::bind_framebuffer(GLenum target, GLuint id) {
+    const bool draw = target == GL_FRAMEBUFFER
+                      || target == GL_DRAW_FRAMEBUFFER;
+    const bool read = target == GL_FRAMEBUFFER
+                      || target == GL_READ_FRAMEBUFFER;
+    const bool redundant = (!draw || state_.draw_fbo == id)
+                           && (!read || state_.read_fbo == id);
+    if (elide(redundant)) { return; }
+    SAFE_CALL(glBindFramebuffer(target, id));
+    if (draw) { state_.draw_fbo = id; }
+    if (read) { state_.read_fbo = id; }
+}
+
+void Context::set_viewport(const glm::ivec4& v) {
+    if (elide(state_.viewport == v)) { return; }
+    SAFE_CALL(glViewport(v.x, v.y, v.z, v.w));
+    state_.viewport = v;
+}
+
+static inline void set_capability(GLenum cap, bool enabled) {
+    if (enabled) {
+        SAFE_CALL(glEnable(cap));
+    } else {
+        SAFE_CALL(glDisable(cap));
+    }
+}
+
+void Context::enable_blend(bool enabled) {
+    if (elide(state_.blend.enabled == enabled)) { return; }
+    set_capability(GL_BLEND, enabled);
+    state_.blend.enabled = enabled;
+}
+
+void Context::blend_func(GLenum src, GLenum dst) {
+    auto& blend = state_.blend;
+    if (elide(blend.src == src && blend.dst == dst)) { return; }
+    SAFE_CALL(glBlendFunc(src, dst));
+    blend.src = src;
+    blend.dst = dst;
+}
+
+void Context::enable_depth_test(bool enabled) {
+    if (elide(state_.depth.enabled == enabled)) { return; }
+    set_capability(GL_DEPTH_TEST, enabled);
+    state_.depth.enabled = enabled;
+}
+
+void Context::depth_func(GLenum func) {
+    if (elide(state_.depth.func == func)) { return; }
+    SAFE_CALL(glDepthFunc(func));
+    state_.depth.func = func;
+}
+
+void Context::depth_mask(bool mask) {
+    if (elide(state_.depth.mask == mask)) { return; }
+    SAFE_CALL(glDepthMask(mask ? GL_TRUE : GL_FALSE));
+    state_.depth.mask = mask;
+}
+
+void Context::enable_stencil_test(bool enabled) {
+    if (elide(state_.stencil.enabled == enabled)) { return; }
+    set_capability(GL_STENCIL_TEST, enabled);
+    state_.stencil.enabled = enabled;
+}
+
+void Context::stencil_func(GLenum func, GLint ref, GLuint mask) {
+    auto& st = state_.stencil;
+    if (elide(st.func == func && st.ref == ref && st.func_mask == mask)) {
+        return;
+    }
+    SAFE_CALL(glStencilFunc(func, ref, mask));
+    st.func = func;
+    st.ref = ref;
+    st.func_mask = mask;
+}
+
+void Context::stencil_op(GLenum s_fail, GLenum dp_fail, GLenum dp_pass) {
+    auto& st = state_.stencil;
+    if (elide(st.s_fail == s_fail && st.dp_fail == dp_fail
+              && st.dp_pass == dp_pass)) {
+        return;
+    }
+    SAFE_CALL(glStencilOp(s_fail, dp_fail, dp_pass));
+    st.s_fail = s_fail;
+    st.dp_fail = dp_fail;
+    st.dp_pass = dp_pass;
+}
+
+void Context::stencil_mask(GLuint mask) {
+    if (elide(state_.stencil.write_mask == mask)) { return; }
+    SAFE_CALL(glStencilMask(mask));
+    state_.stencil.write_mask = mask;
+}
+
+
+void Context::forget_program(GLuint id) {
+    // a deleted program stays current until the next glUseProgram
+    if (id != 0 && state_.program == id) { state_.program = UNKNOWN; }
+}
+
+void Context::forget_vertex_array(GLuint id) {
+    if (id == 0) { return; }
+    element_buffers_.erase(id);
+    if (state_.vao == id) {
+        state_.vao = 0;
+        auto it = element_buffers_.find(0);
+        state_.ebo = it != element_buffers_.end() ? it->second : UNKNOWN;
+    }
+}
+
+void Context::forget_buffer(GLuint id) {
+    if (id == 0) { return; }
+    if (state_.ebo == id) { state_.ebo = 0; }
+    // only the bound VAO lets go of it, the others keep a dead name
+    for (auto& [vao, ebo] : element_buffers_) {
+        if (ebo == id) { ebo = vao == state_.vao ? 0 : UNKNOWN; }
+    }
+    for (auto& buffer : state_.buffers) {
+        if (buffer == id) { buffer = 0; }
+    }
+    for (auto& buffer : state_.uniform_buffers) {
+        if (buffer == id) { buffer = 0; }
+    }
+    for (auto& buffer : state_.storage_buffers) {
+        if (buffer == id) { buffer = 0; }
+    }
+}
+
+void Context::forget_texture(GLuint id) {
+    if (id == 0) { return; }
+    for (auto& unit : state_.textures) {
+        for (auto& texture : unit) {
+            if (texture == id) { texture = 0; }
+        }
+    }
+}
+
+void Context::forget_sampler(GLuint id) {
+    if (id == 0) { return; }
+    for (auto& sampler : state_.samplers) {
+        if (sampler == id) { sampler = 0; }
+    }
+}
+
+void Context::forget_framebuffer(GLuint id) {
+    if (id == 0) { return; }
+    if (state_.draw_fbo == id) { state_.draw_fbo = 0; }
+    if (state_.read_fbo == id) { state_.read_fbo = 0; }
+}
+
+
+void Context::sync_state() {
+    state_t s;
+    s.program = get(GL_CURRENT_PROGRAM);
+    s.vao = get(GL_VERTEX_ARRAY_BINDING);
+    s.ebo = get(GL_ELEMENT_ARRAY_BUFFER_BINDING);
+    s.draw_fbo = get(GL_DRAW_FRAMEBUFFER_BINDING);
+    s.read_fbo = get(GL_READ_FRAMEBUFFER_BINDING);
+    s.active_unit = get(GL_ACTIVE_TEXTURE) - GL_TEXTURE0;
+    SAFE_CALL(glGetIntegerv(GL_VIEWPORT, &s.viewport.x));
+
+    for (size_t i = 0; i < BUFFER_BINDINGS.size(); ++i) {
+        s.buffers[i] = get(BUFFER_BINDINGS[i].binding);
+    }
+    for (GLuint i = 0; i < MAX_INDEXED_BINDINGS; ++i) {
+        GLint ubo = 0, ssbo = 0;
+        SAFE_CALL(glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, i, &ubo));
+        SAFE_CALL(glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, i, &ssbo));
+        s.uniform_buffers[i] = ubo;
+        s.storage_buffers[i] = ssbo;
+    }
+
+    const GLuint units = std::min<GLuint>(
+        MAX_TEXTURE_UNITS, get(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS));
+    for (GLuint unit = 0; unit < units; ++unit) {
+        SAFE_CALL(glActiveTexture(GL_TEXTURE0 + unit));
+        for (size_t i = 0; i < TEXTURE_BINDINGS.size(); ++i) {
+            s.textures[unit][i] = get(TEXTURE_BINDINGS[i].binding);
+        }
+        s.samplers[unit] = get(GL_SAMPLER_BINDING);
+    }
+    SAFE_CALL(glActiveTexture(GL_TEXTURE0 + s.active_unit));
+
+    s.blend.enabled = glIsEnabled(GL_BLEND);
+    s.blend.src = get(GL_BLEND_SRC_RGB);
+    s.blend.dst = get(GL_BLEND_DST_RGB);
+
+    s.depth.enabled = glIsEnabled(GL_DEPTH_TEST);
+    s.depth.func = get(GL_DEPTH_FUNC);
+    s.depth.mask = get(GL_DEPTH_WRITEMASK) != GL_FALSE;
+
+    s.stencil.enabled = glIsEnabled(GL_STENCIL_TEST);
+    s.stencil.func = get(GL_STENCIL_FUNC);
+    s.stencil.ref = get(GL_STENCIL_REF);
+    s.stencil.func_mask = get(GL_STENCIL_VALUE_MASK);
+    s.stencil.s_fail = get(GL_STENCIL_FAIL);
+    s.stencil.dp_fail = get(GL_STENCIL_PASS_DEPTH_FAIL);
+    s.stencil.dp_pass = get(GL_STENCIL_PASS_DEPTH_PASS);
+    s.stencil.write_mask = get(GL_STENCIL_WRITEMASK);
+
+    state_ = s;
+    element_buffers_.clear();
+    element_buffers_[s.vao] = s.ebo;
 }
 
 }
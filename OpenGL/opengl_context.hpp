@@ -1,17 +1,93 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
 
 namespace opengl {
 
+// How GL errors are detected. Per call checks cost a glGetError after every
+// SAFE_CALL and are only compiled in with RENDER_GL_CHECK_CALLS (on in Debug
+// builds), release builds expand SAFE_CALL to the bare call.
+enum class ErrorMode {
+    OFF,            // no checks, the window gets a KHR_no_error context
+    PER_FRAME,      // one glGetError sweep in Context::end_frame()
+    DEBUG_CALLBACK, // KHR_debug messages through gl_debug_output
+    PER_CALL        // glGetError after every SAFE_CALL plus the callback
+};
+
+#if RENDER_GL_CHECK_CALLS
+inline constexpr ErrorMode DEFAULT_ERROR_MODE = ErrorMode::PER_CALL;
+#else
+inline constexpr ErrorMode DEFAULT_ERROR_MODE = ErrorMode::PER_FRAME;
+#endif
+
+struct state_stats_t final {
+    size_t issued {0};  // state calls sent to the driver
+    size_t elided {0};  // redundant calls answered by the cache
+};
+
+struct blend_state_t final {
+    bool enabled {false};
+    GLenum src   {GL_ONE};
+    GLenum dst   {GL_ZERO};
+};
+
+struct depth_state_t final {
+    bool enabled {false};
+    GLenum func  {GL_LESS};
+    bool mask    {true};
+};
+
+struct stencil_state_t final {
+    bool enabled      {false};
+    GLenum func       {GL_ALWAYS};
+    GLint ref         {0};
+    GLuint func_mask  {0xFFFFFFFF};
+    GLenum s_fail     {GL_KEEP};
+    GLenum dp_fail    {GL_KEEP};
+    GLenum dp_pass    {GL_KEEP};
+    GLuint write_mask {0xFFFFFFFF};
+};
+
+// What a texture unit holds, see Context::bind_textures
+struct texture_binding_t final {
+    GLenum target  {GL_TEXTURE_2D};
+    GLuint texture {0};
+    GLuint sampler {0}; // 0 samples with the texture's own parameters
+};
+
+
+// Where the GL entry points come from and how to tell that the context is
+// current. Empty members mean GLFW, headless contexts fill both.
+struct context_api_t final {
+    GLADloadproc load_proc {nullptr};
+    bool (*is_current)()   {nullptr};
+};
+
+
+// Context keeps a CPU side copy of the bindings and fixed function state that
+// the library touches. Binds equal to the cached value are dropped and the
+// queries are answered without a glGet round trip. Code that changes the same
+// state behind the cache's back (raw gl calls, third party renderers that do
+// not restore what they touch) must call sync_state() afterwards.
 class Context {
 public:
+    static constexpr GLuint MAX_TEXTURE_UNITS    = 32;
+    static constexpr GLuint MAX_INDEXED_BINDINGS = 16;
+
     static Context& instance();
 
     void initialize(bool = false);
+    void initialize(const context_api_t& api, bool = false);
     void initialize_light(bool = false);
     void dump() const;
 
-    void viewport(int width, int height) const;
+    void viewport(int width, int height);
     glm::vec4& background() { return _background; }
     void background(const glm::vec4& color);
     void background(glm::u8vec4 color);
@@ -21,18 +97,114 @@ public:
 
     void draw_background() const;
 
+    ErrorMode error_mode() const { return error_mode_; }
+    void error_mode(ErrorMode mode);
+    bool check_errors(const char* where);
+    void end_frame();
+    size_t frame_index() const { return frame_index_; }
+
     GLint active_program() const;
     GLint bound_vao() const;
     GLint bound_texture_2d() const;
     GLint bound_texture_2d_array() const;
     GLint bound_framebuffer() const;
+    GLint bound_read_framebuffer() const;
+    GLint bound_buffer(GLenum target) const;
+    GLint bound_texture(GLuint unit, GLenum target) const;
+    GLuint bound_sampler(GLuint unit) const;
+    GLuint active_texture_unit() const { return state_.active_unit; }
+    const glm::ivec4& current_viewport() const { return state_.viewport; }
+
+    void use_program(GLuint id);
+    void bind_vertex_array(GLuint id);
+    // glVertexArrayElementBuffer, the cache follows the element buffer of
+    // every VAO so binding one needs no query
+    void vertex_array_element_buffer(GLuint vao, GLuint id);
+    void bind_buffer(GLenum target, GLuint id);
+    void bind_buffer_base(GLenum target, GLuint index, GLuint id);
+    void bind_buffer_range(GLenum target, GLuint index, GLuint id,
+                           GLintptr offset, GLsizeiptr size);
+    void active_texture(GLuint unit);
+    void bind_texture(GLenum target, GLuint id);
+    void bind_texture(GLuint unit, GLenum target, GLuint id);
+    void bind_sampler(GLuint unit, GLuint id);
+    // Units first ... first + count - 1 take bindings in order. Only the
+    // runs of units that differ from the cache go out, one glBindTextures
+    // and one glBindSamplers per run, the active unit stays. Returns the
+    // units changed.
+    size_t bind_textures(GLuint first, const texture_binding_t* bindings,
+                         size_t count);
+    void bind_framebuffer(GLenum target, GLuint id);
+    void set_viewport(const glm::ivec4& viewport);
+
+    void enable_blend(bool enabled);
+    void blend_func(GLenum src, GLenum dst);
+    void enable_depth_test(bool enabled);
+    void depth_func(GLenum func);
+    void depth_mask(bool mask);
+    void enable_stencil_test(bool enabled);
+    void stencil_func(GLenum func, GLint ref, GLuint mask);
+    void stencil_op(GLenum s_fail, GLenum dp_fail, GLenum dp_pass);
+    void stencil_mask(GLuint mask);
+
+    const blend_state_t& blend_state() const     { return state_.blend; }
+    const depth_state_t& depth_state() const     { return state_.depth; }
+    const stencil_state_t& stencil_state() const { return state_.stencil; }
+
+    // Deleted objects are unbound by GL, the cache has to follow
+    void forget_program(GLuint id);
+    void forget_vertex_array(GLuint id);
+    void forget_buffer(GLuint id);
+    void forget_texture(GLuint id);
+    void forget_sampler(GLuint id);
+    void forget_framebuffer(GLuint id);
+
+    // Reloads the whole cache with glGet, one stall per call
+    void sync_state();
+
+    const state_stats_t& state_stats() const { return stats_; }
+    void reset_state_stats() { stats_ = {}; }
 
 private:
     Context() = default;
 
+    bool elide(bool redundant);
+    void apply_error_mode();
+
+    static constexpr size_t TEXTURE_TARGETS = 11;
+    static constexpr size_t BUFFER_TARGETS  = 12;
+    static constexpr GLuint UNKNOWN         = 0xFFFFFFFF;
+
+    using unit_bindings_t = std::array<GLuint, TEXTURE_TARGETS>;
+    using indexed_bindings_t = std::array<GLuint, MAX_INDEXED_BINDINGS>;
+
+    struct state_t final {
+        GLuint program   {0};
+        GLuint vao       {0};
+        GLuint ebo       {UNKNOWN}; // part of the VAO, reloaded on VAO change
+        GLuint draw_fbo  {0};
+        GLuint read_fbo  {0};
+        GLuint active_unit {0};
+        glm::ivec4 viewport {0};
+        std::array<GLuint, BUFFER_TARGETS> buffers {};
+        indexed_bindings_t uniform_buffers         {};
+        indexed_bindings_t storage_buffers         {};
+        std::array<unit_bindings_t, MAX_TEXTURE_UNITS> textures {};
+        std::array<GLuint, MAX_TEXTURE_UNITS> samplers          {};
+        blend_state_t blend     {};
+        depth_state_t depth     {};
+        stencil_state_t stencil {};
+    };
+
 private:
     glm::vec4 _background;
+    context_api_t api_ {};
     bool initialized_ = false;
+    ErrorMode error_mode_ = DEFAULT_ERROR_MODE;
+    size_t frame_index_   = 0;
+    state_t state_      {};
+    std::unordered_map<GLuint, GLuint> element_buffers_ {}; // vao -> ebo
+    state_stats_t stats_ {};
 };
 
 }
@@ -0,0 +1,69 @@
+#include <cstring>
+
+#include "opengl_proc.hpp"
+#include "opengl_frame_constants.hpp"
+
+
+namespace opengl {
+
+frame_constants_t frame_constants_t::create(const Camera& camera) {
+    return {
+        .projection = camera.projection(),
+        .view       = camera.view()
+    };
+}
+
+frame_constants_t frame_constants_t::create(const Camera& camera,
+                                            const Light& light) {
+    return {
+        .projection     = camera.projection(),
+        .view           = camera.view(),
+        .light_position = glm::vec4(light.position(), 1.0f),
+        .light_color    = light.color()
+    };
+}
+
+frame_constants_t frame_constants_t::create(const glm::mat4& projection,
+                                            const glm::mat4& view) {
+    return {
+        .projection = projection,
+        .view       = view
+    };
+}
+
+
+frame_uniform_buffer_t frame_uniform_buffer_t::create() {
+    frame_uniform_buffer_t self;
+    SAFE_CALL(glCreateBuffers(1, &self.ubo));
+    SAFE_CALL(glNamedBufferStorage(self.ubo, sizeof(frame_constants_t),
+                                   nullptr, GL_DYNAMIC_STORAGE_BIT));
+    return self;
+}
+
+void frame_uniform_buffer_t::update(const frame_constants_t& constants) {
+    assert(ubo != 0);
+
+    if (is_written &&
+        std::memcmp(&last, &constants, sizeof(frame_constants_t)) == 0) {
+        return;
+    }
+    SAFE_CALL(glNamedBufferSubData(ubo, 0, sizeof(frame_constants_t),
+                                   &constants));
+    last = constants;
+    is_written = true;
+}
+
+void frame_uniform_buffer_t::bind() const {
+    Context::instance().bind_buffer_base(GL_UNIFORM_BUFFER, BINDING, ubo);
+}
+
+void frame_uniform_buffer_t::free() {
+    if (ubo != 0 && Context::instance().is_context_active()) {
+        Context::instance().forget_buffer(ubo);
+        SAFE_CALL(glDeleteBuffers(1, &ubo));
+    }
+    ubo = 0;
+    is_written = false;
+}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+#include "camera.hpp"
+#include "light.hpp"
+
+
+namespace opengl {
+
+// std140 mirror of the block shared by all programs:
+//
+// layout (std140, binding = 0) uniform FrameConstants {
+//     mat4 projection;
+//     mat4 view;
+//     vec4 light_position; // xyz, w unused
+//     vec4 light_color;
+// };
+struct frame_constants_t final {
+    glm::mat4 projection     {1.0};
+    glm::mat4 view           {1.0};
+    glm::vec4 light_position {0.0, 0.0, 0.0, 1.0};
+    glm::vec4 light_color    {0.0, 0.0, 0.0, 0.0};
+
+public:
+    static frame_constants_t create(const Camera& camera);
+    static frame_constants_t create(const Camera& camera, const Light& light);
+    static frame_constants_t create(const glm::mat4& projection,
+                                    const glm::mat4& view);
+};
+static_assert(sizeof(frame_constants_t) == 2 * 64 + 2 * 16,
+              "frame_constants_t must match the std140 layout");
+
+
+struct frame_uniform_buffer_t final {
+    static constexpr GLuint BINDING = 0;
+
+    GLuint ubo {0};
+    frame_constants_t last {};
+    bool is_written        {false};
+
+public:
+    static frame_uniform_buffer_t create();
+
+    void update(const frame_constants_t& constants);
+    void bind() const;
+    void free();
+};
+
+}
@@ -0,0 +1,421 @@
+#include <iostream>
+#include <algorithm>
+
+#include <Profiler/profiler.hpp>
+
+#include "texture.hpp"
+#include "opengl_proc.hpp"
+#include "opengl_frame_graph.hpp"
+
+
+namespace opengl {
+
+bool attachment_desc_t::is_depth() const {
+    return format == GL_DEPTH_COMPONENT || format == GL_DEPTH_STENCIL;
+}
+
+size_t attachment_desc_t::bytes() const {
+    size_t pixel = 4;
+    switch (format) {
+    case GL_RED: pixel = 1; break;
+    case GL_RG:  pixel = 2; break;
+    default: break;
+    }
+    return pixel * size_t(size.x) * size_t(size.y)
+         * size_t(std::max(samples, 1));
+}
+
+
+void FrameGraph::Builder::read(fg_resource_t resource) {
+    graph_.passes_[pass_].reads.push_back(resource.id);
+}
+
+void FrameGraph::Builder::write(fg_resource_t resource) {
+    graph_.passes_[pass_].writes.push_back(resource.id);
+}
+
+void FrameGraph::Builder::side_effect() {
+    graph_.passes_[pass_].has_side_effect = true;
+}
+
+
+GLuint FrameGraph::PassContext::texture(fg_resource_t resource) const {
+    const auto& node = graph_.resources_[resource.id];
+    if (node.resolved != fg_resource_t::NONE) {
+        return graph_.texture_of(node.resolved);
+    }
+    return graph_.texture_of(resource.id);
+}
+
+
+fg_resource_t FrameGraph::create(const std::string& name,
+                                 const attachment_desc_t& desc) {
+    resources_.push_back({.name = name, .desc = desc});
+    is_compiled_ = false;
+    return {uint32_t(resources_.size() - 1)};
+}
+
+fg_resource_t FrameGraph::import(const std::string& name, GLuint texture,
+                                 const attachment_desc_t& desc) {
+    auto out = create(name, desc);
+    resources_[out.id].imported = texture;
+    return out;
+}
+
+void FrameGraph::output(fg_resource_t resource) {
+    resources_[resource.id].is_output = true;
+}
+
+void FrameGraph::add_pass(const std::string& name, const setup_t& setup,
+                          execute_t execute) {
+    passes_.push_back({.name = name, .execute = std::move(execute)});
+    Builder builder(*this, uint32_t(passes_.size() - 1));
+    setup(builder);
+    is_compiled_ = false;
+}
+
+bool FrameGraph::compile() {
+    PROFILE_ZONE("FrameGraph::compile");
+    const auto count = uint32_t(resources_.size());
+    for (const auto& pass : passes_) {
+        for (auto id : pass.reads) {
+            if (id >= count) { return false; }
+        }
+        glm::ivec2 size {0};
+        GLsizei samples = 0;
+        for (auto id : pass.writes) {
+            if (id >= count) { return false; }
+            const auto& desc = resources_[id].desc;
+            // a framebuffer needs one size and one sample count
+            if (samples != 0 && (desc.size != size
+                                 || desc.samples != samples)) {
+                std::cerr << "FrameGraph: pass " << pass.name
+                          << " writes attachments that do not match"
+                          << std::endl;
+                return false;
+            }
+            size = desc.size;
+            samples = desc.samples;
+        }
+    }
+
+    stats_.passes = passes_.size();
+    cull();
+    insert_resolves();
+    assign_slots();
+    is_compiled_ = true;
+    return true;
+}
+
+void FrameGraph::execute() {
+    PROFILE_ZONE("FrameGraph::execute");
+    if (!is_compiled_ && !compile()) { return; }
+
+    for (auto& slot : slots_) { slot.texture = acquire(slot.desc); }
+
+    auto& ctx = Context::instance();
+    const GLuint screen = ctx.bound_framebuffer();
+    const glm::ivec4 screen_viewport = ctx.current_viewport();
+    for (const auto& pass : passes_) {
+        if (!pass.is_alive) { continue; }
+        for (auto id : pass.resolves) { resolve(id); }
+
+        GLuint fbo = 0;
+        glm::ivec2 size {screen_viewport.z, screen_viewport.w};
+        if (pass.writes.empty()) {
+            ctx.bind_framebuffer(GL_FRAMEBUFFER, screen);
+            ctx.set_viewport(screen_viewport);
+        } else {
+            fbo = framebuffer(pass.writes);
+            size = resources_[pass.writes.front()].desc.size;
+            ctx.bind_framebuffer(GL_FRAMEBUFFER, fbo);
+            ctx.set_viewport({0, 0, size.x, size.y});
+        }
+        if (pass.execute) { pass.execute(PassContext(*this, fbo, size)); }
+    }
+    ctx.bind_framebuffer(GL_FRAMEBUFFER, screen);
+    ctx.set_viewport(screen_viewport);
+
+    trim_pool();
+}
+
+void FrameGraph::reset() {
+    resources_.clear();
+    passes_.clear();
+    slots_.clear();
+    stats_.passes = stats_.culled = stats_.resolves = stats_.slots = 0;
+    is_compiled_ = false;
+}
+
+std::vector<std::string> FrameGraph::schedule() const {
+    std::vector<std::string> out;
+    for (const auto& pass : passes_) {
+        if (pass.is_alive) { out.push_back(pass.name); }
+    }
+    return out;
+}
+
+uint32_t FrameGraph::slot(fg_resource_t resource) const {
+    return resources_[resource.id].slot;
+}
+
+void FrameGraph::free() {
+    auto& ctx = Context::instance();
+    if (ctx.is_context_active()) {
+        for (const auto& framebuffer : framebuffers_) {
+            ctx.forget_framebuffer(framebuffer.fbo);
+            SAFE_CALL(glDeleteFramebuffers(1, &framebuffer.fbo));
+        }
+        for (const auto& pooled : pool_) {
+            ctx.forget_texture(pooled.texture);
+            SAFE_CALL(glDeleteTextures(1, &pooled.texture));
+        }
+    }
+    framebuffers_.clear();
+    pool_.clear();
+    reset();
+    stats_ = {};
+}
+
+// Walks backwards from the outputs, a pass lives when a live pass or the
+// caller reads one of its writes
+void FrameGraph::cull() {
+    std::vector<bool> is_needed(resources_.size(), false);
+    for (size_t i = 0; i < resources_.size(); ++i) {
+        is_needed[i] = resources_[i].is_output;
+    }
+
+    stats_.culled = 0;
+    for (auto it = passes_.rbegin(); it != passes_.rend(); ++it) {
+        auto& pass = *it;
+        pass.is_alive = pass.has_side_effect
+            || std::any_of(pass.writes.begin(), pass.writes.end(),
+                           [&is_needed](uint32_t id) {
+                return is_needed[id];
+            });
+        if (!pass.is_alive) {
+            ++stats_.culled;
+            continue;
+        }
+        for (auto id : pass.reads) { is_needed[id] = true; }
+    }
+}
+
+// A multisampled resource is resolved before a pass reads it, unless it
+// was already resolved and nobody wrote it since
+void FrameGraph::insert_resolves() {
+    std::vector<bool> is_resolved(resources_.size(), false);
+    stats_.resolves = 0;
+    for (auto& pass : passes_) {
+        pass.resolves.clear();
+        if (!pass.is_alive) { continue; }
+
+        for (auto id : pass.reads) {
+            if (resources_[id].desc.samples <= 1 || is_resolved[id]) {
+                continue;
+            }
+            if (resources_[id].resolved == fg_resource_t::NONE) {
+                auto desc = resources_[id].desc;
+                desc.samples = 1;
+                const auto twin = create(resources_[id].name + " resolved",
+                                         desc);
+                resources_[id].resolved = twin.id;
+                is_resolved.push_back(false);
+            }
+            pass.resolves.push_back(id);
+            is_resolved[id] = true;
+            ++stats_.resolves;
+        }
+        for (auto id : pass.writes) { is_resolved[id] = false; }
+    }
+}
+
+// Greedy over the passes in order, a resource takes the first slot of its
+// description that is free before the resource's first pass
+void FrameGraph::assign_slots() {
+    const auto end = uint32_t(passes_.size());
+    auto touch = [](resource_node_t& node, uint32_t pass) {
+        node.first = std::min(node.first, pass);
+        node.last = std::max(node.last, pass);
+    };
+
+    for (auto& node : resources_) {
+        node.first = fg_resource_t::NONE;
+        node.last = 0;
+        node.slot = fg_resource_t::NONE;
+    }
+    for (uint32_t i = 0; i < end; ++i) {
+        const auto& pass = passes_[i];
+        if (!pass.is_alive) { continue; }
+        for (auto id : pass.writes) { touch(resources_[id], i); }
+        for (auto id : pass.reads) {
+            touch(resources_[id], i);
+            if (resources_[id].resolved != fg_resource_t::NONE) {
+                touch(resources_[resources_[id].resolved], i);
+            }
+        }
+    }
+
+    slots_.clear();
+    for (uint32_t i = 0; i < end; ++i) {
+        for (auto& node : resources_) {
+            if (node.first != i || node.imported != 0) { continue; }
+            // outputs are read after the last pass
+            const uint32_t last = node.is_output ? end : node.last;
+
+            auto it = std::find_if(slots_.begin(), slots_.end(),
+                                   [&node, i](const slot_t& slot) {
+                return slot.desc == node.desc && slot.free_after < i;
+            });
+            if (it == slots_.end()) {
+                slots_.push_back({.desc = node.desc});
+                it = slots_.end() - 1;
+            }
+            it->free_after = last;
+            node.slot = uint32_t(it - slots_.begin());
+        }
+    }
+    stats_.slots = slots_.size();
+}
+
+GLuint FrameGraph::acquire(const attachment_desc_t& desc) {
+    auto it = std::find_if(pool_.begin(), pool_.end(),
+                           [&desc](const pooled_t& pooled) {
+        return !pooled.is_taken && pooled.desc == desc;
+    });
+    if (it != pool_.end()) {
+        it->is_taken = true;
+        it->idle_frames = 0;
+        return it->texture;
+    }
+
+    pooled_t pooled {.desc = desc, .is_taken = true};
+    if (desc.samples > 1) {
+        pooled.texture = gen_texture(GL_TEXTURE_2D_MULTISAMPLE);
+        SAFE_CALL(glTextureStorage2DMultisample(
+            pooled.texture, desc.samples, sized_internal_format(desc.format),
+            desc.size.x, desc.size.y, GL_TRUE
+        ));
+    } else {
+        const GLenum filter = desc.is_depth() ? GL_NEAREST : GL_LINEAR;
+        texture_data_t texture {
+            .id         = gen_texture(GL_TEXTURE_2D),
+            .target     = GL_TEXTURE_2D,
+            .w          = desc.size.x,
+            .h          = desc.size.y,
+            .format     = desc.format,
+            .type       = GL_UNSIGNED_BYTE,
+            .wrap_s     = GL_CLAMP_TO_EDGE,
+            .wrap_t     = GL_CLAMP_TO_EDGE,
+            .min_filter = filter,
+            .mag_filter = filter
+        };
+        set_texture_meta(nullptr, texture);
+        pooled.texture = texture.id;
+    }
+    pool_.push_back(pooled);
+    return pooled.texture;
+}
+
+void FrameGraph::trim_pool() {
+    auto& ctx = Context::instance();
+    std::vector<GLuint> dropped;
+    std::erase_if(pool_, [&](pooled_t& pooled) {
+        if (!pooled.is_taken && ++pooled.idle_frames > KEEP_FRAMES) {
+            dropped.push_back(pooled.texture);
+            return true;
+        }
+        pooled.is_taken = false;
+        return false;
+    });
+
+    // framebuffers die with any of their textures
+    std::erase_if(framebuffers_, [&](const framebuffer_t& framebuffer) {
+        const bool uses_dropped = std::any_of(
+            framebuffer.attachments.begin(), framebuffer.attachments.end(),
+            [&dropped](GLuint id) {
+                return std::find(dropped.begin(), dropped.end(), id)
+                    != dropped.end();
+            });
+        if (uses_dropped) {
+            ctx.forget_framebuffer(framebuffer.fbo);
+            SAFE_CALL(glDeleteFramebuffers(1, &framebuffer.fbo));
+        }
+        return uses_dropped;
+    });
+    for (auto texture : dropped) {
+        ctx.forget_texture(texture);
+        SAFE_CALL(glDeleteTextures(1, &texture));
+    }
+
+    stats_.textures = pool_.size();
+    stats_.bytes = 0;
+    for (const auto& pooled : pool_) { stats_.bytes += pooled.desc.bytes(); }
+}
+
+// Framebuffers are cached by their attachments, aliasing makes the same
+// combination come back every frame
+GLuint FrameGraph::framebuffer(const std::vector<uint32_t>& resources) {
+    std::vector<GLuint> attachments;
+    for (auto id : resources) { attachments.push_back(texture_of(id)); }
+
+    auto it = std::find_if(framebuffers_.begin(), framebuffers_.end(),
+                           [&attachments](const framebuffer_t& framebuffer) {
+        return framebuffer.attachments == attachments;
+    });
+    if (it != framebuffers_.end()) { return it->fbo; }
+
+    const GLuint fbo = gen_framebuffer();
+    std::vector<GLenum> draw_buffers;
+    for (size_t i = 0; i < resources.size(); ++i) {
+        const auto& desc = resources_[resources[i]].desc;
+        GLenum point = GL_COLOR_ATTACHMENT0 + GLenum(draw_buffers.size());
+        if (desc.format == GL_DEPTH_STENCIL) {
+            point = GL_DEPTH_STENCIL_ATTACHMENT;
+        } else if (desc.format == GL_DEPTH_COMPONENT) {
+            point = GL_DEPTH_ATTACHMENT;
+        } else {
+            draw_buffers.push_back(point);
+        }
+        SAFE_CALL(glNamedFramebufferTexture(fbo, point, attachments[i], 0));
+    }
+    if (draw_buffers.empty()) {
+        SAFE_CALL(glNamedFramebufferDrawBuffer(fbo, GL_NONE));
+        SAFE_CALL(glNamedFramebufferReadBuffer(fbo, GL_NONE));
+    } else {
+        SAFE_CALL(glNamedFramebufferDrawBuffers(fbo,
+                                                GLsizei(draw_buffers.size()),
+                                                draw_buffers.data()));
+    }
+
+    const GLenum status = glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "FrameGraph: incomplete framebuffer " << status
+                  << std::endl;
+    }
+    framebuffers_.push_back({.attachments = attachments, .fbo = fbo});
+    return fbo;
+}
+
+void FrameGraph::resolve(uint32_t resource) {
+    const auto& node = resources_[resource];
+    const GLuint source = framebuffer({resource});
+    const GLuint target = framebuffer({node.resolved});
+    const GLbitfield mask = node.desc.is_depth()
+        ? GL_DEPTH_BUFFER_BIT | (node.desc.format == GL_DEPTH_STENCIL
+                                 ? GL_STENCIL_BUFFER_BIT : 0)
+        : GL_COLOR_BUFFER_BIT;
+    const auto size = node.desc.size;
+    SAFE_CALL(glBlitNamedFramebuffer(source, target, 0, 0, size.x, size.y,
+                                     0, 0, size.x, size.y, mask,
+                                     GL_NEAREST));
+}
+
+GLuint FrameGraph::texture_of(uint32_t resource) const {
+    const auto& node = resources_[resource];
+    if (node.imported != 0) { return node.imported; }
+    if (node.slot == fg_resource_t::NONE) { return 0; }
+    return slots_[node.slot].texture;
+}
+
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+
+namespace opengl {
+
+// What a pass draws into or samples. Transient attachments with equal
+// descriptions share pooled textures.
+struct attachment_desc_t final {
+    GLint format    {GL_RGBA}; // GL_RED ... GL_RGBA, GL_DEPTH_STENCIL
+    glm::ivec2 size {0};
+    GLsizei samples {1};       // above 1, reads go through a resolve
+
+    bool operator==(const attachment_desc_t&) const = default;
+
+    bool is_depth() const;
+    size_t bytes() const;      // estimated, for the stats
+};
+
+// Handle to a graph resource, valid until the next reset()
+struct fg_resource_t final {
+    static constexpr uint32_t NONE = UINT32_MAX;
+    uint32_t id {NONE};
+
+    bool is_valid() const { return id != NONE; }
+};
+
+struct frame_graph_stats_t final {
+    size_t passes   {0}; // declared
+    size_t culled   {0}; // nothing alive read what they wrote
+    size_t resolves {0}; // inserted for multisampled reads
+    size_t slots    {0}; // textures the frame needs after aliasing
+    size_t textures {0}; // pooled textures alive
+    size_t bytes    {0}; // estimated size of the pool
+};
+
+
+// Passes declare what they read and write, the graph orders nothing itself,
+// passes run in declaration order. compile() drops the passes whose writes
+// nobody reads and gives every transient resource a slot; resources of the
+// same description whose lifetimes do not overlap share one. execute()
+// backs the slots with textures pooled across frames and binds a
+// framebuffer made of the pass writes before running it. Multisampled
+// resources are resolved into a single sampled twin before the first pass
+// that reads them.
+//
+// Transient contents are undefined when a pass starts, writers clear them.
+//
+//   graph.reset();
+//   auto scene = graph.create("scene", {.size = size, .samples = 4});
+//   auto depth = graph.create("depth", {.format = GL_DEPTH_STENCIL,
+//                                       .size = size, .samples = 4});
+//   graph.add_pass("scene", [&](auto& pass) {
+//       pass.write(scene);
+//       pass.write(depth);
+//   }, [&](const auto& ctx) { ... });
+//   graph.add_pass("post", [&](auto& pass) {
+//       pass.read(scene);
+//       pass.side_effect();
+//   }, [&](const auto& ctx) { ... ctx.texture(scene) ... });
+//   graph.compile();
+//   graph.execute();
+class FrameGraph final {
+public:
+    // Textures unused for this many frames leave the pool
+    static constexpr size_t KEEP_FRAMES = 3;
+
+    class Builder final {
+    public:
+        void read(fg_resource_t resource);
+        void write(fg_resource_t resource);
+        // Keeps the pass even when nothing reads its writes, e.g. drawing
+        // on screen
+        void side_effect();
+
+    private:
+        friend class FrameGraph;
+        Builder(FrameGraph& graph, uint32_t pass)
+            : graph_(graph), pass_(pass) {}
+
+        FrameGraph& graph_;
+        uint32_t pass_;
+    };
+
+    class PassContext final {
+    public:
+        // Texture to sample, the resolved one for multisampled resources
+        GLuint texture(fg_resource_t resource) const;
+        // 0 for passes without writes
+        GLuint fbo() const { return fbo_; }
+        glm::ivec2 size() const { return size_; }
+
+    private:
+        friend class FrameGraph;
+        PassContext(const FrameGraph& graph, GLuint fbo, glm::ivec2 size)
+            : graph_(graph), fbo_(fbo), size_(size) {}
+
+        const FrameGraph& graph_;
+        GLuint fbo_;
+        glm::ivec2 size_;
+    };
+
+    using setup_t = std::function<void(Builder&)>;
+    using execute_t = std::function<void(const PassContext&)>;
+
+    fg_resource_t create(const std::string& name,
+                         const attachment_desc_t& desc);
+    // Owned elsewhere, never pooled nor aliased
+    fg_resource_t import(const std::string& name, GLuint texture,
+                         const attachment_desc_t& desc);
+    // Read after the graph ran, keeps its writers alive
+    void output(fg_resource_t resource);
+
+    void add_pass(const std::string& name, const setup_t& setup,
+                  execute_t execute);
+
+    // Culls, inserts resolves and assigns slots, false on a bad graph
+    bool compile();
+    void execute();
+    // Forgets passes and resources, the pool stays
+    void reset();
+
+    // Passes left after compile(), in execution order
+    std::vector<std::string> schedule() const;
+    // Slot of a transient resource after compile(), for tests and debugging
+    uint32_t slot(fg_resource_t resource) const;
+    const frame_graph_stats_t& stats() const { return stats_; }
+
+    void free();
+
+private:
+    struct resource_node_t final {
+        std::string name       {};
+        attachment_desc_t desc {};
+        GLuint imported        {0};
+        uint32_t resolved      {fg_resource_t::NONE}; // single sampled twin
+        uint32_t first         {fg_resource_t::NONE}; // passes using it
+        uint32_t last          {0};
+        uint32_t slot          {fg_resource_t::NONE};
+        bool is_output         {false};
+    };
+
+    struct pass_node_t final {
+        std::string name              {};
+        std::vector<uint32_t> reads   {};
+        std::vector<uint32_t> writes  {};
+        std::vector<uint32_t> resolves {}; // multisampled reads
+        execute_t execute             {};
+        bool has_side_effect          {false};
+        bool is_alive                 {false};
+    };
+
+    struct slot_t final {
+        attachment_desc_t desc {};
+        uint32_t free_after    {0};
+        GLuint texture         {0};
+    };
+
+    struct pooled_t final {
+        attachment_desc_t desc {};
+        GLuint texture         {0};
+        size_t idle_frames     {0};
+        bool is_taken          {false};
+    };
+
+    struct framebuffer_t final {
+        std::vector<GLuint> attachments {};
+        GLuint fbo                      {0};
+    };
+
+    void cull();
+    void insert_resolves();
+    void assign_slots();
+    GLuint acquire(const attachment_desc_t& desc);
+    void trim_pool();
+    GLuint framebuffer(const std::vector<uint32_t>& resources);
+    void resolve(uint32_t resource);
+    GLuint texture_of(uint32_t resource) const;
+
+private:
+    std::vector<resource_node_t> resources_   {};
+    std::vector<pass_node_t> passes_          {};
+    std::vector<slot_t> slots_                {};
+    std::vector<pooled_t> pool_               {};
+    std::vector<framebuffer_t> framebuffers_  {};
+    frame_graph_stats_t stats_                {};
+    bool is_compiled_                         {false};
+};
+
+}
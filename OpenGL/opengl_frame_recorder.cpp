@@ -0,0 +1,301 @@
+#include <bit>
+#include <format>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include <Profiler/profiler.hpp>
+
+#include "image_data.hpp"
+#include "opengl_proc.hpp"
+#include "opengl_frame_recorder.hpp"
+
+
+namespace opengl {
+
+static bool is_stream(CaptureFormat format) {
+    return format == CaptureFormat::Y4M || format == CaptureFormat::RGBA;
+}
+
+FrameRecorder FrameRecorder::create(const frame_recorder_config_t& config) {
+    FrameRecorder recorder;
+    recorder.sink_ = std::make_shared<sink_t>();
+    recorder.sink_->config = config;
+
+    std::error_code error;
+    if (is_stream(config.format)) {
+        if (config.output.has_parent_path()) {
+            std::filesystem::create_directories(config.output.parent_path(),
+                                                error);
+        }
+        recorder.sink_->stream.open(config.output, std::ios::binary);
+        if (!recorder.sink_->stream) {
+            std::cerr << "FrameRecorder: unable to open "
+                      << config.output << std::endl;
+            return recorder;
+        }
+    } else {
+        std::filesystem::create_directories(config.output, error);
+        if (error) {
+            std::cerr << "FrameRecorder: unable to create "
+                      << config.output << ": " << error.message()
+                      << std::endl;
+            return recorder;
+        }
+    }
+
+    recorder.workers_ = std::make_unique<WorkerPool>(config.workers,
+                                                     config.max_queued,
+                                                     "encoder");
+    return recorder;
+}
+
+void FrameRecorder::capture(const pixel_region_t& region) {
+    PROFILE_ZONE("FrameRecorder::capture");
+    if (!is_recording() || region.w <= 0 || region.h <= 0) { return; }
+
+    // the slot still holds the frame from RING captures ago
+    auto& slot = ring_[head_];
+    if (slot.fence != nullptr && !harvest(slot, false)) {
+        ++stats_.dropped_gpu;
+        return;
+    }
+
+    const auto bytes = GLsizeiptr(region.count() * sizeof(glm::u8vec4));
+    if (slot.size < bytes) {
+        auto& ctx = Context::instance();
+        if (slot.buffer != 0) {
+            ctx.forget_buffer(slot.buffer);
+            SAFE_CALL(glDeleteBuffers(1, &slot.buffer));
+        }
+        slot.buffer = gen_vertex_buffers();
+        slot.size = GLsizeiptr(std::bit_ceil(size_t(bytes)));
+        SAFE_CALL(glNamedBufferStorage(slot.buffer, slot.size, nullptr,
+                                       GL_MAP_READ_BIT));
+    }
+
+    auto& ctx = Context::instance();
+    ctx.bind_buffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    GLint alignment = 4;
+    SAFE_CALL(glGetIntegerv(GL_PACK_ALIGNMENT, &alignment));
+    SAFE_CALL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    SAFE_CALL(glReadPixels(region.x, region.y, region.w, region.h, GL_RGBA,
+                           GL_UNSIGNED_BYTE, nullptr));
+    SAFE_CALL(glPixelStorei(GL_PACK_ALIGNMENT, alignment));
+    ctx.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.region = region;
+
+    head_ = (head_ + 1) % RING;
+}
+
+void FrameRecorder::capture(const framebuffer_data_t& target) {
+    auto& ctx = Context::instance();
+    const GLuint previous = ctx.bound_read_framebuffer();
+    ctx.bind_framebuffer(GL_READ_FRAMEBUFFER, target.fbo);
+    capture({.w = target.texture.w, .h = target.texture.h});
+    ctx.bind_framebuffer(GL_READ_FRAMEBUFFER, previous);
+}
+
+void FrameRecorder::capture(const render_target_t& target) {
+    auto& ctx = Context::instance();
+    const GLuint previous = ctx.bound_read_framebuffer();
+    ctx.bind_framebuffer(GL_READ_FRAMEBUFFER, target.fbo);
+    SAFE_CALL(glNamedFramebufferReadBuffer(target.fbo,
+                                           GL_COLOR_ATTACHMENT0));
+    capture({.w = target.size.x, .h = target.size.y});
+    ctx.bind_framebuffer(GL_READ_FRAMEBUFFER, previous);
+}
+
+// Oldest slot first, fences signal in submission order
+void FrameRecorder::poll() {
+    for (size_t i = 0; i < RING; ++i) {
+        auto& slot = ring_[(head_ + i) % RING];
+        if (slot.fence == nullptr) { continue; }
+        if (!harvest(slot, false)) { return; }
+    }
+}
+
+void FrameRecorder::finish() {
+    if (!is_recording()) { return; }
+    for (size_t i = 0; i < RING; ++i) {
+        auto& slot = ring_[(head_ + i) % RING];
+        if (slot.fence != nullptr) { harvest(slot, true); }
+    }
+    workers_->wait_idle();
+
+    std::lock_guard lock(sink_->mutex);
+    if (sink_->stream.is_open()) { sink_->stream.flush(); }
+}
+
+frame_recorder_stats_t FrameRecorder::stats() const {
+    auto out = stats_;
+    if (sink_) {
+        std::lock_guard lock(sink_->mutex);
+        out.encoded = sink_->encoded;
+    }
+    return out;
+}
+
+void FrameRecorder::free() {
+    auto& ctx = Context::instance();
+    if (ctx.is_context_active()) {
+        for (auto& slot : ring_) {
+            if (slot.fence != nullptr) {
+                SAFE_CALL(glDeleteSync(slot.fence));
+            }
+            if (slot.buffer != 0) {
+                ctx.forget_buffer(slot.buffer);
+                SAFE_CALL(glDeleteBuffers(1, &slot.buffer));
+            }
+        }
+    }
+    ring_ = {};
+    // joins the encoders once the queued frames are written
+    workers_.reset();
+    sink_.reset();
+}
+
+bool FrameRecorder::harvest(slot_t& slot, bool should_wait) {
+    static constexpr GLuint64 TIMEOUT_NS = 1'000'000;
+
+    GLenum status = GL_TIMEOUT_EXPIRED;
+    do {
+        status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                  should_wait ? TIMEOUT_NS : 0);
+    } while (should_wait && status == GL_TIMEOUT_EXPIRED);
+    if (status == GL_TIMEOUT_EXPIRED) { return false; }
+
+    SAFE_CALL(glDeleteSync(slot.fence));
+    slot.fence = nullptr;
+    if (status == GL_WAIT_FAILED) {
+        std::cerr << "FrameRecorder: glClientWaitSync failed" << std::endl;
+        return true;
+    }
+
+    frame_t frame(slot.region.count());
+    const auto bytes = frame.size() * sizeof(glm::u8vec4);
+    const void* mapped = glMapNamedBufferRange(slot.buffer, 0, bytes,
+                                               GL_MAP_READ_BIT);
+    if (mapped == nullptr) { return true; }
+    std::memcpy(frame.data(), mapped, bytes);
+    SAFE_CALL(glUnmapNamedBuffer(slot.buffer));
+
+    submit(slot.region, std::move(frame));
+    return true;
+}
+
+// Runs on the render thread, the sequence only advances for frames an
+// encoder took, the stream writers wait for it without gaps
+void FrameRecorder::submit(const pixel_region_t& region, frame_t&& frame) {
+    auto& sink = *sink_;
+    if (is_stream(sink.config.format)) {
+        if (sink.width == 0) {
+            sink.width = region.w;
+            sink.height = region.h;
+        } else if (sink.width != region.w || sink.height != region.h) {
+            ++stats_.dropped_size;
+            return;
+        }
+    }
+
+    auto task = [sink = sink_, sequence = sequence_, region,
+                 frame = std::make_shared<frame_t>(std::move(frame))]() {
+        encode(*sink, sequence, region, *frame);
+    };
+    if (!workers_->try_submit(std::move(task))) {
+        ++stats_.dropped_encoder;
+        return;
+    }
+    ++sequence_;
+    ++stats_.captured;
+}
+
+void FrameRecorder::encode(sink_t& sink, uint64_t sequence,
+                           const pixel_region_t& region, frame_t& frame) {
+    PROFILE_ZONE("FrameRecorder::encode");
+    flip_rows(frame, size_t(region.w));
+
+    const auto format = sink.config.format;
+    if (format == CaptureFormat::PNG || format == CaptureFormat::JPG) {
+        auto path = sink.config.output / std::format("frame_{:06}",
+                                                     sequence);
+        bool is_written = false;
+        if (format == CaptureFormat::JPG) {
+            std::vector<glm::u8vec3> rgb;
+            rgb.reserve(frame.size());
+            for (const auto& p : frame) { rgb.emplace_back(p.r, p.g, p.b); }
+            is_written = ImageData::write(
+                path, ImageData::create(region.w, region.h, rgb));
+        } else {
+            is_written = ImageData::write(
+                path, ImageData::create(region.w, region.h, frame));
+        }
+        if (!is_written) {
+            std::cerr << "FrameRecorder: unable to write " << path
+                      << std::endl;
+        }
+        std::lock_guard lock(sink.mutex);
+        ++sink.encoded;
+        return;
+    }
+
+    // the conversion runs in parallel, the writes go out in sequence
+    std::vector<uint8_t> yuv;
+    if (format == CaptureFormat::Y4M) { yuv = rgba_to_yuv444(frame); }
+
+    std::unique_lock lock(sink.mutex);
+    sink.turn.wait(lock, [&sink, sequence]() {
+        return sink.next_write == sequence;
+    });
+    if (format == CaptureFormat::Y4M) {
+        if (sequence == 0) {
+            sink.stream << y4m_header(region.w, region.h, sink.config.fps);
+        }
+        sink.stream << "FRAME\n";
+        sink.stream.write(reinterpret_cast<const char*>(yuv.data()),
+                          std::streamsize(yuv.size()));
+    } else {
+        sink.stream.write(reinterpret_cast<const char*>(frame.data()),
+                          std::streamsize(frame.size() * sizeof(frame[0])));
+    }
+    ++sink.next_write;
+    ++sink.encoded;
+    lock.unlock();
+    sink.turn.notify_all();
+}
+
+
+void flip_rows(std::vector<glm::u8vec4>& pixels, size_t width) {
+    if (width == 0) { return; }
+    const size_t rows = pixels.size() / width;
+    for (size_t top = 0, bottom = rows - 1; top < bottom; ++top, --bottom) {
+        std::swap_ranges(pixels.begin() + top * width,
+                         pixels.begin() + (top + 1) * width,
+                         pixels.begin() + bottom * width);
+    }
+}
+
+std::string y4m_header(int width, int height, int fps) {
+    return std::format("YUV4MPEG2 W{} H{} F{}:1 Ip A1:1 C444\n",
+                       width, height, fps);
+}
+
+std::vector<uint8_t> rgba_to_yuv444(const std::vector<glm::u8vec4>& pixels) {
+    const size_t count = pixels.size();
+    std::vector<uint8_t> out(count * 3);
+    uint8_t* y = out.data();
+    uint8_t* u = y + count;
+    uint8_t* v = u + count;
+    for (size_t i = 0; i < count; ++i) {
+        const int r = pixels[i].r;
+        const int g = pixels[i].g;
+        const int b = pixels[i].b;
+        y[i] = uint8_t(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        u[i] = uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        v[i] = uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+    return out;
+}
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <filesystem>
+#include <condition_variable>
+
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+#include "worker_pool.hpp"
+#include "opengl_pixel_reader.hpp"
+#include "opengl_render_target.hpp"
+#include "opengl_framebuffer_data.hpp"
+
+
+namespace opengl {
+
+enum class CaptureFormat {
+    PNG,  // numbered frame_000000.png files
+    JPG,  // numbered frame_000000.jpg files
+    Y4M,  // one YUV 4:4:4 stream, ffmpeg and most players read it
+    RGBA  // one stream of raw top down RGBA8 frames
+};
+
+struct frame_recorder_config_t final {
+    std::filesystem::path output {}; // directory, or the file for streams
+    CaptureFormat format   {CaptureFormat::PNG};
+    int fps                {30};     // only written into Y4M headers
+    size_t workers         {2};
+    size_t max_queued      {8};      // frames waiting for an encoder
+};
+
+struct frame_recorder_stats_t final {
+    size_t captured        {0}; // frames handed to the encoders
+    size_t encoded         {0};
+    size_t dropped_gpu     {0}; // every ring slot was still in flight
+    size_t dropped_encoder {0}; // the encoder queue was full
+    size_t dropped_size    {0}; // stream frames of another size
+};
+
+
+// Frames are read into a ring of RING pixel pack buffers, each fenced, and
+// mapped only once their fence signalled. The copies go to a WorkerPool that
+// converts and writes them. Memory stays bounded by the ring plus
+// max_queued frames; when either is full the frame is dropped and counted,
+// the render loop never waits for the encoders.
+//
+//   auto recorder = FrameRecorder::create({.output = "capture"});
+//   ... every frame, after drawing ...
+//   recorder.capture(canvas.target());
+//   recorder.poll();
+//   ... at exit ...
+//   recorder.finish();
+class FrameRecorder final {
+public:
+    static constexpr size_t RING = 3;
+
+    static FrameRecorder create(const frame_recorder_config_t& config);
+
+    // Reads from the bound read framebuffer, 0 is the window
+    void capture(const pixel_region_t& region);
+    void capture(const framebuffer_data_t& target);
+    // The drawn size of the first color attachment
+    void capture(const render_target_t& target);
+    // Hands every signalled slot to the encoders
+    void poll();
+    // Blocks until the ring and the encoders are drained
+    void finish();
+
+    bool is_recording() const { return workers_ != nullptr; }
+    frame_recorder_stats_t stats() const;
+
+    void free();
+
+private:
+    using frame_t = std::vector<glm::u8vec4>;
+
+    struct slot_t final {
+        GLuint buffer         {0};
+        GLsizeiptr size       {0};
+        GLsync fence          {nullptr};
+        pixel_region_t region {};
+    };
+
+    // Shared with the encoder tasks
+    struct sink_t final {
+        frame_recorder_config_t config {};
+        std::mutex mutex               {};
+        std::condition_variable turn   {};
+        std::ofstream stream           {};
+        uint64_t next_write            {0};
+        size_t encoded                 {0};
+        GLsizei width                  {0}; // of the stream, set once
+        GLsizei height                 {0};
+    };
+
+    bool harvest(slot_t& slot, bool should_wait);
+    void submit(const pixel_region_t& region, frame_t&& frame);
+    static void encode(sink_t& sink, uint64_t sequence,
+                       const pixel_region_t& region, frame_t& frame);
+
+private:
+    std::array<slot_t, RING> ring_          {};
+    size_t head_                            {0}; // next slot to fill
+    uint64_t sequence_                      {0};
+    std::shared_ptr<sink_t> sink_           {};
+    std::unique_ptr<WorkerPool> workers_    {};
+    frame_recorder_stats_t stats_           {};
+};
+
+
+// Encoder steps, exposed for tests
+void flip_rows(std::vector<glm::u8vec4>& pixels, size_t width);
+std::string y4m_header(int width, int height, int fps);
+// BT.601 limited range, the Y plane followed by U and V
+std::vector<uint8_t> rgba_to_yuv444(const std::vector<glm::u8vec4>& pixels);
+
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "opengl_proc.hpp"
 #include "opengl_context.hpp"
 #include "opengl_framebuffer_data.hpp"
@@ -24,6 +26,14 @@ framebuffer_data_t framebuffer_data_t::create(int width, int height) {
     };
     set_texture_meta(nullptr, self.texture);
     attach_texture(self, self.texture);
+
+    SAFE_CALL(glCreateRenderbuffers(1, &self.depth_stencil));
+    SAFE_CALL(glNamedRenderbufferStorage(self.depth_stencil,
+                                         GL_DEPTH24_STENCIL8, width, height));
+    SAFE_CALL(glNamedFramebufferRenderbuffer(self.fbo,
+                                             GL_DEPTH_STENCIL_ATTACHMENT,
+                                             GL_RENDERBUFFER,
+                                             self.depth_stencil));
     return self;
 }
 
@@ -32,29 +42,56 @@ GLenum framebuffer_data_t::status() const {
     return res;
 }
 
+ImageData framebuffer_data_t::read() const {
+    ImageData out;
+    out.w = texture.w;
+    out.h = texture.h;
+    out.mode = ColorMode::RGBA;
+    if (out.size() <= 0) { return out; }
+
+    out.data = new byte_t[out.size()];
+    GLint alignment = 4;
+    SAFE_CALL(glGetIntegerv(GL_PACK_ALIGNMENT, &alignment));
+    SAFE_CALL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    SAFE_CALL(glGetTextureImage(texture.id, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                                out.size(), out.data));
+    SAFE_CALL(glPixelStorei(GL_PACK_ALIGNMENT, alignment));
+
+    // GL rows start at the bottom
+    const size_t row = size_t(out.w) * 4;
+    for (int y = 0; y < out.h / 2; ++y) {
+        std::swap_ranges(out.data + y * row, out.data + (y + 1) * row,
+                         out.data + (out.h - 1 - y) * row);
+    }
+    return out;
+}
+
 void framebuffer_data_t::free() {
     if (!Context::instance().is_context_active()) { return; }
 
     if (fbo != 0) {
+        Context::instance().forget_framebuffer(fbo);
         SAFE_CALL(glDeleteFramebuffers(1, &fbo));
         fbo = 0;
     }
+    if (depth_stencil != 0) {
+        SAFE_CALL(glDeleteRenderbuffers(1, &depth_stencil));
+        depth_stencil = 0;
+    }
     texture.free();
 }
 
 
 void attach_texture(const framebuffer_data_t& fbuff, const texture_data_t& tex) {
-    SAFE_CALL(glBindFramebuffer(fbuff.target, fbuff.fbo))
-    SAFE_CALL(glFramebufferTexture2D(fbuff.target, fbuff.attachment_point,
-                                     tex.target, tex.id, 0));
-    SAFE_CALL(glBindFramebuffer(fbuff.target, 0));
+    SAFE_CALL(glNamedFramebufferTexture(fbuff.fbo, fbuff.attachment_point,
+                                        tex.id, 0));
 }
 
 
 fbuff_ctx_guard_t::fbuff_ctx_guard_t(const fbuff_render_ctx_t& ctx)
     : ctx_(ctx)
 {
-    SAFE_CALL(glBindFramebuffer(GL_FRAMEBUFFER, ctx.fbo));
+    Context::instance().bind_framebuffer(GL_FRAMEBUFFER, ctx.fbo);
     SAFE_CALL(glClearColor(
         ctx.background.r,
         ctx.background.g,
@@ -62,14 +99,12 @@ fbuff_ctx_guard_t::fbuff_ctx_guard_t(const fbuff_render_ctx_t& ctx)
         ctx.background.a
     ));
     SAFE_CALL(glClear(ctx.clear_bits));
-    SAFE_CALL(glViewport(ctx.viewport.x, ctx.viewport.y,
-                         ctx.viewport.z, ctx.viewport.w));
+    Context::instance().set_viewport(ctx.viewport);
 }
 
 fbuff_ctx_guard_t::~fbuff_ctx_guard_t() {
-    SAFE_CALL(glViewport(ctx_.screen_viewport.x, ctx_.screen_viewport.y,
-                         ctx_.screen_viewport.z, ctx_.screen_viewport.w));
-    SAFE_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    Context::instance().set_viewport(ctx_.screen_viewport);
+    Context::instance().bind_framebuffer(GL_FRAMEBUFFER, 0);
 }
 
 }
\ No newline at end of file
@@ -13,11 +13,15 @@ struct framebuffer_data_t final {
     GLenum attachment_point; // GL_COLOR_ATTACHMENT0 ... GL_COLOR_ATTACHMENT31
     texture_data_t texture;
     GLenum target {GL_FRAMEBUFFER};
+    GLuint depth_stencil {0}; // renderbuffer, made by create()
 
 public:
+    // RGBA8 color texture plus a depth 24 / stencil 8 renderbuffer
     static framebuffer_data_t create(int width, int height);
 
     GLenum status() const;
+    // Color attachment, top row first like the images ImageData reads
+    ImageData read() const;
     void free();
 };
 
@@ -0,0 +1,180 @@
+#include <limits>
+#include <algorithm>
+
+#include "opengl_proc.hpp"
+#include "opengl_gpu_profiler.hpp"
+
+
+namespace opengl {
+
+static constexpr size_t QUERY_BATCH = 16;
+static constexpr double SMOOTHING = 0.1;
+static constexpr double NS_TO_MS = 1.0e-6;
+
+GpuProfiler& GpuProfiler::instance() {
+    static GpuProfiler self;
+    return self;
+}
+
+bool GpuProfiler::begin_zone(std::string_view name) {
+    if (!is_enabled_) { return false; }
+
+    auto& frame = frames_[current_];
+    zone_t zone {
+        .stats = stats_index(name),
+        .begin = acquire_query()
+    };
+    SAFE_CALL(glQueryCounter(zone.begin, GL_TIMESTAMP));
+    SAFE_CALL(glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0,
+                               GLsizei(name.size()), name.data()));
+    open_.push_back(frame.zones.size());
+    frame.zones.push_back(zone);
+    return true;
+}
+
+void GpuProfiler::end_zone() {
+    if (open_.empty()) { return; }
+
+    auto& zone = frames_[current_].zones[open_.back()];
+    zone.end = acquire_query();
+    SAFE_CALL(glQueryCounter(zone.end, GL_TIMESTAMP));
+    SAFE_CALL(glPopDebugGroup());
+    open_.pop_back();
+}
+
+void GpuProfiler::end_frame() {
+    while (!open_.empty()) { end_zone(); }
+
+    // the slot written next holds the frame issued LATENCY - 1 frames ago
+    current_ = (current_ + 1) % LATENCY;
+    auto& oldest = frames_[current_];
+    if (!oldest.zones.empty()) {
+        if (is_available(oldest)) {
+            resolve(oldest);
+        } else {
+            ++dropped_frames_;
+        }
+    }
+    recycle(oldest);
+    is_enabled_ = should_enable_;
+}
+
+void GpuProfiler::reset_stats() {
+    for (auto& zone : zones_) {
+        zone = {.name = zone.name, .path = zone.path, .depth = zone.depth};
+    }
+    frame_ms_ = 0;
+    dropped_frames_ = 0;
+}
+
+void GpuProfiler::free() {
+    for (auto& frame : frames_) { recycle(frame); }
+    if (!pool_.empty() && Context::instance().is_context_active()) {
+        SAFE_CALL(glDeleteQueries(pool_.size(), pool_.data()));
+    }
+    pool_.clear();
+    open_.clear();
+}
+
+GLuint GpuProfiler::acquire_query() {
+    if (pool_.empty()) {
+        pool_.resize(QUERY_BATCH);
+        SAFE_CALL(glCreateQueries(GL_TIMESTAMP, QUERY_BATCH, pool_.data()));
+    }
+    GLuint id = pool_.back();
+    pool_.pop_back();
+    return id;
+}
+
+// New zones are inserted after the last descendant of their parent, so
+// zones_ stays in tree order. Indices held by frames in flight are shifted.
+size_t GpuProfiler::stats_index(std::string_view name) {
+    const auto& frame = frames_[current_];
+    const gpu_zone_stats_t* parent = open_.empty()
+        ? nullptr
+        : &zones_[frame.zones[open_.back()].stats];
+
+    std::string path = parent ? parent->path : std::string();
+    path += '/';
+    path += name;
+    if (auto it = index_.find(path); it != index_.end()) {
+        return it->second;
+    }
+
+    size_t pos = zones_.size();
+    if (parent != nullptr) {
+        pos = size_t(parent - zones_.data()) + 1;
+        while (pos < zones_.size() && zones_[pos].depth > parent->depth) {
+            ++pos;
+        }
+    }
+    const size_t depth = open_.size();
+    for (auto& [_, index] : index_) {
+        if (index >= pos) { ++index; }
+    }
+    for (auto& in_flight : frames_) {
+        for (auto& zone : in_flight.zones) {
+            if (zone.stats >= pos) { ++zone.stats; }
+        }
+    }
+    zones_.insert(zones_.begin() + pos, {
+        .name = std::string(name),
+        .path = path,
+        .depth = depth
+    });
+    index_.emplace(std::move(path), pos);
+    return pos;
+}
+
+bool GpuProfiler::is_available(const frame_t& frame) const {
+    for (const auto& zone : frame.zones) {
+        GLint is_ready = GL_FALSE;
+        SAFE_CALL(glGetQueryObjectiv(zone.end, GL_QUERY_RESULT_AVAILABLE,
+                                     &is_ready));
+        if (is_ready != GL_TRUE) { return false; }
+    }
+    return true;
+}
+
+void GpuProfiler::resolve(frame_t& frame) {
+    frame_sums_.assign(zones_.size(), 0.0);
+    frame_calls_.assign(zones_.size(), 0);
+
+    GLuint64 first = std::numeric_limits<GLuint64>::max();
+    GLuint64 last = 0;
+    for (const auto& zone : frame.zones) {
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        SAFE_CALL(glGetQueryObjectui64v(zone.begin, GL_QUERY_RESULT, &begin));
+        SAFE_CALL(glGetQueryObjectui64v(zone.end, GL_QUERY_RESULT, &end));
+        first = std::min(first, begin);
+        last = std::max(last, end);
+        frame_sums_[zone.stats] += double(end - begin) * NS_TO_MS;
+        ++frame_calls_[zone.stats];
+    }
+    frame_ms_ = double(last - first) * NS_TO_MS;
+
+    for (size_t i = 0; i < zones_.size(); ++i) {
+        if (frame_calls_[i] == 0) { continue; }
+
+        auto& stats = zones_[i];
+        const double ms = frame_sums_[i];
+        stats.avg_ms = stats.frames == 0
+            ? ms
+            : stats.avg_ms + (ms - stats.avg_ms) * SMOOTHING;
+        stats.max_ms = std::max(stats.max_ms, ms);
+        stats.last_ms = ms;
+        stats.calls = frame_calls_[i];
+        ++stats.frames;
+    }
+}
+
+void GpuProfiler::recycle(frame_t& frame) {
+    for (const auto& zone : frame.zones) {
+        pool_.push_back(zone.begin);
+        if (zone.end != 0) { pool_.push_back(zone.end); }
+    }
+    frame.zones.clear();
+}
+
+}
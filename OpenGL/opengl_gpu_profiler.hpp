@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+
+#include <glad/glad.h>
+
+
+namespace opengl {
+
+// Timings of one zone, a zone opened several times in a frame is summed
+struct gpu_zone_stats_t final {
+    std::string name {};
+    std::string path {}; // "/parent/name", unique
+    size_t depth     {0};
+    size_t frames    {0}; // resolved frames the zone was seen in
+    size_t calls     {0}; // zone instances in the last of them
+    double last_ms   {0};
+    double avg_ms    {0}; // exponential moving average
+    double max_ms    {0};
+};
+
+
+// GPU time per zone from GL_TIMESTAMP queries. Zones nest, which
+// GL_TIME_ELAPSED queries can not do, so every zone takes a timestamp when
+// it opens and one when it closes. Zones are also pushed as debug groups and
+// show up by name in RenderDoc or Nsight captures.
+//
+// Queries are pooled and a frame is read back LATENCY - 1 frames after it was
+// issued, by then the GPU is done with it and reading never stalls. A frame
+// that is still not available is dropped instead of waited for.
+//
+//   {
+//       GpuZone zone("scene");
+//       ... draw ...
+//   }
+//   GpuProfiler::instance().end_frame();
+class GpuProfiler final {
+public:
+    static constexpr size_t LATENCY = 3;
+
+    static GpuProfiler& instance();
+
+    // Takes effect with the next end_frame()
+    void is_enabled(bool enabled) { should_enable_ = enabled; }
+    bool is_enabled() const { return is_enabled_; }
+
+    // begin_zone() returns false when nothing was opened
+    bool begin_zone(std::string_view name);
+    void end_zone();
+    void end_frame();
+
+    // In the order the zones were first seen, children after their parent
+    const std::vector<gpu_zone_stats_t>& zones() const { return zones_; }
+    // First zone open to last zone close of the last resolved frame
+    double frame_ms() const { return frame_ms_; }
+    size_t dropped_frames() const { return dropped_frames_; }
+    void reset_stats();
+
+    void free();
+
+private:
+    struct zone_t final {
+        size_t stats  {0}; // index in zones_
+        GLuint begin  {0};
+        GLuint end    {0};
+    };
+
+    struct frame_t final {
+        std::vector<zone_t> zones {};
+    };
+
+    GpuProfiler() = default;
+
+    GLuint acquire_query();
+    size_t stats_index(std::string_view name);
+    bool is_available(const frame_t& frame) const;
+    void resolve(frame_t& frame);
+    void recycle(frame_t& frame);
+
+private:
+    std::array<frame_t, LATENCY> frames_            {};
+    size_t current_                                 {0};
+    std::vector<GLuint> pool_                       {};
+    std::vector<size_t> open_                       {}; // zones of current_
+    std::vector<gpu_zone_stats_t> zones_            {};
+    std::unordered_map<std::string, size_t> index_  {}; // by path
+    std::vector<double> frame_sums_                 {};
+    std::vector<size_t> frame_calls_                {};
+    double frame_ms_                                {0};
+    size_t dropped_frames_                          {0};
+    bool is_enabled_                                {true};
+    bool should_enable_                             {true};
+};
+
+
+// Scoped GpuProfiler zone
+class GpuZone final {
+public:
+    explicit GpuZone(std::string_view name)
+        : is_open_(GpuProfiler::instance().begin_zone(name))
+    {}
+
+    ~GpuZone() {
+        if (is_open_) { GpuProfiler::instance().end_zone(); }
+    }
+
+    GpuZone(const GpuZone&) = delete;
+    GpuZone& operator=(const GpuZone&) = delete;
+
+private:
+    bool is_open_;
+};
+
+}
@@ -0,0 +1,53 @@
+#include <cstring>
+#include <algorithm>
+
+#include "opengl_proc.hpp"
+#include "opengl_indirect_batch.hpp"
+
+
+namespace opengl {
+
+// room for the storage offset alignment between commands and data
+static constexpr size_t ALIGNMENT_SLACK = 256;
+
+bool indirect_buffers_t::upload(const void* command_data,
+                                size_t commands_size,
+                                const void* data, size_t data_size) {
+    const size_t size = commands_size + data_size + ALIGNMENT_SLACK;
+    if (stream.id() == 0 || stream.region_size() < size) {
+        // grow geometrically, resizes stay rare while the batch settles
+        const size_t region = std::max(size, stream.region_size() * 2);
+        stream.free();
+        stream = StreamBuffer::create(region);
+    }
+
+    const auto to = stream.allocate(commands_size, alignof(GLuint));
+    storage = stream.allocate_storage(data_size);
+    if (!to.is_valid() || !storage.is_valid()) { return false; }
+    std::memcpy(to.data, command_data, commands_size);
+    std::memcpy(storage.data, data, data_size);
+    commands = to.offset;
+    return true;
+}
+
+void indirect_buffers_t::free() {
+    stream.free();
+    commands = 0;
+    storage = {};
+}
+
+void multi_draw_indirect(GLenum mode, bool is_indexed, GLsizei draw_count,
+                         GLintptr offset) {
+    assert(Context::instance().active_program() != 0);
+    assert(Context::instance().bound_buffer(GL_DRAW_INDIRECT_BUFFER) != 0);
+
+    const auto* indirect = reinterpret_cast<const void*>(offset);
+    if (is_indexed) {
+        SAFE_CALL(glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, indirect,
+                                              draw_count, 0));
+    } else {
+        SAFE_CALL(glMultiDrawArraysIndirect(mode, indirect, draw_count, 0));
+    }
+}
+
+}
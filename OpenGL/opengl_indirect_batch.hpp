@@ -0,0 +1,215 @@
+#pragma once
+
+#include <vector>
+#include <cassert>
+
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+#include "opengl_proc.hpp"
+#include "opengl_program.hpp"
+#include "opengl_stream_buffer.hpp"
+#include "opengl_vertex_input.hpp"
+
+
+namespace opengl {
+
+// Layouts defined by ARB_draw_indirect
+struct draw_arrays_indirect_t final {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first;
+    GLuint base_instance;
+};
+
+struct draw_elements_indirect_t final {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance;
+};
+
+
+// Part of a MeshPool occupied by one mesh
+struct mesh_range_t final {
+    GLuint first;        // first index, first vertex for array meshes
+    GLuint count;
+    GLint base_vertex {0};
+    bool is_indexed   {false};
+};
+
+
+// Meshes of one vertex format packed into a single VAO so that they can be
+// drawn by one multi draw call. Meshes are collected on the CPU and sent to
+// the GPU once by upload().
+template <vertex_input_c vertex_t>
+class MeshPool final {
+public:
+    mesh_range_t add(const std::vector<vertex_t>& vertices) {
+        assert(vao_ == 0);
+        mesh_range_t range {
+            .first = GLuint(vertices_.size()),
+            .count = GLuint(vertices.size())
+        };
+        vertices_.insert(vertices_.end(), vertices.begin(), vertices.end());
+        return range;
+    }
+
+    mesh_range_t add(const std::vector<vertex_t>& vertices,
+                     const elements_input_t& indices) {
+        assert(vao_ == 0);
+        mesh_range_t range {
+            .first       = GLuint(indices_.size()),
+            .count       = GLuint(indices.size()),
+            .base_vertex = GLint(vertices_.size()),
+            .is_indexed  = true
+        };
+        vertices_.insert(vertices_.end(), vertices.begin(), vertices.end());
+        indices_.insert(indices_.end(), indices.begin(), indices.end());
+        return range;
+    }
+
+    void upload() {
+        assert(vao_ == 0);
+        vao_ = gen_vertex_array();
+        if (indices_.empty()) {
+            vbos_ = vertex_t::gen_buffers(vao_, vertices_);
+        } else {
+            ebo_ = gen_element_buffer();
+            vbos_ = vertex_t::gen_buffers(vao_, vertices_, ebo_, indices_);
+        }
+        vertices_.clear();
+        indices_.clear();
+    }
+
+    GLuint vao() const { return vao_; }
+    bool is_uploaded() const { return vao_ != 0; }
+
+    void free() {
+        if (vao_ != 0 && Context::instance().is_context_active()) {
+            free_vertex_buffers(vbos_);
+            if (ebo_ != 0) { free_element_buffer(ebo_); }
+            free_vertex_array(vao_);
+        }
+        vao_ = 0;
+        ebo_ = 0;
+        vbos_.clear();
+        vertices_.clear();
+        indices_.clear();
+    }
+
+private:
+    std::vector<vertex_t> vertices_ {};
+    elements_input_t indices_       {};
+    GLuint vao_                     {0};
+    GLuint ebo_                     {0};
+    buffers_t vbos_                 {};
+};
+
+
+// Indirect commands and per draw data of one submit, written into the next
+// region of a StreamBuffer so the GPU can still read the earlier ones.
+// The buffer is created again twice as large when a submit outgrows its
+// region.
+struct indirect_buffers_t final {
+    StreamBuffer stream         {};
+    GLintptr commands           {0};  // offset of the last commands
+    stream_allocation_t storage {};   // draw data of the last upload
+
+    bool upload(const void* command_data, size_t commands_size,
+                const void* data, size_t data_size);
+    void free();
+};
+
+// offset is where the commands start in the bound GL_DRAW_INDIRECT_BUFFER
+void multi_draw_indirect(GLenum mode, bool is_indexed, GLsizei draw_count,
+                         GLintptr offset = 0);
+
+
+// Draws sharing a program and a MeshPool collected into one
+// glMultiDraw*Indirect call. draw_data_t is read in the vertex shader as a
+// std430 array indexed by gl_DrawID:
+//
+//   layout (std430, binding = 0) readonly buffer DrawData {
+//       draw_data_t draws[];
+//   };
+//
+// All meshes of a batch have to be either indexed or not.
+template <typename draw_data_t>
+class IndirectBatch final {
+public:
+    static constexpr GLuint STORAGE_BINDING = 0;
+
+    void push(const mesh_range_t& mesh, const draw_data_t& data,
+              GLuint instance_count = 1) {
+        assert(data_.empty() || mesh.is_indexed == is_indexed_);
+        is_indexed_ = mesh.is_indexed;
+        if (mesh.is_indexed) {
+            elements_.push_back({
+                .count          = mesh.count,
+                .instance_count = instance_count,
+                .first_index    = mesh.first,
+                .base_vertex    = mesh.base_vertex,
+                .base_instance  = 0
+            });
+        } else {
+            arrays_.push_back({
+                .count          = mesh.count,
+                .instance_count = instance_count,
+                .first          = mesh.first,
+                .base_instance  = 0
+            });
+        }
+        data_.push_back(data);
+    }
+
+    void submit(const Program& program, GLuint vao,
+                GLenum mode = GL_TRIANGLES) {
+        if (data_.empty() || !program.is_valid()) { return; }
+
+        const bool is_uploaded = is_indexed_
+            ? buffers_.upload(
+                  elements_.data(),
+                  elements_.size() * sizeof(draw_elements_indirect_t),
+                  data_.data(), data_.size() * sizeof(draw_data_t))
+            : buffers_.upload(
+                  arrays_.data(),
+                  arrays_.size() * sizeof(draw_arrays_indirect_t),
+                  data_.data(), data_.size() * sizeof(draw_data_t));
+        if (!is_uploaded) { return; }
+
+        auto& ctx = Context::instance();
+        ctx.use_program(program.id());
+        ctx.bind_vertex_array(vao);
+        ctx.bind_buffer(GL_DRAW_INDIRECT_BUFFER, buffers_.stream.id());
+        buffers_.stream.bind_range(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING,
+                                   buffers_.storage);
+        multi_draw_indirect(mode, is_indexed_, GLsizei(data_.size()),
+                            buffers_.commands);
+        // one region per submit, the fence guards it until it comes round
+        buffers_.stream.end_frame();
+    }
+
+    void clear() {
+        elements_.clear();
+        arrays_.clear();
+        data_.clear();
+    }
+
+    void free() {
+        clear();
+        buffers_.free();
+    }
+
+    size_t size() const { return data_.size(); }
+
+private:
+    std::vector<draw_elements_indirect_t> elements_ {};
+    std::vector<draw_arrays_indirect_t> arrays_     {};
+    std::vector<draw_data_t> data_                  {};
+    indirect_buffers_t buffers_                     {};
+    bool is_indexed_                                {false};
+};
+
+}
@@ -8,6 +8,7 @@ void instant_render_data_t::free() {
     impl.free();
     if (Context::instance().is_context_active()) {
         for (auto& [name, buff_id] : buffers) {
+            Context::instance().forget_buffer(buff_id);
             SAFE_CALL(glDeleteBuffers(1, &buff_id));
         }
     }
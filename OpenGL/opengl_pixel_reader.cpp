@@ -0,0 +1,151 @@
+#include <bit>
+#include <iostream>
+#include <algorithm>
+
+#include "opengl_proc.hpp"
+#include "opengl_pixel_reader.hpp"
+
+
+namespace opengl {
+
+static constexpr size_t MIN_BUFFER_SIZE = 256;
+
+void PixelReader::read_color(const pixel_region_t& region,
+                             callback_t<glm::u8vec4> done) {
+    read<glm::u8vec4>(region, GL_RGBA, GL_UNSIGNED_BYTE, std::move(done));
+}
+
+void PixelReader::read_stencil(const pixel_region_t& region,
+                               callback_t<stencil_idx_t> done) {
+    read<stencil_idx_t>(region, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE,
+                        std::move(done));
+}
+
+void PixelReader::read_depth(const pixel_region_t& region,
+                             callback_t<float> done) {
+    read<float>(region, GL_DEPTH_COMPONENT, GL_FLOAT, std::move(done));
+}
+
+// Requests leave pending_ before their callback runs, which may queue
+// another read
+size_t PixelReader::poll() {
+    // fences signal in submission order, the first unsignalled one ends it
+    size_t done = 0;
+    while (!pending_.empty() && is_signalled(pending_.front(), false)) {
+        auto request = std::move(pending_.front());
+        pending_.erase(pending_.begin());
+        deliver(request);
+        ++done;
+    }
+    return done;
+}
+
+void PixelReader::finish() {
+    while (!pending_.empty()) {
+        auto request = std::move(pending_.front());
+        pending_.erase(pending_.begin());
+        is_signalled(request, true);
+        deliver(request);
+    }
+}
+
+void PixelReader::free() {
+    auto& ctx = Context::instance();
+    if (ctx.is_context_active()) {
+        for (auto& request : pending_) {
+            SAFE_CALL(glDeleteSync(request.fence));
+            free_.push_back(request.buffer);
+        }
+        for (const auto& buffer : free_) {
+            ctx.forget_buffer(buffer.id);
+            SAFE_CALL(glDeleteBuffers(1, &buffer.id));
+        }
+    }
+    pending_.clear();
+    free_.clear();
+}
+
+void PixelReader::issue(const pixel_region_t& region, GLenum format,
+                        GLenum type, size_t pixel_size, deliver_t deliver) {
+    if (region.w <= 0 || region.h <= 0) { return; }
+
+    request_t request {
+        .count = region.count(),
+        .bytes = region.count() * pixel_size,
+        .deliver = std::move(deliver)
+    };
+    request.buffer = acquire(request.bytes);
+
+    auto& ctx = Context::instance();
+    ctx.bind_buffer(GL_PIXEL_PACK_BUFFER, request.buffer.id);
+    // the pack state is global, the caller gets back what it had
+    GLint alignment = 4;
+    SAFE_CALL(glGetIntegerv(GL_PACK_ALIGNMENT, &alignment));
+    SAFE_CALL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    SAFE_CALL(glReadPixels(region.x, region.y, region.w, region.h, format,
+                           type, nullptr));
+    SAFE_CALL(glPixelStorei(GL_PACK_ALIGNMENT, alignment));
+    // a bound pack buffer would swallow every later client memory read
+    ctx.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+    request.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    ++stats_.reads;
+    pending_.push_back(std::move(request));
+}
+
+// Buffers are immutable, a pooled one is reused when it is big enough
+PixelReader::buffer_t PixelReader::acquire(size_t bytes) {
+    auto it = std::find_if(free_.begin(), free_.end(),
+                           [bytes](const buffer_t& buffer) {
+        return size_t(buffer.size) >= bytes;
+    });
+    if (it != free_.end()) {
+        buffer_t out = *it;
+        free_.erase(it);
+        return out;
+    }
+
+    buffer_t out {
+        .id = gen_vertex_buffers(),
+        .size = GLsizeiptr(std::bit_ceil(std::max(bytes, MIN_BUFFER_SIZE)))
+    };
+    SAFE_CALL(glNamedBufferStorage(out.id, out.size, nullptr,
+                                   GL_MAP_READ_BIT));
+    ++stats_.buffers;
+    return out;
+}
+
+bool PixelReader::is_signalled(const request_t& request,
+                               bool should_wait) const {
+    static constexpr GLuint64 TIMEOUT_NS = 1'000'000;
+
+    // the flush makes sure the fence reaches the GPU at all
+    GLenum status = GL_TIMEOUT_EXPIRED;
+    do {
+        status = glClientWaitSync(request.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                  should_wait ? TIMEOUT_NS : 0);
+    } while (should_wait && status == GL_TIMEOUT_EXPIRED);
+
+    if (status == GL_WAIT_FAILED) {
+        std::cerr << "PixelReader: glClientWaitSync failed" << std::endl;
+        return true;
+    }
+    return status != GL_TIMEOUT_EXPIRED;
+}
+
+void PixelReader::deliver(request_t& request) {
+    SAFE_CALL(glDeleteSync(request.fence));
+    request.fence = nullptr;
+
+    const void* mapped = glMapNamedBufferRange(request.buffer.id, 0,
+                                               request.bytes,
+                                               GL_MAP_READ_BIT);
+    if (mapped != nullptr) {
+        request.deliver(static_cast<const std::byte*>(mapped), request.count);
+        SAFE_CALL(glUnmapNamedBuffer(request.buffer.id));
+        ++stats_.completed;
+    }
+    free_.push_back(request.buffer);
+}
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+#include "opengl_render_data.hpp"
+
+
+namespace opengl {
+
+// Window coordinates, origin at the bottom left like glReadPixels
+struct pixel_region_t final {
+    GLint x   {0};
+    GLint y   {0};
+    GLsizei w {1};
+    GLsizei h {1};
+
+    size_t count() const { return size_t(w) * size_t(h); }
+};
+
+struct pixel_reader_stats_t final {
+    size_t reads     {0};
+    size_t completed {0};
+    size_t buffers   {0}; // pixel pack buffers created
+};
+
+
+// glReadPixels into pixel pack buffers instead of client memory. A read only
+// queues the copy on the GPU and fences it, poll() hands the pixels to the
+// callback once the fence signalled, a frame or two later, so the CPU never
+// waits for the frame to finish. Reads come from the bound read framebuffer.
+//
+//   reader.read_stencil({.x = x, .y = y}, [](auto&& ids) { pick(ids[0]); });
+//   ... every frame ...
+//   reader.poll();
+//
+// read_pixel_color() and read_stencil() in opengl_proc.hpp stay the blocking
+// way for the odd read where latency does not matter.
+class PixelReader final {
+public:
+    template <typename T>
+    using callback_t = std::function<void(std::vector<T>&&)>;
+
+    // Rows bottom up, region.w values per row
+    void read_color(const pixel_region_t& region,
+                    callback_t<glm::u8vec4> done);
+    void read_stencil(const pixel_region_t& region,
+                      callback_t<stencil_idx_t> done);
+    void read_depth(const pixel_region_t& region, callback_t<float> done);
+
+    template <typename T>
+    void read(const pixel_region_t& region, GLenum format, GLenum type,
+              callback_t<T> done) {
+        issue(region, format, type, sizeof(T),
+              [done = std::move(done)](const std::byte* data, size_t count) {
+            std::vector<T> out(count);
+            std::memcpy(out.data(), data, count * sizeof(T));
+            done(std::move(out));
+        });
+    }
+
+    // Delivers every read whose fence signalled, returns how many
+    size_t poll();
+    // Blocks until all queued reads are delivered
+    void finish();
+
+    size_t pending() const { return pending_.size(); }
+    const pixel_reader_stats_t& stats() const { return stats_; }
+
+    void free();
+
+private:
+    using deliver_t = std::function<void(const std::byte*, size_t)>;
+
+    struct buffer_t final {
+        GLuint id         {0};
+        GLsizeiptr size   {0};
+    };
+
+    struct request_t final {
+        buffer_t buffer  {};
+        GLsync fence     {nullptr};
+        size_t count     {0};
+        size_t bytes     {0};
+        deliver_t deliver {};
+    };
+
+    void issue(const pixel_region_t& region, GLenum format, GLenum type,
+               size_t pixel_size, deliver_t deliver);
+    buffer_t acquire(size_t bytes);
+    bool is_signalled(const request_t& request, bool should_wait) const;
+    void deliver(request_t& request);
+
+private:
+    std::vector<request_t> pending_ {};
+    std::vector<buffer_t> free_     {};
+    pixel_reader_stats_t stats_     {};
+};
+
+}
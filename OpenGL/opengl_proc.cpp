@@ -69,11 +69,11 @@ void on_gl_error(GLenum error_code, const char* call, const char* file,
 
 
 void viewport(GLsizei w, GLsizei h) {
-    SAFE_CALL(glViewport(0, 0, w, h));
+    Context::instance().set_viewport({0, 0, w, h});
 }
 
 void viewport(GLsizei x, GLsizei y, GLsizei w, GLsizei h) {
-    SAFE_CALL(glViewport(x, y, w, h));
+    Context::instance().set_viewport({x, y, w, h});
 }
 
 void background(const glm::vec4 color, GLbitfield clear_bits) {
@@ -84,104 +84,114 @@ void background(const glm::vec4 color, GLbitfield clear_bits) {
 
 std::vector<GLuint> gen_vertex_array(size_t count) {
     std::vector<GLuint> out(count);
-    SAFE_CALL(glGenVertexArrays(count, out.data()));
+    SAFE_CALL(glCreateVertexArrays(count, out.data()));
     return out;
 }
 
 void free_vertex_array(const std::vector<GLuint>& in) {
+    for (auto id : in) { Context::instance().forget_vertex_array(id); }
     SAFE_CALL(glDeleteVertexArrays(in.size(), in.data()));
 }
 
 GLuint gen_vertex_array() {
     GLuint id;
-    SAFE_CALL(glGenVertexArrays(1, &id));
+    SAFE_CALL(glCreateVertexArrays(1, &id));
     return id;
 }
 
 void free_vertex_array(GLuint id) {
+    Context::instance().forget_vertex_array(id);
     SAFE_CALL(glDeleteVertexArrays(1, &id));
 }
 
 
 std::vector<GLuint> gen_element_buffers(size_t count) {
     std::vector<GLuint> out(count);
-    SAFE_CALL(glGenBuffers(count, out.data()));
+    SAFE_CALL(glCreateBuffers(count, out.data()));
     return out;
 }
 
 GLuint gen_element_buffer() {
     GLuint out;
-    SAFE_CALL(glGenBuffers(1, &out));
+    SAFE_CALL(glCreateBuffers(1, &out));
     return out;
 }
 
 void free_element_buffers(std::vector<GLuint>& in) {
+    for (auto id : in) { Context::instance().forget_buffer(id); }
     SAFE_CALL(glDeleteBuffers(in.size(), in.data()));
     in.clear();
 }
 
 void free_element_buffer(GLuint id) {
+    Context::instance().forget_buffer(id);
     SAFE_CALL(glDeleteBuffers(1, &id));
 }
 
 
 std::vector<GLuint> gen_vertex_buffers(size_t count) {
     std::vector<GLuint> out(count);
-    SAFE_CALL(glGenBuffers(count, out.data()));
+    SAFE_CALL(glCreateBuffers(count, out.data()));
     return out;
 }
 
 GLuint gen_vertex_buffers() {
     GLuint out;
-    SAFE_CALL(glGenBuffers(1, &out));
+    SAFE_CALL(glCreateBuffers(1, &out));
     return out;
 }
 
 void free_vertex_buffers(const std::vector<GLuint>& in) {
+    for (auto id : in) { Context::instance().forget_buffer(id); }
     SAFE_CALL(glDeleteBuffers(in.size(), in.data()));
 }
 
 void free_vertex_buffer(GLuint id) {
+    Context::instance().forget_buffer(id);
     SAFE_CALL(glDeleteBuffers(1, &id));
 }
 
 std::vector<GLuint> gen_pixel_buffers(size_t count) {
     std::vector<GLuint> out(count);
-    SAFE_CALL(glGenBuffers(count, out.data()));
+    SAFE_CALL(glCreateBuffers(count, out.data()));
     return out;
 }
 
 GLuint gen_pixel_buffers() {
     GLuint id;
-    SAFE_CALL(glGenBuffers(1, &id));
+    SAFE_CALL(glCreateBuffers(1, &id));
     return id;
 }
 
 void free_pixel_buffers(const std::vector<GLuint>& in) {
-    SAFE_CALL(glDeleteVertexArrays(in.size(), in.data()));
+    for (auto id : in) { Context::instance().forget_buffer(id); }
+    SAFE_CALL(glDeleteBuffers(in.size(), in.data()));
 }
 
 void free_pixel_buffer(GLuint id) {
-    SAFE_CALL(glDeleteVertexArrays(1, &id));
+    Context::instance().forget_buffer(id);
+    SAFE_CALL(glDeleteBuffers(1, &id));
 }
 
 std::vector<GLuint> gen_framebuffers(size_t count) {
     std::vector<GLuint> out(count);
-    SAFE_CALL(glGenFramebuffers(count, out.data()));
+    SAFE_CALL(glCreateFramebuffers(count, out.data()));
     return out;
 }
 
 GLuint gen_framebuffer() {
     GLuint id;
-    SAFE_CALL(glGenFramebuffers(1, &id));
+    SAFE_CALL(glCreateFramebuffers(1, &id));
     return id;
 }
 
 void free_framebuffers(const std::vector<GLuint>& ids) {
+    for (auto id : ids) { Context::instance().forget_framebuffer(id); }
     SAFE_CALL(glDeleteFramebuffers(ids.size(), ids.data()));
 }
 
 void free_framebuffer(GLuint* id) {
+    Context::instance().forget_framebuffer(*id);
     SAFE_CALL(glDeleteFramebuffers(1, id));
 }
 
@@ -204,11 +214,11 @@ stencil_idx_t read_stencil(GLint x, GLint y) {
 }
 
 void bind_vao(GLuint id) {
-    SAFE_CALL(glBindVertexArray(id));
+    Context::instance().bind_vertex_array(id);
 }
 
 void bind_fbo(GLuint id) {
-    SAFE_CALL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+    Context::instance().bind_framebuffer(GL_FRAMEBUFFER, id);
 }
 
 static std::string gl_enum_to_string(GLenum e) {
@@ -277,8 +287,7 @@ static std::string gl_enum_to_string(GLenum e) {
 
 GLuint gen_texture(GLenum target) {
     GLuint tex;
-    SAFE_CALL(glGenTextures(1, &tex));
-    SAFE_CALL(glBindTexture(target, tex));
+    SAFE_CALL(glCreateTextures(target, 1, &tex));
     return tex;
 }
 
@@ -290,23 +299,30 @@ void dump_image_part(byte_t* data, GLsizei stride) {
 }
 
 void activate_texture(const texture_activation_command_t& cmd) {
-    SAFE_CALL(glActiveTexture(cmd.tex_unit));
-    SAFE_CALL(glBindTexture(cmd.sampler_type, cmd.id));
-    set_int(cmd.program, cmd.sampler_name, 0);
+    const GLuint unit = cmd.tex_unit - GL_TEXTURE0;
+    const texture_binding_t binding {
+        .target  = cmd.sampler_type,
+        .texture = cmd.id,
+        .sampler = cmd.sampler
+    };
+    Context::instance().bind_textures(unit, &binding, 1);
+    set_int(cmd.program, cmd.sampler_name, GLint(unit));
 }
 
 
 void free_texture(GLuint id) {
+    Context::instance().forget_texture(id);
     SAFE_CALL(glDeleteTextures(1, &id));
 }
 
 void apply_stencil(stencil_command_t&& cmd) {
-    SAFE_CALL(glStencilOp(cmd.s_fail, cmd.dp_fail, cmd.dp_pass));
-    SAFE_CALL(glStencilFunc(cmd.function, cmd.ref, cmd.mask));
+    auto& ctx = Context::instance();
+    ctx.stencil_op(cmd.s_fail, cmd.dp_fail, cmd.dp_pass);
+    ctx.stencil_func(cmd.function, cmd.ref, cmd.mask);
 }
 
 void use(GLuint id) {
-    SAFE_CALL(glUseProgram(id));
+    Context::instance().use_program(id);
 }
 
 
@@ -315,7 +331,6 @@ void draw(const draw_array_command_t& cmd) {
     assert(opengl::Context::instance().active_program() != 0);
     bind_vao(cmd.vao);
     SAFE_CALL(glDrawArrays(cmd.mode, cmd.first, cmd.count));
-    bind_vao(0);
 }
 
 void draw(const draw_elements_command_t& cmd) {
@@ -324,22 +339,19 @@ void draw(const draw_elements_command_t& cmd) {
 
     bind_vao(cmd.vao);
     SAFE_CALL(glDrawElements(cmd.mode, cmd.count, cmd.type, cmd.indices));
-    bind_vao(0);
 }
 
 void draw_array_framebuffer(const draw_array_fbuff_t& cmd) {
-    SAFE_CALL(glBindFramebuffer(GL_FRAMEBUFFER, cmd.fbo));
+    auto& ctx = Context::instance();
+    ctx.bind_framebuffer(GL_FRAMEBUFFER, cmd.fbo);
     SAFE_CALL(glClearColor(cmd.background.r, cmd.background.g,
                            cmd.background.b, cmd.background.a));
     SAFE_CALL(glClear(cmd.clear_bits));
     bind_vao(cmd.vao);
-    const auto& fbuff_v = cmd.viewport;
-    SAFE_CALL(glViewport(fbuff_v.x, fbuff_v.y, fbuff_v.z, fbuff_v.w));
+    ctx.set_viewport(cmd.viewport);
     SAFE_CALL(glDrawArrays(cmd.mode, cmd.first, cmd.count));
-    bind_vao(0);
-    SAFE_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
-    const auto& screen_v = cmd.screen_viewport;
-    SAFE_CALL(glViewport(screen_v.x, screen_v.y, screen_v.z, screen_v.w));
+    ctx.bind_framebuffer(GL_FRAMEBUFFER, 0);
+    ctx.set_viewport(cmd.screen_viewport);
 }
 
 void draw_instance_array(const draw_array_instanced_t& cmd) {
@@ -349,7 +361,6 @@ void draw_instance_array(const draw_array_instanced_t& cmd) {
     bind_vao(cmd.vao);
     SAFE_CALL(glDrawArraysInstanced(cmd.mode, cmd.first, cmd.count,
                                     cmd.instancecount));
-    bind_vao(0);
 }
 
 void draw_instance_elements(const draw_elements_instanced_t& cmd) {
@@ -359,7 +370,6 @@ void draw_instance_elements(const draw_elements_instanced_t& cmd) {
     bind_vao(cmd.vao);
     SAFE_CALL(glDrawElementsInstanced(cmd.mode, cmd.count, cmd.type,
                                       cmd.indices, cmd.instancecount));
-    bind_vao(0);
 }
 
 static int find_location(GLuint id, const std::string_view name) {
@@ -397,7 +407,7 @@ bool set_mat4(GLuint id, const std::string_view name, const glm::mat4& val) {
     return true;
 }
 
-bool set_vec2(GLuint id, const std::string_view name, glm::vec2& val) {
+bool set_vec2(GLuint id, const std::string_view name, const glm::vec2& val) {
     assert(Context::instance().active_program() > 0);
     auto loc = find_location(id, name);
     if (loc < 0) return false;
@@ -492,20 +502,27 @@ ShaderProgramInterface get_program_interface(GLuint program) {
     SAFE_CALL(glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES,
                                       &intf.uniforms_count));
 
-    // Loop through all active uniforms and print their names and types
+    // Loop through all active uniforms and collect names, types and locations
     for (GLint i = 0; i < intf.uniforms_count; i++) {
-        GLenum properties[] = {GL_NAME_LENGTH, GL_TYPE};
-        GLint values[2];
-        SAFE_CALL(glGetProgramResourceiv(program, GL_UNIFORM, i, 2, properties,
-                                         2, NULL, values));
+        GLenum properties[] = {GL_NAME_LENGTH, GL_TYPE, GL_LOCATION,
+                               GL_ARRAY_SIZE};
+        GLint values[4];
+        SAFE_CALL(glGetProgramResourceiv(program, GL_UNIFORM, i, 4, properties,
+                                         4, NULL, values));
 
         GLint len = values[0];
         GLint type = values[1];
+        GLint location = values[2];
 
         char* name = new char[len];
         SAFE_CALL(glGetProgramResourceName(program, GL_UNIFORM, i, len, NULL,
                                            name));
         intf.uniform_block.insert({std::string(name), type});
+        // members of uniform blocks have no location
+        if (location >= 0) {
+            intf.uniform_location.insert({std::string(name), location});
+            intf.uniform_size.insert({std::string(name), values[3]});
+        }
         delete[] name;
     }
 
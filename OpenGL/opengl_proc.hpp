@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 #include <filesystem>
 #include <string_view>
 #include <string>
@@ -20,9 +21,17 @@ using stencil_idx_t = GLubyte;
 
 void on_gl_error(GLenum error_code, const char* call, const char* file,
                  int line);
+#if RENDER_GL_CHECK_CALLS
 #define SAFE_CALL(gl_call)\
     gl_call;\
-    opengl::on_gl_error(glGetError(), #gl_call, __FILE__, __LINE__);
+    if (opengl::Context::instance().error_mode()\
+        == opengl::ErrorMode::PER_CALL) {\
+        opengl::on_gl_error(glGetError(), #gl_call, __FILE__, __LINE__);\
+    }
+#else
+#define SAFE_CALL(gl_call)\
+    gl_call;
+#endif
 
 bool check_shader(GLuint id);
 bool check_program(GLuint id);
@@ -66,12 +75,37 @@ T read_pixel(GLint x, GLint y, GLenum t, GLenum f, T* d) {
 glm::u8vec4 read_pixel_color(GLint x, GLint y);
 stencil_idx_t read_stencil(GLint x, GLint y);
 
+// Direct state access uploads, nothing gets bound. The storage is immutable,
+// flags are those of glNamedBufferStorage, GL_DYNAMIC_STORAGE_BIT allows
+// later glNamedBufferSubData updates.
+template <typename T>
+inline void buffer_storage(GLuint id, const std::vector<T>& in,
+                           GLbitfield flags = 0) {
+    if (in.empty()) { return; }
+    SAFE_CALL(glNamedBufferStorage(id, in.size() * sizeof(T), in.data(),
+                                   flags));
+}
+
+// Attribute formats of the commands, all sourced from the buffer attached
+// to binding of the VAO with glVertexArrayVertexBuffer
+template <typename Iterable>
+inline void vertex_array_attribs(GLuint vao, GLuint binding,
+                                 Iterable&& commands) {
+    for (const auto& cmd : commands) {
+        const auto offset = GLuint(reinterpret_cast<uintptr_t>(cmd.offset));
+        SAFE_CALL(glEnableVertexArrayAttrib(vao, cmd.index));
+        SAFE_CALL(glVertexArrayAttribFormat(vao, cmd.index, cmd.stride,
+                                            GL_FLOAT, GL_FALSE, offset));
+        SAFE_CALL(glVertexArrayAttribBinding(vao, cmd.index, binding));
+    }
+}
+
 template <typename T>
 inline void bind_vbo(GLuint id, const std::vector<T>& in) {
     assert(Context::instance().bound_vao() > 0);
     const T* data = in.data();
     const size_t width = in.size() * sizeof (T);
-    SAFE_CALL(glBindBuffer(GL_ARRAY_BUFFER, id));
+    Context::instance().bind_buffer(GL_ARRAY_BUFFER, id);
     SAFE_CALL(glBufferData(GL_ARRAY_BUFFER, width, data, GL_STATIC_DRAW));
 }
 
@@ -79,7 +113,7 @@ inline void bind_ebo(GLuint id, const std::vector<GLuint>& in) {
     assert(Context::instance().bound_vao() > 0);
     const auto* data = in.data();
     const size_t width = in.size() * sizeof(GLuint);
-    SAFE_CALL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id));
+    Context::instance().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, id);
     SAFE_CALL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, width, data, GL_STATIC_DRAW));
 }
 
@@ -87,7 +121,7 @@ template <typename T>
 inline void bind_pbo(GLuint id, const std::vector<T>& in) {
     const T* data = in.data();
     const size_t width = in.size() * sizeof (T);
-    SAFE_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, id));
+    Context::instance().bind_buffer(GL_PIXEL_UNPACK_BUFFER_ARB, id);
     SAFE_CALL(glBufferData(GL_PIXEL_UNPACK_BUFFER_ARB, width, data,
                            GL_DYNAMIC_DRAW));
 }
@@ -138,6 +172,8 @@ bool set_float(GLuint id, const std::string_view name, GLfloat value);
 struct ShaderProgramInterface final {
     GLint uniforms_count = 0;
     std::unordered_map<std::string, GLenum> uniform_block;
+    std::unordered_map<std::string, GLint> uniform_location;
+    std::unordered_map<std::string, GLint> uniform_size; // array elements
     GLint input_count = 0;
     std::unordered_map<std::string, GLenum> input_block;
 
@@ -148,14 +184,21 @@ std::ostream& operator << (std::ostream& os, const ShaderProgramInterface& i);
 
 ShaderProgramInterface get_program_interface(GLuint program);
 
+// Guards restore the binding they found, with the state cache in Context
+// nesting them or leaving the same object bound costs no GL calls
 struct program_bind_guard_t final {
-    program_bind_guard_t(GLuint id) { opengl::use(id); }
-    ~program_bind_guard_t()         { opengl::use(0); }
+    program_bind_guard_t(GLuint id)
+        : previous_(Context::instance().active_program())
+    { opengl::use(id); }
+    ~program_bind_guard_t() { opengl::use(previous_); }
 
     program_bind_guard_t(const program_bind_guard_t&)              = delete;
     program_bind_guard_t& operator = (const program_bind_guard_t&) = delete;
     program_bind_guard_t(program_bind_guard_t&&)                   = delete;
     program_bind_guard_t& operator = (program_bind_guard_t&&)      = delete;
+
+private:
+    GLuint previous_;
 };
 
 struct buffer_bind_guard final {
@@ -175,6 +218,7 @@ private:
         VBO_BINDER
     } mode_;
     GLenum buff_type_ = 0;
+    GLuint previous_  = 0;
 };
 
 }
@@ -0,0 +1,259 @@
+#include <string>
+#include <vector>
+#include <numeric>
+#include <iostream>
+#include <utility>
+#include <algorithm>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "opengl_proc.hpp"
+#include "opengl_render_data.hpp"
+#include "opengl_program.hpp"
+
+
+namespace opengl {
+
+static std::string normalize_uniform_name(const std::string& name) {
+    static constexpr std::string_view ARRAY_SUFFIX = "[0]";
+
+    if (name.ends_with(ARRAY_SUFFIX)) {
+        return name.substr(0, name.size() - ARRAY_SUFFIX.size());
+    }
+    return name;
+}
+
+bool is_sampler_type(GLenum type) {
+    static constexpr GLenum SAMPLERS[] = {
+        GL_SAMPLER_1D, GL_SAMPLER_2D, GL_SAMPLER_3D, GL_SAMPLER_CUBE,
+        GL_SAMPLER_1D_SHADOW, GL_SAMPLER_2D_SHADOW, GL_SAMPLER_1D_ARRAY,
+        GL_SAMPLER_2D_ARRAY, GL_SAMPLER_1D_ARRAY_SHADOW,
+        GL_SAMPLER_2D_ARRAY_SHADOW, GL_SAMPLER_2D_MULTISAMPLE,
+        GL_SAMPLER_2D_MULTISAMPLE_ARRAY, GL_SAMPLER_CUBE_SHADOW,
+        GL_SAMPLER_BUFFER, GL_SAMPLER_2D_RECT, GL_SAMPLER_2D_RECT_SHADOW,
+        GL_SAMPLER_CUBE_MAP_ARRAY, GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW,
+        GL_INT_SAMPLER_1D, GL_INT_SAMPLER_2D, GL_INT_SAMPLER_3D,
+        GL_INT_SAMPLER_CUBE, GL_INT_SAMPLER_1D_ARRAY,
+        GL_INT_SAMPLER_2D_ARRAY, GL_INT_SAMPLER_2D_MULTISAMPLE,
+        GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY, GL_INT_SAMPLER_BUFFER,
+        GL_INT_SAMPLER_2D_RECT, GL_INT_SAMPLER_CUBE_MAP_ARRAY,
+        GL_UNSIGNED_INT_SAMPLER_1D, GL_UNSIGNED_INT_SAMPLER_2D,
+        GL_UNSIGNED_INT_SAMPLER_3D, GL_UNSIGNED_INT_SAMPLER_CUBE,
+        GL_UNSIGNED_INT_SAMPLER_1D_ARRAY, GL_UNSIGNED_INT_SAMPLER_2D_ARRAY,
+        GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE,
+        GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY,
+        GL_UNSIGNED_INT_SAMPLER_BUFFER, GL_UNSIGNED_INT_SAMPLER_2D_RECT,
+        GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY
+    };
+    return std::find(std::begin(SAMPLERS), std::end(SAMPLERS), type)
+           != std::end(SAMPLERS);
+}
+
+Program Program::create(const std::filesystem::path& vertex,
+                        const std::filesystem::path& fragment,
+                        const shader_defines_t& defines) {
+    return create(create_program(vertex, fragment, defines));
+}
+
+Program Program::create(GLuint id) {
+    Program self;
+    self.id_ = id;
+    if (id == 0) { return self; }
+
+    const auto intf = get_program_interface(id);
+    self.uniforms_.reserve(intf.uniform_location.size());
+    for (const auto& [name, location] : intf.uniform_location) {
+        self.uniforms_.push_back({
+            .name     = normalize_uniform_name(name),
+            .type     = intf.uniform_block.at(name),
+            .location = location,
+            .size     = std::max(intf.uniform_size.at(name), 1)
+        });
+    }
+    std::sort(self.uniforms_.begin(), self.uniforms_.end(),
+              [](const uniform_slot_t& lhs, const uniform_slot_t& rhs) {
+        return lhs.location < rhs.location;
+    });
+    // layout(binding = N) is kept. Samplers left at the default 0 can't be
+    // told from an explicit 0, the first keeps it and the others take the
+    // lowest free units. Arrays take a run of consecutive units, left at
+    // the default all of their elements read 0.
+    std::vector<GLint> taken;
+    std::vector<size_t> defaulted;
+    auto is_taken = [&taken](GLint unit) {
+        return std::find(taken.begin(), taken.end(), unit) != taken.end();
+    };
+    for (size_t i = 0; i < self.uniforms_.size(); ++i) {
+        auto& slot = self.uniforms_[i];
+        if (!is_sampler_type(slot.type)) { continue; }
+        std::vector<GLint> units(size_t(slot.size), 0);
+        SAFE_CALL(glGetUniformiv(id, slot.location, units.data()));
+        for (GLint e = 1; e < slot.size; ++e) {
+            const auto element = slot.name + "[" + std::to_string(e) + "]";
+            const GLint location = glGetUniformLocation(id, element.c_str());
+            SAFE_CALL(glGetUniformiv(id, location, &units[e]));
+        }
+        // an explicit binding gives the elements distinct units
+        const bool is_default_array =
+            std::count(units.begin(), units.end(), 0) > 1;
+        if (units.front() == 0 && (is_taken(0) || is_default_array)) {
+            defaulted.push_back(i);
+            continue;
+        }
+        slot.unit = units.front();
+        taken.insert(taken.end(), units.begin(), units.end());
+    }
+    for (size_t i : defaulted) {
+        auto& slot = self.uniforms_[i];
+        auto is_free = [&](GLint first) {
+            for (GLint unit = first; unit < first + slot.size; ++unit) {
+                if (is_taken(unit)) { return false; }
+            }
+            return true;
+        };
+        GLint first = 0;
+        while (!is_free(first)) { ++first; }
+        slot.unit = first;
+        if (slot.size == 1) {
+            self.set(uniform_handle_t{.index = GLint(i)}, first);
+        } else {
+            std::vector<GLint> units(size_t(slot.size));
+            std::iota(units.begin(), units.end(), first);
+            SAFE_CALL(glProgramUniform1iv(id, slot.location, slot.size,
+                                          units.data()));
+        }
+        for (GLint unit = first; unit < first + slot.size; ++unit) {
+            taken.push_back(unit);
+        }
+    }
+    for (GLint unit : taken) {
+        self.texture_units_ = std::max(self.texture_units_, unit + 1);
+    }
+    return self;
+}
+
+Program::Program(Program&& other) noexcept
+    : id_(std::exchange(other.id_, 0))
+    , uniforms_(std::move(other.uniforms_))
+    , texture_units_(std::exchange(other.texture_units_, 0))
+    , stats_(std::exchange(other.stats_, {}))
+{}
+
+Program& Program::operator = (Program&& other) noexcept {
+    if (this != &other) {
+        free();
+        id_ = std::exchange(other.id_, 0);
+        uniforms_ = std::move(other.uniforms_);
+        texture_units_ = std::exchange(other.texture_units_, 0);
+        stats_ = std::exchange(other.stats_, {});
+    }
+    return *this;
+}
+
+uniform_handle_t Program::uniform(std::string_view name) const {
+    for (size_t i = 0; i < uniforms_.size(); ++i) {
+        if (uniforms_[i].name == name) {
+            return {.index = GLint(i)};
+        }
+    }
+    std::cerr << "Could not find uniform " << name << std::endl;
+    return {};
+}
+
+GLint Program::texture_unit(uniform_handle_t handle) const {
+    return contains(handle) ? uniforms_[handle.index].unit : -1;
+}
+
+bool Program::contains(uniform_handle_t handle) const {
+    return handle.is_valid() && size_t(handle.index) < uniforms_.size();
+}
+
+template <typename T>
+bool Program::changed(uniform_handle_t handle, const T& value) {
+    static_assert(sizeof(T) <= sizeof(uniform_slot_t::value_t));
+
+    auto& slot = uniforms_[handle.index];
+    const auto* raw = reinterpret_cast<const unsigned char*>(&value);
+    if (slot.is_set && std::equal(raw, raw + sizeof(T), slot.value.data())) {
+        ++stats_.skipped;
+        return false;
+    }
+    std::copy(raw, raw + sizeof(T), slot.value.data());
+    slot.is_set = true;
+    ++stats_.uploads;
+    return true;
+}
+
+bool Program::set(uniform_handle_t handle, GLint value) {
+    if (!contains(handle)) { return false; }
+    if (changed(handle, value)) {
+        SAFE_CALL(glProgramUniform1i(id_, uniforms_[handle.index].location,
+                                     value));
+    }
+    return true;
+}
+
+bool Program::set(uniform_handle_t handle, GLfloat value) {
+    if (!contains(handle)) { return false; }
+    if (changed(handle, value)) {
+        SAFE_CALL(glProgramUniform1f(id_, uniforms_[handle.index].location,
+                                     value));
+    }
+    return true;
+}
+
+bool Program::set(uniform_handle_t handle, const glm::vec2& value) {
+    if (!contains(handle)) { return false; }
+    if (changed(handle, value)) {
+        SAFE_CALL(glProgramUniform2f(id_, uniforms_[handle.index].location,
+                                     value.x, value.y));
+    }
+    return true;
+}
+
+bool Program::set(uniform_handle_t handle, const glm::vec3& value) {
+    if (!contains(handle)) { return false; }
+    if (changed(handle, value)) {
+        SAFE_CALL(glProgramUniform3f(id_, uniforms_[handle.index].location,
+                                     value.x, value.y, value.z));
+    }
+    return true;
+}
+
+bool Program::set(uniform_handle_t handle, const glm::vec4& value) {
+    if (!contains(handle)) { return false; }
+    if (changed(handle, value)) {
+        SAFE_CALL(glProgramUniform4f(id_, uniforms_[handle.index].location,
+                                     value.x, value.y, value.z, value.w));
+    }
+    return true;
+}
+
+bool Program::set(uniform_handle_t handle, const glm::mat4& value) {
+    if (!contains(handle)) { return false; }
+    if (changed(handle, value)) {
+        SAFE_CALL(glProgramUniformMatrix4fv(id_,
+                                            uniforms_[handle.index].location,
+                                            1, GL_FALSE,
+                                            glm::value_ptr(value)));
+    }
+    return true;
+}
+
+void Program::invalidate() {
+    for (auto& slot : uniforms_) {
+        slot.is_set = false;
+    }
+}
+
+void Program::free() {
+    if (id_ != 0 && Context::instance().is_context_active()) {
+        free_program(id_);
+    }
+    id_ = 0;
+    uniforms_.clear();
+    texture_units_ = 0;
+    stats_ = {};
+}
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <filesystem>
+
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+#include "opengl_program_cache.hpp"
+
+
+namespace opengl {
+
+struct uniform_handle_t final {
+    GLint index {-1};
+
+    bool is_valid() const { return index >= 0; }
+};
+
+
+struct uniform_slot_t final {
+    using value_t = std::array<unsigned char, sizeof(glm::mat4)>;
+
+    std::string name;
+    GLenum type;    // GL_FLOAT_MAT4, GL_FLOAT_VEC3, GL_SAMPLER_2D ...
+    GLint location;
+    value_t value {};
+    bool is_set   {false};
+    GLint unit    {-1}; // texture unit of a sampler uniform, the first for
+                        // arrays, their elements take the ones after it
+    GLint size    {1};  // array elements
+};
+
+// GL_SAMPLER_* and the integer variants, images aside
+bool is_sampler_type(GLenum type);
+
+
+struct program_stats_t final {
+    size_t uploads {0};
+    size_t skipped {0};
+};
+
+
+// Linked program with uniforms reflected once through get_program_interface.
+// Uniforms are kept in a flat table and addressed by uniform_handle_t, the
+// setters go through glProgramUniform* and skip the upload when the value is
+// equal to the last one written through this object. Values written with
+// opengl::set_* bypass the shadow copy, call invalidate() after mixing both.
+// Sampler uniforms keep their layout(binding = N) unit, the ones without get
+// the lowest free units in location order at create, see bind_textures() in
+// opengl_texture_units.hpp.
+class Program final {
+public:
+    static Program create(const std::filesystem::path& vertex,
+                          const std::filesystem::path& fragment,
+                          const shader_defines_t& defines = {});
+    static Program create(GLuint id);
+
+    Program() = default;
+    // One owner per GL program, moving hands it over, free() deletes it
+    Program(const Program&) = delete;
+    Program& operator = (const Program&) = delete;
+    Program(Program&& other) noexcept;
+    Program& operator = (Program&& other) noexcept;
+
+    GLuint id() const { return id_; }
+    bool is_valid() const { return id_ != 0; }
+
+    uniform_handle_t uniform(std::string_view name) const;
+    const std::vector<uniform_slot_t>& uniforms() const { return uniforms_; }
+    // -1 for handles of other uniforms, element 0 of sampler arrays
+    GLint texture_unit(uniform_handle_t handle) const;
+    // One past the highest unit of a sampler uniform
+    GLint texture_units() const { return texture_units_; }
+
+    bool set(uniform_handle_t handle, GLint value);
+    bool set(uniform_handle_t handle, GLfloat value);
+    bool set(uniform_handle_t handle, const glm::vec2& value);
+    bool set(uniform_handle_t handle, const glm::vec3& value);
+    bool set(uniform_handle_t handle, const glm::vec4& value);
+    bool set(uniform_handle_t handle, const glm::mat4& value);
+
+    void invalidate();
+    const program_stats_t& stats() const { return stats_; }
+    void reset_stats() { stats_ = {}; }
+
+    void free();
+
+private:
+    bool contains(uniform_handle_t handle) const;
+    template <typename T> bool changed(uniform_handle_t handle, const T& v);
+
+private:
+    GLuint id_ {0};
+    std::vector<uniform_slot_t> uniforms_ {};
+    GLint texture_units_                  {0};
+    program_stats_t stats_                {};
+};
+
+}
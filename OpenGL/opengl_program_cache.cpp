@@ -0,0 +1,247 @@
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <format>
+#include <random>
+
+#include "opengl_proc.hpp"
+#include "opengl_render_data.hpp"
+#include "opengl_program_cache.hpp"
+
+
+namespace opengl {
+
+static constexpr uint32_t ENTRY_MAGIC = 0x42505052; // "RPPB"
+static constexpr std::string_view ENTRY_EXTENSION = ".bin";
+static constexpr std::string_view TEMP_EXTENSION = ".tmp";
+
+struct entry_header_t final {
+    uint32_t magic;
+    GLenum format;
+    uint64_t hash;
+};
+
+using ms_t = std::chrono::duration<double, std::milli>;
+
+
+std::string inject_defines(const std::string& source,
+                           const shader_defines_t& defines) {
+    if (defines.empty()) { return source; }
+
+    std::string lines;
+    for (const auto& define : defines) {
+        lines += "#define " + define + "\n";
+    }
+
+    // #version has to stay the first statement
+    size_t at = 0;
+    const size_t version = source.find("#version");
+    if (version != std::string::npos) {
+        const size_t eol = source.find('\n', version);
+        at = eol == std::string::npos ? source.size() : eol + 1;
+    }
+    std::string out = source.substr(0, at);
+    if (at == source.size() && !out.empty() && out.back() != '\n') {
+        out += '\n';
+    }
+    return out + lines + source.substr(at);
+}
+
+uint64_t program_hash(std::string_view vertex, std::string_view fragment,
+                      const shader_defines_t& defines,
+                      std::string_view driver) {
+    static constexpr uint64_t OFFSET = 14695981039346656037ull;
+    static constexpr uint64_t PRIME  = 1099511628211ull;
+
+    uint64_t hash = OFFSET;
+    // the terminating zero keeps "ab" + "c" apart from "a" + "bc"
+    auto feed = [&hash](std::string_view part) {
+        for (unsigned char c : part) {
+            hash = (hash ^ c) * PRIME;
+        }
+        hash = (hash ^ 0) * PRIME;
+    };
+    feed(vertex);
+    feed(fragment);
+    for (const auto& define : defines) { feed(define); }
+    feed(driver);
+    return hash;
+}
+
+
+ProgramCache& ProgramCache::instance() {
+    static ProgramCache self;
+    return self;
+}
+
+void ProgramCache::directory(const std::filesystem::path& path) {
+    directory_ = path;
+    if (directory_.empty()) { return; }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error) {
+        std::cerr << "ProgramCache: " << directory_ << ": " << error.message()
+                  << ", caching disabled" << std::endl;
+        directory_.clear();
+    }
+}
+
+GLuint ProgramCache::create_program(const std::string& vertex,
+                                    const std::string& fragment,
+                                    const shader_defines_t& defines) {
+    const uint64_t hash = key(vertex, fragment, defines);
+    if (GLuint program = load(hash); program != 0) { return program; }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    GLuint program = compile_program(inject_defines(vertex, defines),
+                                     inject_defines(fragment, defines),
+                                     hash != 0);
+    store(hash, program);
+    if (hash != 0) {
+        stats_.build_ms += ms_t(std::chrono::steady_clock::now() - t0).count();
+    }
+    return program;
+}
+
+uint64_t ProgramCache::key(const std::string& vertex,
+                           const std::string& fragment,
+                           const shader_defines_t& defines) {
+    if (!is_enabled()) { return 0; }
+    const auto& driver_id = driver();
+    // drivers without binary formats cannot use the cache at all
+    if (formats_.empty()) { return 0; }
+    return program_hash(vertex, fragment, defines, driver_id);
+}
+
+GLuint ProgramCache::load(uint64_t key) {
+    if (key == 0) { return 0; }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    GLuint program = read_entry(key);
+    if (program == 0) {
+        ++stats_.misses;
+        return 0;
+    }
+    ++stats_.hits;
+    stats_.load_ms += ms_t(std::chrono::steady_clock::now() - t0).count();
+    return program;
+}
+
+void ProgramCache::clear() {
+    if (!is_enabled()) { return; }
+
+    std::error_code error;
+    for (const auto& entry
+         : std::filesystem::directory_iterator(directory_, error)) {
+        const auto extension = entry.path().extension();
+        if (extension == ENTRY_EXTENSION || extension == TEMP_EXTENSION) {
+            std::filesystem::remove(entry.path(), error);
+        }
+    }
+}
+
+const std::string& ProgramCache::driver() {
+    if (driver_.empty()) {
+        auto str = [](GLenum name) {
+            const auto* value = glGetString(name);
+            return value ? reinterpret_cast<const char*>(value) : "";
+        };
+        driver_ = std::format("{}|{}|{}", str(GL_VENDOR), str(GL_RENDERER),
+                              str(GL_VERSION));
+
+        GLint count = 0;
+        SAFE_CALL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count));
+        formats_.resize(count);
+        if (count > 0) {
+            SAFE_CALL(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS,
+                                    formats_.data()));
+        }
+    }
+    return driver_;
+}
+
+std::filesystem::path ProgramCache::entry_path(uint64_t hash) const {
+    return directory_ / std::format("{:016x}{}", hash, ENTRY_EXTENSION);
+}
+
+GLuint ProgramCache::read_entry(uint64_t hash) {
+    const auto path = entry_path(hash);
+    std::ifstream file(path, std::ios::binary);
+    if (!file) { return 0; }
+
+    entry_header_t header {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    std::vector<char> binary(
+        (std::istreambuf_iterator<char>(file)),
+         std::istreambuf_iterator<char>()
+    );
+    file.close();
+    if (header.magic != ENTRY_MAGIC || header.hash != hash
+        || binary.empty()) {
+        std::filesystem::remove(path);
+        return 0;
+    }
+    // an unknown format would be a GL error instead of a failed link
+    if (std::find(formats_.begin(), formats_.end(), GLint(header.format))
+        == formats_.end()) {
+        ++stats_.rejected;
+        std::filesystem::remove(path);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    SAFE_CALL(glProgramBinary(program, header.format, binary.data(),
+                              GLsizei(binary.size())));
+    GLint is_linked = GL_FALSE;
+    SAFE_CALL(glGetProgramiv(program, GL_LINK_STATUS, &is_linked));
+    if (is_linked == GL_FALSE) {
+        ++stats_.rejected;
+        SAFE_CALL(glDeleteProgram(program));
+        std::filesystem::remove(path);
+        return 0;
+    }
+    return program;
+}
+
+void ProgramCache::store(uint64_t hash, GLuint program) {
+    if (hash == 0 || program == 0) { return; }
+
+    GLint length = 0;
+    SAFE_CALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0) { return; }
+
+    entry_header_t header {.magic = ENTRY_MAGIC, .format = 0, .hash = hash};
+    std::vector<char> binary(length);
+    SAFE_CALL(glGetProgramBinary(program, length, &length, &header.format,
+                                 binary.data()));
+
+    // readers in other processes never see a partially written entry,
+    // the rename replaces the target atomically in the same directory
+    const auto path = entry_path(hash);
+    auto temp = path;
+    temp += std::format(".{:08x}{}", std::random_device{}(), TEMP_EXTENSION);
+    {
+        std::ofstream file(temp, std::ios::binary);
+        if (!file) { return; }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        file.close();
+        if (!file) {
+            std::error_code error;
+            std::filesystem::remove(temp, error);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+        std::filesystem::remove(temp, error);
+        return;
+    }
+    ++stats_.stored;
+}
+
+}
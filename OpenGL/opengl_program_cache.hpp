@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+#include <filesystem>
+
+#include <glad/glad.h>
+
+
+namespace opengl {
+
+// "NAME" or "NAME VALUE", emitted as #define lines right after #version
+using shader_defines_t = std::vector<std::string>;
+
+std::string inject_defines(const std::string& source,
+                           const shader_defines_t& defines);
+
+// 64 bit FNV-1a over both sources, the defines and the driver string
+uint64_t program_hash(std::string_view vertex, std::string_view fragment,
+                      const shader_defines_t& defines,
+                      std::string_view driver);
+
+
+struct program_cache_stats_t final {
+    size_t hits     {0}; // programs loaded with glProgramBinary
+    size_t misses   {0}; // programs compiled from source
+    size_t rejected {0}; // binaries found but refused by the driver
+    size_t stored   {0}; // binaries written after a miss
+    double load_ms  {0}; // time spent in hits
+    double build_ms {0}; // time spent in create_program misses
+};
+
+
+// Program binaries kept on disk, keyed by program_hash(). A cached binary is
+// tried first with glProgramBinary and the program is compiled from source
+// when there is none or the driver rejects it, e.g. after a driver update.
+// The cache stays disabled until a directory is set.
+class ProgramCache final {
+public:
+    static ProgramCache& instance();
+
+    void directory(const std::filesystem::path& path);
+    const std::filesystem::path& directory() const { return directory_; }
+    bool is_enabled() const { return !directory_.empty(); }
+
+    GLuint create_program(const std::string& vertex,
+                          const std::string& fragment,
+                          const shader_defines_t& defines = {});
+
+    // Building blocks of create_program for other compile paths. key() is
+    // 0 when the cache can not be used, load() returns 0 on a miss.
+    uint64_t key(const std::string& vertex, const std::string& fragment,
+                 const shader_defines_t& defines);
+    GLuint load(uint64_t key);
+    void store(uint64_t key, GLuint program);
+
+    // Removes every cached binary
+    void clear();
+
+    const program_cache_stats_t& stats() const { return stats_; }
+    void reset_stats() { stats_ = {}; }
+
+private:
+    ProgramCache() = default;
+
+    const std::string& driver();
+    std::filesystem::path entry_path(uint64_t hash) const;
+    GLuint read_entry(uint64_t hash);
+
+private:
+    std::filesystem::path directory_ {};
+    std::string driver_              {};
+    std::vector<GLint> formats_      {};
+    program_cache_stats_t stats_     {};
+};
+
+}
@@ -0,0 +1,170 @@
+#include <algorithm>
+
+#include "opengl_proc.hpp"
+#include "opengl_utils.hpp"
+#include "opengl_render_data.hpp"
+#include "opengl_program_compiler.hpp"
+
+
+namespace opengl {
+
+AsyncProgram::state_t::~state_t() {
+    if (!Context::instance().is_context_active()) { return; }
+
+    if (program.is_valid()) {
+        program.free();
+        return;
+    }
+    for (GLuint shader : {vertex, fragment}) {
+        if (shader != 0) { SAFE_CALL(glDeleteShader(shader)); }
+    }
+    if (id != 0) { free_program(id); }
+}
+
+ProgramStatus AsyncProgram::status() const {
+    return state_ ? state_->status : ProgramStatus::FAILED;
+}
+
+Program* AsyncProgram::program() const {
+    return is_ready() ? &state_->program : nullptr;
+}
+
+Program& AsyncProgram::program_or(Program& fallback) const {
+    return is_ready() ? state_->program : fallback;
+}
+
+
+static GLuint start_shader(GLenum type, const std::string& source) {
+    GLuint shader = glCreateShader(type);
+    const auto* src = source.data();
+    SAFE_CALL(glShaderSource(shader, 1, &src, nullptr));
+    SAFE_CALL(glCompileShader(shader));
+    return shader;
+}
+
+ProgramCompiler& ProgramCompiler::instance() {
+    static ProgramCompiler self;
+    return self;
+}
+
+AsyncProgram ProgramCompiler::submit(const std::string& vertex,
+                                     const std::string& fragment,
+                                     const shader_defines_t& defines) {
+    init();
+
+    AsyncProgram handle;
+    handle.state_ = std::make_shared<AsyncProgram::state_t>();
+    auto& state = *handle.state_;
+
+    auto& cache = ProgramCache::instance();
+    state.key = cache.key(vertex, fragment, defines);
+    if (GLuint id = cache.load(state.key); id != 0) {
+        state.id = id;
+        state.program = Program::create(id);
+        state.status = ProgramStatus::READY;
+        return handle;
+    }
+
+    // statuses are not queried here, that is what would block
+    state.vertex = start_shader(GL_VERTEX_SHADER,
+                                inject_defines(vertex, defines));
+    state.fragment = start_shader(GL_FRAGMENT_SHADER,
+                                  inject_defines(fragment, defines));
+    state.id = glCreateProgram();
+    if (state.key != 0) {
+        SAFE_CALL(glProgramParameteri(state.id,
+                                      GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                      GL_TRUE));
+    }
+    SAFE_CALL(glAttachShader(state.id, state.vertex));
+    SAFE_CALL(glAttachShader(state.id, state.fragment));
+    SAFE_CALL(glLinkProgram(state.id));
+    pending_.push_back(handle.state_);
+    return handle;
+}
+
+AsyncProgram ProgramCompiler::submit(const std::filesystem::path& vertex,
+                                     const std::filesystem::path& fragment,
+                                     const shader_defines_t& defines) {
+    return submit(utils::read_shader(vertex), utils::read_shader(fragment),
+                  defines);
+}
+
+size_t ProgramCompiler::poll() {
+    const size_t before = pending_.size();
+    std::erase_if(pending_, [this](const state_sptr_t& state) {
+        if (!is_complete(*state)) { return false; }
+        finish(state);
+        return true;
+    });
+    return before - pending_.size();
+}
+
+void ProgramCompiler::wait(const AsyncProgram& program) {
+    auto it = std::find(pending_.begin(), pending_.end(), program.state_);
+    if (it == pending_.end()) { return; }
+    const auto state = *it;
+    pending_.erase(it);
+    finish(state);
+}
+
+void ProgramCompiler::finish_all() {
+    for (const auto& state : pending_) {
+        finish(state);
+    }
+    pending_.clear();
+}
+
+bool ProgramCompiler::is_parallel() {
+    init();
+    return is_parallel_;
+}
+
+void ProgramCompiler::init() {
+    if (is_initialized_) { return; }
+    is_initialized_ = true;
+
+    // 0xFFFFFFFF lets the driver pick the thread count
+    if (GLAD_GL_KHR_parallel_shader_compile) {
+        SAFE_CALL(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+        is_parallel_ = true;
+    } else if (GLAD_GL_ARB_parallel_shader_compile) {
+        SAFE_CALL(glMaxShaderCompilerThreadsARB(0xFFFFFFFF));
+        is_parallel_ = true;
+    }
+}
+
+bool ProgramCompiler::is_complete(const AsyncProgram::state_t& state) const {
+    if (!is_parallel_) { return true; }
+
+    GLint is_done = GL_FALSE;
+    SAFE_CALL(glGetProgramiv(state.id, GL_COMPLETION_STATUS_KHR, &is_done));
+    return is_done == GL_TRUE;
+}
+
+void ProgramCompiler::finish(const state_sptr_t& state) {
+    check_shader(state->vertex);
+    check_shader(state->fragment);
+    const bool is_linked = check_program(state->id);
+
+    SAFE_CALL(glDetachShader(state->id, state->vertex));
+    SAFE_CALL(glDetachShader(state->id, state->fragment));
+    SAFE_CALL(glDeleteShader(state->vertex));
+    SAFE_CALL(glDeleteShader(state->fragment));
+    state->vertex = 0;
+    state->fragment = 0;
+
+    // nobody holds the handle any more, the program would leak
+    if (!is_linked || state.use_count() == 1) {
+        free_program(state->id);
+        state->id = 0;
+        state->status = ProgramStatus::FAILED;
+        return;
+    }
+
+    ProgramCache::instance().store(state->key, state->id);
+    state->program = Program::create(state->id);
+    state->status = ProgramStatus::READY;
+}
+
+}
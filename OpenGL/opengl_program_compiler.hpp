@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include <glad/glad.h>
+
+#include "opengl_program.hpp"
+#include "opengl_program_cache.hpp"
+
+
+namespace opengl {
+
+enum class ProgramStatus {
+    PENDING,
+    READY,
+    FAILED
+};
+
+
+// Handle to a program submitted to ProgramCompiler. It resolves on a later
+// ProgramCompiler::poll(), until then program() is nullptr and draws using
+// it have to be skipped or fall back to a ready program. Copies share the
+// program, the last one deletes it.
+class AsyncProgram final {
+public:
+    AsyncProgram() = default;
+
+    ProgramStatus status() const;
+    bool is_ready() const { return status() == ProgramStatus::READY; }
+    bool is_failed() const { return status() == ProgramStatus::FAILED; }
+
+    Program* program() const;
+    Program& program_or(Program& fallback) const;
+
+private:
+    friend class ProgramCompiler;
+
+    // The last handle frees the program, or the shaders and the program
+    // while it is still pending
+    struct state_t final {
+        ~state_t();
+
+        GLuint id              {0};
+        GLuint vertex          {0};
+        GLuint fragment        {0};
+        uint64_t key           {0};
+        ProgramStatus status   {ProgramStatus::PENDING};
+        Program program        {};
+    };
+
+    std::shared_ptr<state_t> state_ {};
+};
+
+
+// Compiles and links programs without waiting on the driver. With
+// KHR_parallel_shader_compile (or the ARB variant) the driver compiles on
+// its own threads and poll() only picks up the programs whose
+// GL_COMPLETION_STATUS_KHR is set. Without it poll() finishes everything
+// pending, the compiler still had the time between submit() and poll().
+// Binaries found in ProgramCache resolve right in submit().
+//
+//   auto sky = compiler.submit("sky.vert", "sky.frag");
+//   ... load meshes and textures ...
+//   compiler.poll(); // once per frame
+//   if (auto* program = sky.program()) { draw ... }
+class ProgramCompiler final {
+public:
+    static ProgramCompiler& instance();
+
+    AsyncProgram submit(const std::string& vertex,
+                        const std::string& fragment,
+                        const shader_defines_t& defines = {});
+    AsyncProgram submit(const std::filesystem::path& vertex,
+                        const std::filesystem::path& fragment,
+                        const shader_defines_t& defines = {});
+
+    // Returns the number of programs resolved by this call
+    size_t poll();
+    // Blocks until program resolves
+    void wait(const AsyncProgram& program);
+    void finish_all();
+
+    size_t pending() const { return pending_.size(); }
+    bool is_parallel();
+
+private:
+    using state_sptr_t = std::shared_ptr<AsyncProgram::state_t>;
+
+    ProgramCompiler() = default;
+
+    void init();
+    bool is_complete(const AsyncProgram::state_t& state) const;
+    void finish(const state_sptr_t& state);
+
+private:
+    std::vector<state_sptr_t> pending_ {};
+    bool is_initialized_               {false};
+    bool is_parallel_                  {false};
+};
+
+}
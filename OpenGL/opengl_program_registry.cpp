@@ -0,0 +1,68 @@
+#include <algorithm>
+
+#include "opengl_program_registry.hpp"
+
+
+namespace opengl {
+
+static std::string normalize(const std::filesystem::path& path) {
+    std::error_code error;
+    auto out = std::filesystem::weakly_canonical(path, error);
+    if (error) { out = path.lexically_normal(); }
+    return out.generic_string();
+}
+
+ProgramRegistry& ProgramRegistry::instance() {
+    static ProgramRegistry self;
+    return self;
+}
+
+program_ref_t ProgramRegistry::acquire(const std::filesystem::path& vertex,
+                                       const std::filesystem::path& fragment,
+                                       const shader_defines_t& defines) {
+    ++stats_.requests;
+    auto name = key(vertex, fragment, defines);
+    auto it = programs_.find(name);
+    if (it != programs_.end()) {
+        if (auto shared = it->second.lock()) { return shared; }
+    }
+
+    // only misses prune, the map stays as large as the live programs
+    std::erase_if(programs_, [](const auto& entry) {
+        return entry.second.expired();
+    });
+    ++stats_.compiles;
+    program_ref_t program = std::make_shared<const AsyncProgram>(
+        ProgramCompiler::instance().submit(vertex, fragment, defines)
+    );
+    programs_[std::move(name)] = program;
+    return program;
+}
+
+program_ref_t
+ProgramRegistry::acquire_sync(const std::filesystem::path& vertex,
+                              const std::filesystem::path& fragment,
+                              const shader_defines_t& defines) {
+    auto program = acquire(vertex, fragment, defines);
+    ProgramCompiler::instance().wait(*program);
+    return program;
+}
+
+size_t ProgramRegistry::size() const {
+    return std::count_if(programs_.begin(), programs_.end(),
+                         [](const auto& entry) {
+        return !entry.second.expired();
+    });
+}
+
+std::string ProgramRegistry::key(const std::filesystem::path& vertex,
+                                 const std::filesystem::path& fragment,
+                                 const shader_defines_t& defines) {
+    std::string out = normalize(vertex) + "|" + normalize(fragment);
+    for (const auto& define : defines) {
+        out += "|" + define;
+    }
+    return out;
+}
+
+}
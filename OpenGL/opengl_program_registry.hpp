@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <filesystem>
+#include <unordered_map>
+
+#include "opengl_program_compiler.hpp"
+
+
+namespace opengl {
+
+// Shared, reference counted program. The GL program is deleted when the
+// last reference goes away.
+using program_ref_t = std::shared_ptr<const AsyncProgram>;
+
+struct program_registry_stats_t final {
+    size_t requests {0};
+    size_t compiles {0}; // requests that were not shared
+};
+
+
+// One program per shader pair and defines. The key uses the normalised
+// shader paths, so "./a.vert" and "a.vert" share a program.
+class ProgramRegistry final {
+public:
+    static ProgramRegistry& instance();
+
+    // Compiles through ProgramCompiler on the first request
+    program_ref_t acquire(const std::filesystem::path& vertex,
+                          const std::filesystem::path& fragment,
+                          const shader_defines_t& defines = {});
+    // As acquire() but the program is resolved, ready or failed, on return
+    program_ref_t acquire_sync(const std::filesystem::path& vertex,
+                               const std::filesystem::path& fragment,
+                               const shader_defines_t& defines = {});
+
+    // Live programs
+    size_t size() const;
+    const program_registry_stats_t& stats() const { return stats_; }
+
+private:
+    ProgramRegistry() = default;
+
+    static std::string key(const std::filesystem::path& vertex,
+                           const std::filesystem::path& fragment,
+                           const shader_defines_t& defines);
+
+private:
+    std::unordered_map<std::string, std::weak_ptr<const AsyncProgram>>
+        programs_ {};
+    program_registry_stats_t stats_ {};
+};
+
+}
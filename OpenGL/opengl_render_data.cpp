@@ -1,12 +1,16 @@
+#include <Profiler/profiler.hpp>
+
 #include "opengl_proc.hpp"
 #include "opengl_utils.hpp"
+#include "opengl_program_cache.hpp"
 #include "opengl_render_data.hpp"
 
 
 namespace opengl {
 
-GLuint create_program(const std::string& vertex_shader_src,
-    const std::string& fragment_shader_src) {
+GLuint compile_program(const std::string& vertex_shader_src,
+                       const std::string& fragment_shader_src,
+                       bool is_retrievable) {
     GLuint program = glCreateProgram(),
            vertex_shader = glCreateShader(GL_VERTEX_SHADER),
            fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
@@ -14,47 +18,69 @@ GLuint create_program(const std::string& vertex_shader_src,
     const auto* src = vertex_shader_src.data();
     SAFE_CALL(glShaderSource(vertex_shader, 1, &src, nullptr));
     SAFE_CALL(glCompileShader(vertex_shader));
-    if (!check_shader(vertex_shader)) {
-        SAFE_CALL(glDeleteShader(vertex_shader));
-    }
+    check_shader(vertex_shader);
 
     src = fragment_shader_src.data();
     SAFE_CALL(glShaderSource(fragment_shader, 1, &src, nullptr));
     SAFE_CALL(glCompileShader(fragment_shader));
-    if (!check_shader(fragment_shader)) {
-        SAFE_CALL(glDeleteShader(fragment_shader));
-    }
+    check_shader(fragment_shader);
 
+    if (is_retrievable) {
+        SAFE_CALL(glProgramParameteri(program,
+                                      GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                      GL_TRUE));
+    }
     SAFE_CALL(glAttachShader(program, vertex_shader));
     SAFE_CALL(glAttachShader(program, fragment_shader));
     SAFE_CALL(glLinkProgram(program));
-    if (!check_program(program)) {
-        SAFE_CALL(glDeleteProgram(program));
-    }
+    const bool is_linked = check_program(program);
     SAFE_CALL(glDetachShader(program, vertex_shader));
     SAFE_CALL(glDetachShader(program, fragment_shader));
+    SAFE_CALL(glDeleteShader(vertex_shader));
+    SAFE_CALL(glDeleteShader(fragment_shader));
+    if (!is_linked) {
+        SAFE_CALL(glDeleteProgram(program));
+        return 0;
+    }
     return program;
 }
 
+GLuint create_program(const std::string& vertex_shader_src,
+                      const std::string& fragment_shader_src,
+                      const shader_defines_t& defines) {
+    PROFILE_ZONE("create_program");
+    return ProgramCache::instance().create_program(vertex_shader_src,
+                                                   fragment_shader_src,
+                                                   defines);
+}
+
 GLuint create_program(const std::filesystem::path& vertex_path,
-    const std::filesystem::path& fragment_path) {
+                      const std::filesystem::path& fragment_path,
+                      const shader_defines_t& defines) {
     auto vertex_src = opengl::utils::read_shader(vertex_path);
     auto fragment_src = opengl::utils::read_shader(fragment_path);
-    return create_program(vertex_src, fragment_src);
+    return create_program(vertex_src, fragment_src, defines);
 }
 
 void free_program(GLuint id) {
+    Context::instance().forget_program(id);
     SAFE_CALL(glDeleteProgram(id));
 }
 
 void render_data_t::free() {
-    if (Context::instance().is_context_active()) {
+    auto& ctx = Context::instance();
+    if (ctx.is_context_active()) {
+        ctx.forget_buffer(ebo);
+        for (auto id : vertex_buffers) { ctx.forget_buffer(id); }
+        ctx.forget_vertex_array(vao);
         SAFE_CALL(glDeleteBuffers(1, &ebo));
         SAFE_CALL(glDeleteBuffers(vertex_buffers.size(),
                                   vertex_buffers.data()));
         SAFE_CALL(glDeleteVertexArrays(1, &vao));
-        SAFE_CALL(glDeleteProgram(program));
     }
+    // the registry deletes the program with its last reference
+    program_ref.reset();
+    program = 0;
     ebo = 0;
     vertex_buffers.clear();
     vao = 0;
@@ -6,21 +6,30 @@
 
 #include "comands.hpp"
 #include "opengl_proc.hpp"
+#include "opengl_program_cache.hpp"
+#include "opengl_program_registry.hpp"
 
 
 namespace opengl {
 using stencil_idx_t = GLubyte;
 
 
+// Both go through ProgramCache, compile_program always builds from source
 GLuint create_program(const std::filesystem::path& vertex_path,
-                      const std::filesystem::path& fragment_path);
+                      const std::filesystem::path& fragment_path,
+                      const shader_defines_t& defines = {});
 GLuint create_program(const std::string& vertex_shader,
-                      const std::string& fragment_shader);
+                      const std::string& fragment_shader,
+                      const shader_defines_t& defines = {});
+GLuint compile_program(const std::string& vertex_shader,
+                       const std::string& fragment_shader,
+                       bool is_retrievable = false);
 void free_program(GLuint id);
 
 
 struct render_data_t final {
     GLuint program;
+    program_ref_t program_ref;
     GLuint vao;
     std::vector<GLuint> vertex_buffers;
     GLuint ebo;
@@ -34,7 +43,12 @@ public:
                                 const std::vector<vertex_input_f> vertex_in,
                                 const std::vector<GLuint> elements_in) {
         render_data_t self;
-        self.program = opengl::create_program(vertex_shader, fragment_shader);
+        // shared with every other user of the same shaders
+        self.program_ref = ProgramRegistry::instance().acquire_sync(
+            vertex_shader, fragment_shader
+        );
+        auto* linked = self.program_ref->program();
+        self.program = linked ? linked->id() : 0;
         self.vao = opengl::gen_vertex_array();
         self.ebo = opengl::gen_element_buffer();
         self.vertex_buffers = vertex_input_f::gen_buffers(
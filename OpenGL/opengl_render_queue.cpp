@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cassert>
+
+#include "opengl_proc.hpp"
+#include "opengl_render_queue.hpp"
+
+
+namespace opengl {
+
+static constexpr int PASS_BITS    = 6;
+static constexpr int PROGRAM_BITS = 16;
+static constexpr int VAO_BITS     = 14;
+static constexpr int TEXTURE_BITS = 14;
+static constexpr int DEPTH_BITS   = 14;
+static_assert(PASS_BITS + PROGRAM_BITS + VAO_BITS + TEXTURE_BITS
+              + DEPTH_BITS == 64);
+
+static constexpr sort_key_t field(sort_key_t value, int bits, int shift) {
+    return (value & ((sort_key_t(1) << bits) - 1)) << shift;
+}
+
+sort_key_t make_sort_key(uint8_t pass, GLuint program, GLuint vao,
+                         GLuint texture, float depth) {
+    static constexpr float DEPTH_MAX = float((1 << DEPTH_BITS) - 1);
+    const auto d = sort_key_t(std::clamp(depth, 0.0f, 1.0f) * DEPTH_MAX);
+
+    int shift = 64;
+    sort_key_t key = 0;
+    key |= field(pass, PASS_BITS, shift -= PASS_BITS);
+    key |= field(program, PROGRAM_BITS, shift -= PROGRAM_BITS);
+    key |= field(vao, VAO_BITS, shift -= VAO_BITS);
+    key |= field(texture, TEXTURE_BITS, shift -= TEXTURE_BITS);
+    key |= field(d, DEPTH_BITS, shift -= DEPTH_BITS);
+    return key;
+}
+
+void radix_sort(std::vector<queue_key_t>& keys,
+                std::vector<queue_key_t>& scratch) {
+    static constexpr int RADIX = 256;
+
+    scratch.resize(keys.size());
+    for (int shift = 0; shift < 64; shift += 8) {
+        std::array<size_t, RADIX> count {};
+        for (const auto& k : keys) {
+            ++count[(k.key >> shift) & 0xFF];
+        }
+        // every key has the same byte here, the order would not change
+        if (std::find(count.begin(), count.end(), keys.size())
+            != count.end()) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (auto& c : count) {
+            const size_t n = c;
+            c = offset;
+            offset += n;
+        }
+        for (const auto& k : keys) {
+            scratch[count[(k.key >> shift) & 0xFF]++] = k;
+        }
+        keys.swap(scratch);
+    }
+}
+
+
+RenderQueue::item_ref_t&
+RenderQueue::item_ref_t::texture(GLuint unit, GLenum target, GLuint id,
+                                 GLuint sampler) {
+    auto& item = queue_.items_[index_];
+    assert(item.texture_count < MAX_TEXTURES);
+    item.textures[item.texture_count++] = {
+        .unit    = unit,
+        .target  = target,
+        .id      = id,
+        .sampler = sampler
+    };
+    return *this;
+}
+
+RenderQueue::item_ref_t&
+RenderQueue::item_ref_t::uniform(uniform_handle_t handle,
+                                 const uniform_value_t& value) {
+    auto& item = queue_.items_[index_];
+    assert(queue_.uniforms_.size() == item.uniform_first + item.uniform_count);
+    queue_.uniforms_.push_back({.handle = handle, .value = value});
+    ++item.uniform_count;
+    return *this;
+}
+
+RenderQueue::item_ref_t RenderQueue::push(uint8_t pass, Program& program,
+                                          const command_t& command,
+                                          float depth) {
+    items_.push_back({
+        .pass          = pass,
+        .depth         = depth,
+        .program       = &program,
+        .command       = command,
+        .textures      = {},
+        .texture_count = 0,
+        .uniform_first = uint32_t(uniforms_.size()),
+        .uniform_count = 0
+    });
+    return item_ref_t(*this, uint32_t(items_.size() - 1));
+}
+
+void RenderQueue::flush() {
+    stats_ = {};
+    if (items_.empty()) { return; }
+
+    keys_.resize(items_.size());
+    for (uint32_t i = 0; i < items_.size(); ++i) {
+        const auto& item = items_[i];
+        const GLuint texture = item.texture_count ? item.textures[0].id : 0;
+        keys_[i] = {
+            .key   = make_sort_key(item.pass, item.program->id(),
+                                   vao_of(item.command), texture, item.depth),
+            .index = i
+        };
+    }
+    radix_sort(keys_, scratch_);
+
+    auto& ctx = Context::instance();
+    GLuint program = ctx.active_program();
+    GLuint vao = ctx.bound_vao();
+    size_t texture_refs = 0;
+    for (const auto& k : keys_) {
+        auto& item = items_[k.index];
+        if (!item.program->is_valid()) {
+            ++stats_.skipped;
+            continue;
+        }
+
+        if (item.program->id() != program) {
+            program = item.program->id();
+            ctx.use_program(program);
+            ++stats_.program_binds;
+        }
+        // textures on following units go out in one batch
+        texture_binding_t batch[MAX_TEXTURES];
+        size_t batched = 0;
+        for (uint8_t t = 0; t <= item.texture_count; ++t) {
+            const bool is_next = t < item.texture_count && (batched == 0
+                || item.textures[t].unit == item.textures[t - 1].unit + 1);
+            if (!is_next && batched > 0) {
+                const GLuint first = item.textures[t - batched].unit;
+                stats_.texture_binds += ctx.bind_textures(first, batch,
+                                                          batched);
+                batched = 0;
+            }
+            if (t == item.texture_count) { break; }
+            const auto& tex = item.textures[t];
+            batch[batched++] = {
+                .target  = tex.target,
+                .texture = tex.id,
+                .sampler = tex.sampler
+            };
+            ++texture_refs;
+        }
+        for (uint32_t u = 0; u < item.uniform_count; ++u) {
+            const auto& uniform = uniforms_[item.uniform_first + u];
+            std::visit([&](const auto& value) {
+                item.program->set(uniform.handle, value);
+            }, uniform.value);
+        }
+        const GLuint item_vao = vao_of(item.command);
+        if (item_vao != vao) {
+            vao = item_vao;
+            ctx.bind_vertex_array(vao);
+            ++stats_.vao_binds;
+        }
+        issue(item.command);
+    }
+
+    stats_.draws = keys_.size() - stats_.skipped;
+    stats_.binds_saved = (stats_.draws - stats_.program_binds)
+                         + (stats_.draws - stats_.vao_binds)
+                         + (texture_refs - stats_.texture_binds);
+    clear();
+}
+
+void RenderQueue::clear() {
+    items_.clear();
+    uniforms_.clear();
+    keys_.clear();
+}
+
+GLuint RenderQueue::vao_of(const command_t& command) {
+    return std::visit([](const auto& cmd) { return cmd.vao; }, command);
+}
+
+void RenderQueue::issue(const command_t& command) {
+    struct visitor_t final {
+        void operator () (const draw_array_command_t& cmd) const {
+            SAFE_CALL(glDrawArrays(cmd.mode, cmd.first, cmd.count));
+        }
+        void operator () (const draw_elements_command_t& cmd) const {
+            SAFE_CALL(glDrawElements(cmd.mode, cmd.count, cmd.type,
+                                     cmd.indices));
+        }
+        void operator () (const draw_array_instanced_t& cmd) const {
+            SAFE_CALL(glDrawArraysInstanced(cmd.mode, cmd.first, cmd.count,
+                                            cmd.instancecount));
+        }
+        void operator () (const draw_elements_instanced_t& cmd) const {
+            SAFE_CALL(glDrawElementsInstanced(cmd.mode, cmd.count, cmd.type,
+                                              cmd.indices,
+                                              cmd.instancecount));
+        }
+    };
+    std::visit(visitor_t{}, command);
+}
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <variant>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+#include "comands.hpp"
+#include "opengl_program.hpp"
+
+
+namespace opengl {
+
+// 64 bit sort key, most significant first:
+// | pass 6 | program 16 | vao 14 | texture 14 | depth 14 |
+// Ids wider than their field are truncated, that only weakens the grouping,
+// submission always compares the real ids.
+using sort_key_t = uint64_t;
+
+sort_key_t make_sort_key(uint8_t pass, GLuint program, GLuint vao,
+                         GLuint texture, float depth);
+
+struct queue_key_t final {
+    sort_key_t key;
+    uint32_t index;
+};
+
+// Stable LSD radix sort on the key, 8 bits per pass. Passes where every key
+// shares the same byte are skipped. scratch is resized as needed.
+void radix_sort(std::vector<queue_key_t>& keys,
+                std::vector<queue_key_t>& scratch);
+
+
+struct render_queue_stats_t final {
+    size_t draws         {0};
+    size_t program_binds {0};
+    size_t vao_binds     {0};
+    size_t texture_binds {0};
+    size_t binds_saved   {0}; // against one bind per draw and texture
+    size_t skipped       {0}; // draws whose program is not linked yet
+};
+
+
+// Records draws for a frame and submits them sorted by make_sort_key, so
+// draws sharing a program, VAO and textures are issued back to back with the
+// state set once. Programs are referenced, they have to outlive flush().
+// Items whose program is not valid, e.g. still compiling, are skipped.
+class RenderQueue final {
+public:
+    static constexpr size_t MAX_TEXTURES = 4;
+
+    using command_t = std::variant<draw_array_command_t,
+                                   draw_elements_command_t,
+                                   draw_array_instanced_t,
+                                   draw_elements_instanced_t>;
+    using uniform_value_t = std::variant<GLint, GLfloat, glm::vec2, glm::vec3,
+                                         glm::vec4, glm::mat4>;
+
+    struct texture_t final {
+        GLuint unit;
+        GLenum target;
+        GLuint id;
+        GLuint sampler;
+    };
+
+    struct uniform_t final {
+        uniform_handle_t handle;
+        uniform_value_t value;
+    };
+
+    // Adds textures and uniforms to the item returned by push(), has to be
+    // used before the next push()
+    class item_ref_t final {
+    public:
+        item_ref_t& texture(GLuint unit, GLenum target, GLuint id,
+                            GLuint sampler = 0);
+        item_ref_t& uniform(uniform_handle_t handle,
+                            const uniform_value_t& value);
+
+    private:
+        friend class RenderQueue;
+        item_ref_t(RenderQueue& queue, uint32_t index)
+            : queue_(queue), index_(index) {}
+
+        RenderQueue& queue_;
+        uint32_t index_;
+    };
+
+    // depth is expected in [0, 1], pass 1 - depth for back to front order
+    item_ref_t push(uint8_t pass, Program& program, const command_t& command,
+                    float depth = 0.0f);
+
+    void flush();
+    void clear();
+
+    size_t size() const { return items_.size(); }
+    const render_queue_stats_t& stats() const { return stats_; }
+
+private:
+    struct item_t final {
+        uint8_t pass;
+        float depth;
+        Program* program;
+        command_t command;
+        std::array<texture_t, MAX_TEXTURES> textures;
+        uint8_t texture_count {0};
+        uint32_t uniform_first {0};
+        uint32_t uniform_count {0};
+    };
+
+    static GLuint vao_of(const command_t& command);
+    static void issue(const command_t& command);
+
+private:
+    std::vector<item_t> items_          {};
+    std::vector<uniform_t> uniforms_    {};
+    std::vector<queue_key_t> keys_      {};
+    std::vector<queue_key_t> scratch_   {};
+    render_queue_stats_t stats_         {};
+};
+
+}
@@ -0,0 +1,139 @@
+#include <cmath>
+#include <iostream>
+
+#include "opengl_proc.hpp"
+#include "opengl_context.hpp"
+#include "opengl_render_target.hpp"
+
+
+namespace opengl {
+
+bool resize_policy_t::update(glm::ivec2 size) {
+    if (size.x <= 0 || size.y <= 0) { return false; }
+
+    auto grown = [this](int v) {
+        return int(std::ceil(float(v) * (1.0f + slack)));
+    };
+    if (size.x > capacity.x || size.y > capacity.y) {
+        // a dimension that still fits keeps its capacity
+        capacity = {
+            size.x > capacity.x ? grown(size.x) : capacity.x,
+            size.y > capacity.y ? grown(size.y) : capacity.y
+        };
+        small_frames = 0;
+        return true;
+    }
+
+    if (size.x * 2 >= capacity.x && size.y * 2 >= capacity.y) {
+        small_frames = 0;
+        return false;
+    }
+    if (++small_frames < shrink_frames) { return false; }
+    capacity = {grown(size.x), grown(size.y)};
+    small_frames = 0;
+    return true;
+}
+
+
+render_target_t render_target_t::create(const render_target_config_t& config) {
+    render_target_t self {
+        .fbo = gen_framebuffer(),
+        .config = config
+    };
+    self.config.policy.capacity = glm::ivec2(0);
+    self.config.policy.small_frames = 0;
+
+    std::vector<GLenum> draw_buffers;
+    for (size_t i = 0; i < config.colors.size(); ++i) {
+        draw_buffers.push_back(GL_COLOR_ATTACHMENT0 + GLenum(i));
+    }
+    SAFE_CALL(glNamedFramebufferDrawBuffers(self.fbo,
+                                            GLsizei(draw_buffers.size()),
+                                            draw_buffers.data()));
+    return self;
+}
+
+bool render_target_t::resize(GLsizei width, GLsizei height) {
+    if (width <= 0 || height <= 0) { return false; }
+
+    size = {width, height};
+    if (!config.policy.update(size)) { return false; }
+    allocate();
+    return true;
+}
+
+glm::vec2 render_target_t::uv_max() const {
+    const auto cap = capacity();
+    if (cap.x == 0 || cap.y == 0) { return glm::vec2(1.0f); }
+    return {float(size.x) / float(cap.x), float(size.y) / float(cap.y)};
+}
+
+GLenum render_target_t::status() const {
+    return glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER);
+}
+
+void render_target_t::free() {
+    if (!Context::instance().is_context_active()) { return; }
+
+    release_attachments();
+    if (fbo != 0) {
+        Context::instance().forget_framebuffer(fbo);
+        SAFE_CALL(glDeleteFramebuffers(1, &fbo));
+        fbo = 0;
+    }
+}
+
+// Storage is immutable, a new capacity takes new textures on the same fbo
+void render_target_t::allocate() {
+    release_attachments();
+    const auto cap = capacity();
+
+    for (size_t i = 0; i < config.colors.size(); ++i) {
+        texture_data_t texture {
+            .id         = gen_texture(GL_TEXTURE_2D),
+            .target     = GL_TEXTURE_2D,
+            .w          = cap.x,
+            .h          = cap.y,
+            .format     = config.colors[i],
+            .type       = GL_UNSIGNED_BYTE,
+            .wrap_s     = GL_CLAMP_TO_EDGE,
+            .wrap_t     = GL_CLAMP_TO_EDGE,
+            .min_filter = config.filter,
+            .mag_filter = config.filter
+        };
+        set_texture_meta(nullptr, texture);
+        SAFE_CALL(glNamedFramebufferTexture(fbo,
+                                            GL_COLOR_ATTACHMENT0 + GLenum(i),
+                                            texture.id, 0));
+        colors.push_back(texture);
+    }
+
+    if (config.has_depth_stencil) {
+        SAFE_CALL(glCreateRenderbuffers(1, &depth_stencil));
+        SAFE_CALL(glNamedRenderbufferStorage(depth_stencil,
+                                             GL_DEPTH24_STENCIL8,
+                                             cap.x, cap.y));
+        SAFE_CALL(glNamedFramebufferRenderbuffer(fbo,
+                                                 GL_DEPTH_STENCIL_ATTACHMENT,
+                                                 GL_RENDERBUFFER,
+                                                 depth_stencil));
+    }
+    ++reallocations;
+
+    const GLenum result = status();
+    if (result != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "render_target_t: incomplete framebuffer " << result
+                  << std::endl;
+    }
+}
+
+void render_target_t::release_attachments() {
+    for (auto& texture : colors) { texture.free(); }
+    colors.clear();
+    if (depth_stencil != 0) {
+        SAFE_CALL(glDeleteRenderbuffers(1, &depth_stencil));
+        depth_stencil = 0;
+    }
+}
+
+}
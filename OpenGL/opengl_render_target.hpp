@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+#include "texture.hpp"
+
+
+namespace opengl {
+
+// Decides when a render target reallocates. Growing allocates slack extra
+// so dragging a window edge does not reallocate every frame, shrinking
+// waits until the size stayed below half the capacity for shrink_frames
+// updates in a row.
+struct resize_policy_t final {
+    float slack         {0.125f};
+    int shrink_frames   {60};
+    glm::ivec2 capacity {0};
+    int small_frames    {0};
+
+    // True when capacity changed and the storage has to follow
+    bool update(glm::ivec2 size);
+};
+
+struct render_target_config_t final {
+    std::vector<GLint> colors {GL_RGBA}; // one attachment each, in order
+    bool has_depth_stencil    {true};    // depth 24 / stencil 8
+    GLenum filter             {GL_LINEAR};
+    resize_policy_t policy    {};
+};
+
+
+// Framebuffer whose attachments follow the size it is drawn at. Storage is
+// immutable and sized to the policy capacity, draws cover the bottom left
+// size pixels, uv_max() is the matching corner for sampling them.
+//
+//   auto target = render_target_t::create({.colors = {GL_RGBA, GL_RED}});
+//   target.resize(w, h);
+//   bind_fbo(target.fbo);
+//   viewport(0, 0, target.size.x, target.size.y);
+struct render_target_t final {
+    GLuint fbo                         {0};
+    std::vector<texture_data_t> colors {};
+    GLuint depth_stencil               {0}; // renderbuffer
+    glm::ivec2 size                    {0};
+    render_target_config_t config      {};
+    size_t reallocations               {0};
+
+public:
+    static render_target_t create(const render_target_config_t& config);
+
+    // Returns true when the attachments were reallocated
+    bool resize(GLsizei width, GLsizei height);
+
+    glm::ivec2 capacity() const { return config.policy.capacity; }
+    glm::vec2 uv_max() const;
+    GLenum status() const;
+    void free();
+
+private:
+    void allocate();
+    void release_attachments();
+};
+
+}
@@ -0,0 +1,122 @@
+#include <iostream>
+
+#include "opengl_proc.hpp"
+#include "opengl_stream_buffer.hpp"
+
+
+namespace opengl {
+
+static constexpr GLbitfield STORAGE_FLAGS = GL_MAP_WRITE_BIT
+                                            | GL_MAP_PERSISTENT_BIT
+                                            | GL_MAP_COHERENT_BIT;
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+StreamBuffer StreamBuffer::create(size_t region_size) {
+    StreamBuffer self;
+
+    GLint alignment = 0;
+    SAFE_CALL(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+    if (alignment > 0) { self.uniform_align_ = size_t(alignment); }
+    SAFE_CALL(glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT,
+                            &alignment));
+    if (alignment > 0) { self.storage_align_ = size_t(alignment); }
+    self.region_size_ = align_up(region_size, self.uniform_align_);
+
+    const auto total = GLsizeiptr(self.region_size_ * REGIONS);
+    SAFE_CALL(glCreateBuffers(1, &self.id_));
+    SAFE_CALL(glNamedBufferStorage(self.id_, total, nullptr, STORAGE_FLAGS));
+    self.mapped_ = static_cast<std::byte*>(
+        glMapNamedBufferRange(self.id_, 0, total, STORAGE_FLAGS)
+    );
+    if (self.mapped_ == nullptr) {
+        std::cerr << "StreamBuffer: unable to map " << total << " bytes"
+                  << std::endl;
+    }
+    return self;
+}
+
+stream_allocation_t StreamBuffer::allocate(size_t size, size_t alignment) {
+    const size_t head = align_up(head_, alignment);
+    if (mapped_ == nullptr || head + size > region_size_) {
+        ++stats_.overflows;
+        return {};
+    }
+    head_ = head + size;
+    ++stats_.allocations;
+    stats_.bytes += size;
+
+    const size_t offset = region_ * region_size_ + head;
+    return {
+        .data   = mapped_ + offset,
+        .offset = GLintptr(offset),
+        .size   = GLsizeiptr(size)
+    };
+}
+
+stream_allocation_t StreamBuffer::allocate_uniform(size_t size) {
+    return allocate(size, uniform_align_);
+}
+
+stream_allocation_t StreamBuffer::allocate_storage(size_t size) {
+    return allocate(size, storage_align_);
+}
+
+void StreamBuffer::bind_range(GLenum target, GLuint index,
+                              const stream_allocation_t& allocation) const {
+    Context::instance().bind_buffer_range(target, index, id_,
+                                          allocation.offset, allocation.size);
+}
+
+void StreamBuffer::end_frame() {
+    if (id_ == 0) { return; }
+    if (fences_[region_] != nullptr) {
+        SAFE_CALL(glDeleteSync(fences_[region_]));
+    }
+    fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region_ = (region_ + 1) % REGIONS;
+    head_ = 0;
+    wait(region_);
+}
+
+void StreamBuffer::wait(size_t region) {
+    static constexpr GLuint64 TIMEOUT_NS = 1'000'000;
+
+    GLsync fence = fences_[region];
+    if (fence == nullptr) { return; }
+
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        ++stats_.stalls;
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                      TIMEOUT_NS);
+        } while (status == GL_TIMEOUT_EXPIRED);
+    }
+    if (status == GL_WAIT_FAILED) {
+        std::cerr << "StreamBuffer: glClientWaitSync failed" << std::endl;
+    }
+    SAFE_CALL(glDeleteSync(fence));
+    fences_[region] = nullptr;
+}
+
+void StreamBuffer::free() {
+    auto& ctx = Context::instance();
+    if (id_ != 0 && ctx.is_context_active()) {
+        for (auto& fence : fences_) {
+            if (fence != nullptr) { SAFE_CALL(glDeleteSync(fence)); }
+        }
+        SAFE_CALL(glUnmapNamedBuffer(id_));
+        ctx.forget_buffer(id_);
+        SAFE_CALL(glDeleteBuffers(1, &id_));
+    }
+    fences_.fill(nullptr);
+    id_ = 0;
+    mapped_ = nullptr;
+    region_ = 0;
+    head_ = 0;
+}
+
+}
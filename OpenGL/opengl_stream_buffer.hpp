@@ -0,0 +1,96 @@
+#pragma once
+
+#include <span>
+#include <array>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+
+namespace opengl {
+
+// Piece of a StreamBuffer handed out for one frame. data points into the
+// persistent mapping, offset is the same place as seen by the GPU.
+struct stream_allocation_t final {
+    std::byte* data   {nullptr};
+    GLintptr offset   {0};
+    GLsizeiptr size   {0};
+
+    bool is_valid() const { return data != nullptr; }
+};
+
+template <typename T> struct stream_span_t final {
+    std::span<T> data {};
+    GLintptr offset   {0};
+
+    bool is_valid() const { return !data.empty(); }
+};
+
+struct stream_buffer_stats_t final {
+    size_t allocations {0};
+    size_t bytes       {0};
+    size_t stalls      {0}; // frames that waited on the GPU for a region
+    size_t overflows   {0}; // allocations refused, the region was full
+};
+
+
+// Buffer created with glBufferStorage and mapped once, persistent and
+// coherent, split into REGIONS regions used in turn, one per frame. The CPU
+// writes the current region directly through the mapping, so per frame data
+// costs no glBufferSubData copy. end_frame() fences the region the GPU is
+// about to read and waits for the fence of the region written next, which
+// only blocks when the CPU runs REGIONS frames ahead.
+//
+//   auto frames = stream.allocate<float_instanced>(count);
+//   std::copy(in.begin(), in.end(), frames.data.begin());
+//   float_instanced::bind_stream(vao, 6, stream.id(), frames.offset);
+//   draw ...
+//   stream.end_frame();
+class StreamBuffer final {
+public:
+    static constexpr size_t REGIONS = 3;
+
+    // region_size is rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    static StreamBuffer create(size_t region_size);
+
+    stream_allocation_t allocate(size_t size, size_t alignment);
+    stream_allocation_t allocate_uniform(size_t size);
+    stream_allocation_t allocate_storage(size_t size);
+
+    template <typename T> stream_span_t<T> allocate(size_t count) {
+        const auto a = allocate(count * sizeof(T), alignof(T));
+        if (!a.is_valid()) { return {}; }
+        return {
+            .data   = std::span<T>(reinterpret_cast<T*>(a.data), count),
+            .offset = a.offset
+        };
+    }
+
+    // glBindBufferRange on the allocation, for uniform and storage blocks
+    void bind_range(GLenum target, GLuint index,
+                    const stream_allocation_t& allocation) const;
+
+    void end_frame();
+    void free();
+
+    GLuint id() const { return id_; }
+    size_t region_size() const { return region_size_; }
+    size_t region() const { return region_; }
+    const stream_buffer_stats_t& stats() const { return stats_; }
+
+private:
+    void wait(size_t region);
+
+private:
+    GLuint id_             {0};
+    std::byte* mapped_     {nullptr};
+    size_t region_size_    {0};
+    size_t uniform_align_  {256};
+    size_t storage_align_  {256};
+    size_t region_         {0};
+    size_t head_           {0};
+    std::array<GLsync, REGIONS> fences_ {};
+    stream_buffer_stats_t stats_        {};
+};
+
+}
@@ -0,0 +1,94 @@
+#include <array>
+#include <iostream>
+#include <algorithm>
+
+#include "opengl_proc.hpp"
+#include "opengl_context.hpp"
+#include "opengl_texture_units.hpp"
+
+
+namespace opengl {
+
+sampler_params_t sampler_params(const texture_data_t& params) {
+    return {
+        .min_filter = params.min_filter,
+        .mag_filter = params.mag_filter,
+        .wrap_s     = params.wrap_s,
+        .wrap_t     = params.wrap_t,
+        .wrap_r     = params.wrap_t
+    };
+}
+
+SamplerCache& SamplerCache::instance() {
+    static SamplerCache self;
+    return self;
+}
+
+GLuint SamplerCache::get(const sampler_params_t& params) {
+    for (const auto& [cached, id] : samplers_) {
+        if (cached == params) { return id; }
+    }
+
+    GLuint id = 0;
+    SAFE_CALL(glCreateSamplers(1, &id));
+    SAFE_CALL(glSamplerParameteri(id, GL_TEXTURE_MIN_FILTER,
+                                  params.min_filter));
+    SAFE_CALL(glSamplerParameteri(id, GL_TEXTURE_MAG_FILTER,
+                                  params.mag_filter));
+    SAFE_CALL(glSamplerParameteri(id, GL_TEXTURE_WRAP_S, params.wrap_s));
+    SAFE_CALL(glSamplerParameteri(id, GL_TEXTURE_WRAP_T, params.wrap_t));
+    SAFE_CALL(glSamplerParameteri(id, GL_TEXTURE_WRAP_R, params.wrap_r));
+    if (params.max_anisotropy > 1.0f) {
+        SAFE_CALL(glSamplerParameterf(id, GL_TEXTURE_MAX_ANISOTROPY,
+                                      params.max_anisotropy));
+    }
+    samplers_.emplace_back(params, id);
+    return id;
+}
+
+void SamplerCache::clear() {
+    auto& ctx = Context::instance();
+    if (ctx.is_context_active()) {
+        for (const auto& [params, id] : samplers_) {
+            ctx.forget_sampler(id);
+            SAFE_CALL(glDeleteSamplers(1, &id));
+        }
+    }
+    samplers_.clear();
+}
+
+size_t bind_textures(const Program& program,
+                     std::span<const material_texture_t> textures) {
+    std::array<texture_binding_t, Context::MAX_TEXTURE_UNITS> units {};
+    std::array<bool, Context::MAX_TEXTURE_UNITS> is_used {};
+    for (const auto& texture : textures) {
+        const GLint unit = program.texture_unit(texture.uniform);
+        if (unit < 0 || GLuint(unit) >= Context::MAX_TEXTURE_UNITS) {
+            std::cerr << "bind_textures: no texture unit for uniform "
+                      << texture.uniform.index << std::endl;
+            continue;
+        }
+        units[unit] = {
+            .target  = texture.target,
+            .texture = texture.texture,
+            .sampler = texture.sampler
+        };
+        is_used[unit] = true;
+    }
+
+    // one batch per run of used units
+    auto& ctx = Context::instance();
+    size_t changed = 0;
+    for (GLuint first = 0; first < Context::MAX_TEXTURE_UNITS; ++first) {
+        if (!is_used[first]) { continue; }
+        GLuint last = first;
+        while (last + 1 < Context::MAX_TEXTURE_UNITS && is_used[last + 1]) {
+            ++last;
+        }
+        changed += ctx.bind_textures(first, &units[first], last - first + 1);
+        first = last;
+    }
+    return changed;
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <utility>
+
+#include <glad/glad.h>
+
+#include "texture.hpp"
+#include "opengl_program.hpp"
+
+
+namespace opengl {
+
+struct sampler_params_t final {
+    GLenum min_filter      {GL_LINEAR};
+    GLenum mag_filter      {GL_LINEAR};
+    GLenum wrap_s          {GL_REPEAT};
+    GLenum wrap_t          {GL_REPEAT};
+    GLenum wrap_r          {GL_REPEAT};
+    GLfloat max_anisotropy {1.0f};
+
+    bool operator == (const sampler_params_t&) const = default;
+};
+
+// The filters and wrap a texture was created with
+sampler_params_t sampler_params(const texture_data_t& params);
+
+
+// One sampler object per distinct set of parameters, shared by every
+// texture sampled that way. Textures keep their own parameters too, they
+// apply wherever no sampler is bound.
+class SamplerCache final {
+public:
+    static SamplerCache& instance();
+
+    GLuint get(const sampler_params_t& params);
+    GLuint get(const texture_data_t& params) {
+        return get(sampler_params(params));
+    }
+    size_t size() const { return samplers_.size(); }
+
+    // Deletes every sampler, call before the context goes away
+    void clear();
+
+private:
+    SamplerCache() = default;
+
+private:
+    std::vector<std::pair<sampler_params_t, GLuint>> samplers_ {};
+};
+
+
+struct material_texture_t final {
+    uniform_handle_t uniform {};  // a sampler uniform of the program
+    GLenum target            {GL_TEXTURE_2D};
+    GLuint texture           {0};
+    GLuint sampler           {0}; // see SamplerCache
+};
+
+// Binds each texture to the unit the program gave its sampler uniform.
+// Units already holding the texture and sampler are skipped, the rest of
+// a material goes out in one glBindTextures plus one glBindSamplers as
+// long as its units follow each other. Returns the units changed.
+size_t bind_textures(const Program& program,
+                     std::span<const material_texture_t> textures);
+
+}
@@ -3,16 +3,18 @@
 
 namespace opengl {
 
+// Per vertex data always goes through binding 0, instance data uses
+// bindings named after its first attribute
+static constexpr GLuint VERTEX_BINDING = 0;
+
 template <vertex_input_c I>
 buffers_t generic_gen_buffers(GLuint vao,
                               const typename I::vertex_input_t& input) {
     auto buffers = gen_vertex_buffers(1);
-    bind_vao(vao);
-    for (GLuint id : buffers) {
-        bind_vbo<I>(id, input);
-    }
-    do_vertex_attrib_cmds(std::move(I::commands()));
-    bind_vao(0);
+    buffer_storage(buffers[0], input);
+    SAFE_CALL(glVertexArrayVertexBuffer(vao, VERTEX_BINDING, buffers[0], 0,
+                                        sizeof(I)));
+    vertex_array_attribs(vao, VERTEX_BINDING, I::commands());
     return buffers;
 }
 
@@ -21,14 +23,9 @@ buffers_t generic_gen_buffers(GLuint vao,
                               const typename I::vertex_input_t& input,
                               GLuint ebo,
                               const std::vector<GLuint>& ebo_v) {
-    auto buffers = gen_vertex_buffers(1);
-    bind_vao(vao);
-    for (GLuint id : buffers) {
-        bind_vbo<I>(id, input);
-    }
-    bind_ebo(ebo, ebo_v);
-    do_vertex_attrib_cmds(std::move(I::commands()));
-    bind_vao(0);
+    auto buffers = generic_gen_buffers<I>(vao, input);
+    buffer_storage(ebo, ebo_v);
+    Context::instance().vertex_array_element_buffer(vao, ebo);
     return buffers;
 }
 
@@ -59,14 +56,7 @@ vec3pos::vec3pos(glm::vec3&& p)
 
 buffers_t vec3pos::gen_buffers(GLuint vao,
                                const std::vector<vec3pos>& in) {
-    auto buffers = gen_vertex_buffers(1);
-    bind_vao(vao);
-    for (GLuint id : buffers) {
-        bind_vbo<this_t>(id, in);
-    }
-    do_vertex_attrib_cmds(std::move(this_t::commands()));
-    bind_vao(0);
-    return buffers;
+    return generic_gen_buffers<this_t>(vao, in);
 }
 
 buffers_t vec3pos::gen_buffers(GLuint vao, const vertex_input_t& in,
@@ -87,14 +77,13 @@ vec3pos_vec3norm_t::vec3pos_vec3norm_t(glm::vec3&& p, glm::vec3&& n)
 
 buffers_t vec3pos_vec3norm_t::gen_buffers(GLuint vao,
                                           const std::vector<this_t>& in) {
-    auto out = gen_vertex_buffers(2);
-    bind_vao(vao);
-    for (GLuint id : out) {
-        bind_vbo<this_t>(id, in);
-    }
-    do_vertex_attrib_cmds(std::move(this_t::commands()));
-    bind_vao(0);
-    return out;
+    return generic_gen_buffers<this_t>(vao, in);
+}
+
+buffers_t vec3pos_vec3norm_t::gen_buffers(GLuint vao, const vertex_input_t& in,
+                                          GLuint ebo,
+                                          const elements_input_t& ebo_v) {
+    return generic_gen_buffers<this_t>(vao, in, ebo, ebo_v);
 }
 
 vec3pos_vec3norm_t::commands_t vec3pos_vec3norm_t::commands() {
@@ -115,14 +104,7 @@ vec3pos_vec3norm_vec2tex_t::vec3pos_vec3norm_vec2tex_t(glm::vec3&& p,
 
 buffers_t vec3pos_vec3norm_vec2tex_t::gen_buffers(GLuint vao,
                                                   const vertex_input_t& in) {
-    auto buffers = gen_vertex_buffers(1);
-    bind_vao(vao);
-    for (GLuint id : buffers) {
-        bind_vbo<this_t>(id, in);
-    }
-    do_vertex_attrib_cmds(std::move(this_t::commands()));
-    bind_vao(0);
-    return buffers;
+    return generic_gen_buffers<this_t>(vao, in);
 }
 
 vec3pos_vec3norm_vec2tex_t::commands_t
@@ -142,29 +124,14 @@ vec3pos_vec2tex_t::vec3pos_vec2tex_t(glm::vec3&& p, glm::vec2&& t)
 
 buffers_t vec3pos_vec2tex_t::gen_buffers(GLuint vao,
                                          const std::vector<this_t>& in) {
-    auto buffers = gen_vertex_buffers(1);
-    bind_vao(vao);
-    for (GLuint id : buffers) {
-        bind_vbo<this_t>(id, in);
-    }
-    do_vertex_attrib_cmds(std::move(this_t::commands()));
-    bind_vao(0);
-    return buffers;
+    return generic_gen_buffers<this_t>(vao, in);
 }
 
 buffers_t vec3pos_vec2tex_t::gen_buffers(GLuint vao,
                                          const std::vector<this_t>& in,
                                          GLuint ebo,
                                          const std::vector<GLuint>& ebo_v) {
-    auto buffers = gen_vertex_buffers(1);
-    bind_vao(vao);
-    for (GLuint id : buffers) {
-        bind_vbo<this_t>(id, in);
-    }
-    bind_ebo(ebo, ebo_v);
-    do_vertex_attrib_cmds(std::move(this_t::commands()));
-    bind_vao(0);
-    return buffers;
+    return generic_gen_buffers<this_t>(vao, in, ebo, ebo_v);
 }
 
 vec3pos_vec2tex_t::commands_t vec3pos_vec2tex_t::commands() {
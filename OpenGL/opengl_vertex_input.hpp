@@ -144,6 +144,12 @@ public:
     static void update(GLuint id,
                        const std::vector<this_t>& in,
                        size_t offset = 0);
+
+    // Instance data streamed from a StreamBuffer: layout_stream() once, then
+    // bind_stream() with the offset of every frame's allocation
+    static void layout_stream(GLuint vao, GLuint index);
+    static void bind_stream(GLuint vao, GLuint index, GLuint buffer,
+                            GLintptr offset);
 };
 
 
@@ -165,6 +171,12 @@ public:
     static void update(GLuint id,
                        const std::vector<this_t>& in,
                        size_t offset = 0);
+
+    // Instance data streamed from a StreamBuffer: layout_stream() once, then
+    // bind_stream() with the offset of every frame's allocation
+    static void layout_stream(GLuint vao, GLuint index);
+    static void bind_stream(GLuint vao, GLuint index, GLuint buffer,
+                            GLintptr offset);
 };
 
 
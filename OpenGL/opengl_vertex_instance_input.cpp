@@ -1,67 +1,68 @@
+#include <cstddef>
+
 #include "opengl_vertex_input.hpp"
 
 
 namespace opengl {
 
+// update() may patch any instance buffer, so the storage is always dynamic
+// and usage is only kept as a hint in the signatures
 template<typename T> static GLuint
-generate_abo(const std::vector<T>& in, GLenum usage) {
-    static constexpr size_t SIZE = sizeof (T);
-    
-    GLuint abo;
-    SAFE_CALL(glGenBuffers(1, &abo));
-    SAFE_CALL(glBindBuffer(GL_ARRAY_BUFFER, abo));
-    SAFE_CALL(glBufferData(
-        GL_ARRAY_BUFFER,
-        sizeof(T) * in.size(),
-        in.data(),
-        usage
-    ));
-    SAFE_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+generate_abo(const std::vector<T>& in, GLenum) {
+    GLuint abo = gen_vertex_buffers();
+    buffer_storage(abo, in, GL_DYNAMIC_STORAGE_BIT);
     return abo;
 }
 
-static void layout_mat4(GLuint index, GLsizei total_size,
-                        GLsizei offset = sizeof(glm::vec4)) {
+// Instance attributes read from the binding named after the first attribute
+// of the input, stepping once per instance
+static void bind_instances(GLuint vao, GLuint binding, GLuint abo,
+                           GLsizei stride) {
+    SAFE_CALL(glVertexArrayVertexBuffer(vao, binding, abo, 0, stride));
+    SAFE_CALL(glVertexArrayBindingDivisor(vao, binding, 1));
+}
+
+static void layout_attrib(GLuint vao, GLuint index, GLuint binding,
+                          GLint size, GLenum type, GLuint offset) {
+    SAFE_CALL(glEnableVertexArrayAttrib(vao, index));
+    SAFE_CALL(glVertexArrayAttribFormat(vao, index, size, type, GL_FALSE,
+                                        offset));
+    SAFE_CALL(glVertexArrayAttribBinding(vao, index, binding));
+}
+
+static void layout_mat4(GLuint vao, GLuint index, GLuint binding,
+                        GLuint offset = 0) {
     for (GLuint i = 0; i < 4; i++) {
-        SAFE_CALL(glEnableVertexAttribArray(index + i));
-        SAFE_CALL(glVertexAttribPointer(
-            index + i,
-            4, // 4 floats
-            GL_FLOAT,
-            GL_FALSE,
-            total_size,
-            (void*)(offset * i)
-        ));
-        SAFE_CALL(glVertexAttribDivisor(index + i, 1));
+        layout_attrib(vao, index + i, binding, 4, GL_FLOAT,
+                      offset + sizeof(glm::vec4) * i);
     }
 }
 
-static void layout_float(GLuint index, GLuint total_size,
-                         GLsizei offset = sizeof(float)) {
-    SAFE_CALL(glEnableVertexAttribArray(index));
-    SAFE_CALL(glVertexAttribPointer(
-        index,
-        1, // 1 float
-        GL_FLOAT,
-        GL_FALSE,
-        total_size,
-        (void*)offset
-    ));
-    SAFE_CALL(glVertexAttribDivisor(index, 1));
+static void layout_float(GLuint vao, GLuint index, GLuint binding,
+                         GLuint offset = 0) {
+    layout_attrib(vao, index, binding, 1, GL_FLOAT, offset);
+}
+
+static void layout_uint32(GLuint vao, GLuint index, GLuint binding,
+                          GLuint offset = 0) {
+    layout_attrib(vao, index, binding, 1, GL_UNSIGNED_INT, offset);
+}
+
+// The buffer and its offset are attached per frame by bind_stream()
+static void layout_stream_attrib(GLuint vao, GLuint index, GLenum type) {
+    layout_attrib(vao, index, index, 1, type, 0);
+    SAFE_CALL(glVertexArrayBindingDivisor(vao, index, 1));
+}
+
+static void bind_stream_binding(GLuint vao, GLuint index, GLuint buffer,
+                                GLintptr offset, GLsizei stride) {
+    SAFE_CALL(glVertexArrayVertexBuffer(vao, index, buffer, offset, stride));
 }
 
-static void layout_uint32(GLuint index, GLuint size,
-                          GLsizei offset = sizeof(uint32_t)) {
-    SAFE_CALL(glEnableVertexAttribArray(index));
-    SAFE_CALL(glVertexAttribPointer(
-        index,
-        1, // 1 int
-        GL_UNSIGNED_INT,
-        GL_FALSE,
-        size,
-        (void*)offset
-    ));
-    SAFE_CALL(glVertexAttribDivisor(index, 1));
+template<typename T> static void
+update_abo(GLuint id, const std::vector<T>& in, size_t offset) {
+    SAFE_CALL(glNamedBufferSubData(id, offset, in.size() * sizeof(T),
+                                   in.data()));
 }
 
 
@@ -82,12 +83,9 @@ GLuint mat4_instanced::gen_buffer(GLuint vao,
                                   const std::vector<this_t>& in,
                                   GLuint index,
                                   GLenum usage) {
-    static constexpr GLuint SIZE_OF_THIS = sizeof(this_t);
-
     GLuint abo = generate_abo(in, usage);
-    buffer_bind_guard vao_lock({.vao = vao});
-    buffer_bind_guard abo_lock({.id = abo, .type = GL_ARRAY_BUFFER});
-    layout_mat4(index, sizeof(this_t));
+    bind_instances(vao, index, abo, sizeof(this_t));
+    layout_mat4(vao, index, index);
     return abo;
 }
 
@@ -110,22 +108,24 @@ GLuint float_instanced::gen_buffer(GLuint vao,
                                    GLuint index,
                                    GLenum usage) {
     GLuint abo = generate_abo(in, usage);
-    buffer_bind_guard vao_lock({.vao = vao});
-    buffer_bind_guard abo_lock({.id = abo, .type = GL_ARRAY_BUFFER});
-    layout_float(index, sizeof (this_t), 0);
+    bind_instances(vao, index, abo, sizeof(this_t));
+    layout_float(vao, index, index);
     return abo;
 }
 
 void float_instanced::update(GLuint id,
                              const std::vector<this_t>& frames,
                              size_t offset) {
-    buffer_bind_guard abo_bind({.id = id, .type = GL_ARRAY_BUFFER});
-    SAFE_CALL(glBufferSubData(
-        GL_ARRAY_BUFFER,
-        offset,
-        frames.size() * sizeof(this_t),
-        frames.data()
-    ));
+    update_abo(id, frames, offset);
+}
+
+void float_instanced::layout_stream(GLuint vao, GLuint index) {
+    layout_stream_attrib(vao, index, GL_FLOAT);
+}
+
+void float_instanced::bind_stream(GLuint vao, GLuint index, GLuint buffer,
+                                 GLintptr offset) {
+    bind_stream_binding(vao, index, buffer, offset, sizeof(this_t));
 }
 
 
@@ -147,22 +147,24 @@ GLuint uint32_instanced::gen_buffer(GLuint vao,
                                     GLuint index,
                                     GLenum usage) {
     GLuint abo = generate_abo(in, usage);
-    buffer_bind_guard vao_lock({.vao = vao});
-    buffer_bind_guard abo_lock({.id = abo, .type = GL_ARRAY_BUFFER});
-    layout_uint32(index, sizeof(this_t), 0);
+    bind_instances(vao, index, abo, sizeof(this_t));
+    layout_uint32(vao, index, index);
     return abo;
 }
 
 void uint32_instanced::update(GLuint id,
                               const std::vector<this_t>& in,
                               size_t offset) {
-    buffer_bind_guard abo_bind({.id = id, .type = GL_ARRAY_BUFFER});
-    SAFE_CALL(glBufferSubData(
-        GL_ARRAY_BUFFER,
-        offset,
-        in.size() * sizeof(this_t),
-        in.data()
-    ));
+    update_abo(id, in, offset);
+}
+
+void uint32_instanced::layout_stream(GLuint vao, GLuint index) {
+    layout_stream_attrib(vao, index, GL_UNSIGNED_INT);
+}
+
+void uint32_instanced::bind_stream(GLuint vao, GLuint index, GLuint buffer,
+                                  GLintptr offset) {
+    bind_stream_binding(vao, index, buffer, offset, sizeof(this_t));
 }
 
 
@@ -191,13 +193,10 @@ GLuint mat4_f_instanced::gen_buffer(GLuint vao,
                                     const std::vector<this_t>& in,
                                     GLuint index,
                                     GLenum usage) {
-    static constexpr GLuint SIZE_OF_THIS = sizeof(this_t);
-
     GLuint abo = generate_abo(in, usage);
-    buffer_bind_guard vao_lock({.vao = vao});
-    buffer_bind_guard abo_lock({.id = abo, .type = GL_ARRAY_BUFFER});
-    layout_mat4(index, SIZE_OF_THIS);
-    layout_float(index + 4, SIZE_OF_THIS, sizeof(glm::mat4));
+    bind_instances(vao, index, abo, sizeof(this_t));
+    layout_mat4(vao, index, index);
+    layout_float(vao, index + 4, index, offsetof(this_t, val));
     return abo;
 }
 
@@ -1,8 +1,14 @@
+#include <vector>
+#include <cstring>
 #include <iostream>
 #include <format>
+#include <algorithm>
+
+#include <Profiler/profiler.hpp>
 
 #include "opengl_proc.hpp"
 #include "texture.hpp"
+#include "worker_pool.hpp"
 
 
 namespace opengl {
@@ -24,13 +30,18 @@ texture_data_t texture_data_t::create_default_from_image(const ImageData& img) {
     return tex_data;
 }
 
+GLenum texture_data_t::internal_format() const {
+    return is_srgb ? srgb_internal_format(format)
+                   : sized_internal_format(format);
+}
+
 void texture_data_t::bind_with_image(const ImageData& image) {
     set_texture_meta(image.data, *this);
 }
 
 void texture_data_t::free() {
     if (id != 0 && Context::instance().is_context_active()) {
-        SAFE_CALL(glBindTexture(target, 0));
+        Context::instance().forget_texture(id);
         SAFE_CALL(glDeleteTextures(1, &id));
         id = 0;
     }
@@ -82,14 +93,7 @@ bool texture_data_array_2d_t::is_valid() const {
 }
 
 GLenum texture_data_array_2d_t::internal_format() const {
-    GLenum format = tex_data.format;
-    switch (format) {
-    case GL_RGB:  return GL_RGB8;
-    case GL_RGBA: return GL_RGBA8;
-    default:
-        std::cerr << "Invalid format " << format;
-        return 0;
-    }
+    return tex_data.internal_format();
 }
 
 GLsizei texture_data_array_2d_t::tile_offset(int x, int y) const {
@@ -118,67 +122,203 @@ void texture_data_array_2d_t::bind_with_image(const ImageData& image) {
 }
 
 
+GLenum sized_internal_format(GLint format) {
+    switch (format) {
+    case GL_RED:             return GL_R8;
+    case GL_RG:              return GL_RG8;
+    case GL_RGB:             return GL_RGB8;
+    case GL_RGBA:            return GL_RGBA8;
+    case GL_DEPTH_COMPONENT: return GL_DEPTH_COMPONENT24;
+    case GL_DEPTH_STENCIL:   return GL_DEPTH24_STENCIL8;
+    default:
+        std::cerr << "Invalid format " << format << std::endl;
+        return 0;
+    }
+}
+
+GLenum srgb_internal_format(GLint format) {
+    switch (format) {
+    case GL_RGB:  return GL_SRGB8;
+    case GL_RGBA: return GL_SRGB8_ALPHA8;
+    default:      return sized_internal_format(format);
+    }
+}
+
+bool is_mipmap_filter(GLint min_filter) {
+    return min_filter != GL_NEAREST && min_filter != GL_LINEAR;
+}
+
+void set_texture_params(const texture_data_t& params) {
+    const GLuint id = params.id;
+    SAFE_CALL(glTextureParameteri(id, GL_TEXTURE_WRAP_S, params.wrap_s));
+    SAFE_CALL(glTextureParameteri(id, GL_TEXTURE_WRAP_T, params.wrap_t));
+    SAFE_CALL(glTextureParameteri(id, GL_TEXTURE_MIN_FILTER,
+                                  params.min_filter));
+    SAFE_CALL(glTextureParameteri(id, GL_TEXTURE_MAG_FILTER,
+                                  params.mag_filter));
+}
+
+static GLsizei mip_levels(GLsizei w, GLsizei h) {
+    GLsizei levels = 1;
+    for (GLsizei size = std::max(w, h); size > 1; size >>= 1) { ++levels; }
+    return levels;
+}
+
+static size_t level_chain_bytes(GLsizei w, GLsizei h, GLint format,
+                                GLint min_filter) {
+    // drivers keep three channels in four
+    const size_t pixel = format == GL_RGB ? 4 : pixel_size(format);
+    const GLsizei levels = is_mipmap_filter(min_filter) ? mip_levels(w, h)
+                                                         : 1;
+    size_t out = 0;
+    for (GLsizei level = 0; level < levels; ++level) {
+        out += size_t(std::max(1, w >> level)) * size_t(std::max(1, h >> level))
+             * pixel;
+    }
+    return out;
+}
+
+size_t texture_bytes(const texture_data_t& params) {
+    return level_chain_bytes(params.w, params.h, params.format,
+                             params.min_filter);
+}
+
+size_t texture_bytes(const texture_data_array_2d_t& data) {
+    return level_chain_bytes(data.tile_w(), data.tile_h(),
+                             data.tex_data.format, data.tex_data.min_filter)
+         * size_t(data.total_tiles());
+}
+
 void set_texture_meta(byte_t* raw_data, const texture_data_t& params) {
-    SAFE_CALL(glBindTexture(params.target, params.id));
-    SAFE_CALL(glTexImage2D(params.target, 0, params.format, params.w, params.h,
-                           0, params.format, params.type, raw_data));
-    SAFE_CALL(glTexParameteri(params.target, GL_TEXTURE_WRAP_S, params.wrap_s));
-    SAFE_CALL(glTexParameteri(params.target, GL_TEXTURE_WRAP_T, params.wrap_t));
-    SAFE_CALL(glTexParameteri(params.target, GL_TEXTURE_MIN_FILTER,
-        params.min_filter));
-    SAFE_CALL(glTexParameteri(params.target, GL_TEXTURE_MAG_FILTER,
-        params.mag_filter));
-    SAFE_CALL(glBindTexture(params.target, 0));
+    const GLuint id = params.id;
+    const bool is_mipmapped = is_mipmap_filter(params.min_filter);
+    const GLsizei levels = is_mipmapped ? mip_levels(params.w, params.h) : 1;
+
+    set_texture_params(params);
+    SAFE_CALL(glTextureStorage2D(id, levels, params.internal_format(),
+                                 params.w, params.h));
+    if (raw_data == nullptr) { return; }
+
+    SAFE_CALL(glTextureSubImage2D(id, 0, 0, 0, params.w, params.h,
+                                  params.format, params.type, raw_data));
+    if (is_mipmapped) {
+        SAFE_CALL(glGenerateTextureMipmap(id));
+    }
 }
 
 void set_texture_2d_array_meta(byte_t* raw_data,
                                const texture_data_array_2d_t& data) {
-    const GLenum t = data.tex_data.target;
-    SAFE_CALL(glBindTexture(t, data.tex_data.id));
-
-    SAFE_CALL(glTexParameteri(t, GL_TEXTURE_BASE_LEVEL, 0));
-    SAFE_CALL(glTexParameteri(t, GL_TEXTURE_MAX_LEVEL, 1));
-    SAFE_CALL(glTexParameteri(t, GL_TEXTURE_MAG_FILTER,
-                              data.tex_data.mag_filter));
-    SAFE_CALL(glTexParameteri(t, GL_TEXTURE_MIN_FILTER,
-                              data.tex_data.min_filter));
-    SAFE_CALL(glTexParameteri(t, GL_TEXTURE_WRAP_S, data.tex_data.wrap_s));
-    SAFE_CALL(glTexParameteri(t, GL_TEXTURE_WRAP_T, data.tex_data.wrap_t));
-
-    GLsizei tile_width = data.tile_w();
-    GLsizei tile_height = data.tile_h();
-    GLsizei total_tiles = data.total_tiles();
-    SAFE_CALL(glTexStorage3D(
-        t,
-        1,
-        data.internal_format(),
-        tile_width,
-        tile_height,
-        total_tiles
-    ));
-
-    SAFE_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, data.tex_data.w));
-    SAFE_CALL(glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, data.tex_data.h));
-
-    for (GLsizei i = 0; i < total_tiles; ++i) {
-        int ix = i % data.tile_count_w;
-        int iy = i / data.tile_count_w;
-        int x = ix * tile_width;
-        int y = iy * tile_height;
-        byte_t* offset = raw_data + data.tile_offset(x, y);
-        SAFE_CALL(glTexSubImage3D(
-            t,
-            0,
-            0, 0, i,
-            data.tile_w(), data.tile_h(), 1,
-            data.tex_data.format,
-            data.tex_data.type,
-            offset
-        ));
+    PROFILE_ZONE("set_texture_2d_array_meta");
+    const GLuint id = data.tex_data.id;
+    const GLsizei tile_width = data.tile_w();
+    const GLsizei tile_height = data.tile_h();
+    const GLsizei total_tiles = data.total_tiles();
+    const bool is_mipmapped = is_mipmap_filter(data.tex_data.min_filter);
+    const GLsizei levels = is_mipmapped ? mip_levels(tile_width, tile_height)
+                                        : 1;
+
+    SAFE_CALL(glTextureParameteri(id, GL_TEXTURE_BASE_LEVEL, 0));
+    SAFE_CALL(glTextureParameteri(id, GL_TEXTURE_MAX_LEVEL, levels - 1));
+    set_texture_params(data.tex_data);
+    SAFE_CALL(glTextureStorage3D(id, levels, data.internal_format(),
+                                 tile_width, tile_height, total_tiles));
+    if (raw_data == nullptr || total_tiles == 0) { return; }
+
+    const size_t pixel = pixel_size(data.tex_data.format);
+    if (pixel == 0) {
+        std::cerr << "set_texture_2d_array_meta: unsupported format "
+                  << data.tex_data.format << ", nothing uploaded" << std::endl;
+        return;
+    }
+
+    // the tiles are laid out layer after layer straight into the unpack
+    // buffer, one upload call covers the whole array
+    const size_t bytes = size_t(tile_width) * size_t(tile_height)
+                       * size_t(total_tiles) * pixel;
+    auto& ctx = Context::instance();
+    GLuint pbo = gen_vertex_buffers();
+    SAFE_CALL(glNamedBufferStorage(pbo, bytes, nullptr, GL_MAP_WRITE_BIT));
+    void* mapped = glMapNamedBufferRange(pbo, 0, bytes, GL_MAP_WRITE_BIT
+                                         | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped == nullptr) {
+        std::cerr << "set_texture_2d_array_meta: unable to map "
+                  << bytes << " bytes" << std::endl;
+        ctx.forget_buffer(pbo);
+        SAFE_CALL(glDeleteBuffers(1, &pbo));
+        return;
+    }
+    retile_to_layers(raw_data, data, static_cast<byte_t*>(mapped));
+    SAFE_CALL(glUnmapNamedBuffer(pbo));
+
+    // the unpack state is global, the caller gets back what it had
+    GLint alignment = 4, row_length = 0, image_height = 0;
+    SAFE_CALL(glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment));
+    SAFE_CALL(glGetIntegerv(GL_UNPACK_ROW_LENGTH, &row_length));
+    SAFE_CALL(glGetIntegerv(GL_UNPACK_IMAGE_HEIGHT, &image_height));
+    SAFE_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    SAFE_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+    SAFE_CALL(glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0));
+
+    ctx.bind_buffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    SAFE_CALL(glTextureSubImage3D(id, 0, 0, 0, 0,
+                                  tile_width, tile_height, total_tiles,
+                                  data.tex_data.format, data.tex_data.type,
+                                  nullptr));
+    ctx.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    SAFE_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, alignment));
+    SAFE_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length));
+    SAFE_CALL(glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, image_height));
+
+    // GL keeps the storage until the copy is done
+    ctx.forget_buffer(pbo);
+    SAFE_CALL(glDeleteBuffers(1, &pbo));
+
+    if (levels > 1) { SAFE_CALL(glGenerateTextureMipmap(id)); }
+}
+
+size_t pixel_size(GLint format) {
+    switch (format) {
+    case GL_RED:  return 1;
+    case GL_RG:   return 2;
+    case GL_RGB:  return 3;
+    case GL_RGBA: return 4;
+    default:      return 0;
     }
+}
+
+void retile_to_layers(const byte_t* sheet,
+                      const texture_data_array_2d_t& data,
+                      byte_t* layers) {
+    PROFILE_ZONE("retile_to_layers");
+    static constexpr size_t MIN_BYTES_PER_THREAD = 1 << 20;
+
+    // an unknown format has no layout to copy
+    const size_t stride = pixel_size(data.tex_data.format);
+    if (stride == 0) { return; }
+    const size_t sheet_row = size_t(data.tex_data.w) * stride;
+    const size_t tile_row = size_t(data.tile_w()) * stride;
+    const size_t tile_rows = size_t(data.tile_h());
+    const size_t tiles = size_t(data.total_tiles());
+    if (tile_row == 0 || tile_rows == 0 || tiles == 0) { return; }
+
+    // memcpy is the vectorized row copy, the rows of a tile are contiguous
+    // in the layer
+    auto copy = [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            const size_t x = (i % data.tile_count_w) * tile_row;
+            const size_t y = (i / data.tile_count_w) * tile_rows;
+            const byte_t* from = sheet + y * sheet_row + x;
+            byte_t* to = layers + i * tile_rows * tile_row;
+            for (size_t r = 0; r < tile_rows; ++r) {
+                std::memcpy(to + r * tile_row, from + r * sheet_row,
+                            tile_row);
+            }
+        }
+    };
 
-    SAFE_CALL(glGenerateMipmap(t));
-    SAFE_CALL(glBindTexture(t, 0));
+    parallel_for(tiles, tiles * tile_rows * tile_row, MIN_BYTES_PER_THREAD,
+                 copy);
 }
 
 }
@@ -20,7 +20,9 @@ struct texture_data_t final {
     GLint format; // GL_DEPTH_COMPONENT GL_DEPTH_STENCIL GL_RED GL_RG GL_RGB GL_RGBA
     GLenum type; // GL_UNSIGNED_BYTE...
     GLenum wrap_s, wrap_t, min_filter, mag_filter;
+    bool is_srgb {false}; // colors stored sRGB encoded, sampled as linear
 
+    GLenum internal_format() const;
     void bind_with_image(const ImageData& image);
     void free();
     bool is_valid() const;
@@ -50,11 +52,40 @@ struct texture_data_array_2d_t final {
 
 using any_texture_t = std::variant<texture_data_t, texture_data_array_2d_t>;
 
+// GL_RGBA -> GL_RGBA8 and alike, 0 for unknown formats
+GLenum sized_internal_format(GLint format);
+// GL_RGB -> GL_SRGB8, GL_RGBA -> GL_SRGB8_ALPHA8, the rest as above
+GLenum srgb_internal_format(GLint format);
+
+// Bytes per pixel of GL_RED ... GL_RGBA with unsigned byte channels
+size_t pixel_size(GLint format);
+
+// Any of the *_MIPMAP_* min filters
+bool is_mipmap_filter(GLint min_filter);
+// Estimate of the video memory taken, from the format, the size and the
+// levels the min filter takes. Arrays count every layer.
+size_t texture_bytes(const texture_data_t& params);
+size_t texture_bytes(const texture_data_array_2d_t& data);
+// Wrap and filter parameters of params onto params.id
+void set_texture_params(const texture_data_t& params);
+
+// Both allocate immutable storage, they can be called once per texture id.
+// Resizing means a new texture. Mip levels follow the min filter, the array
+// goes up in one call from a pixel unpack buffer, the unpack state is left
+// as it was found.
 void set_texture_meta(byte_t* raw_data, const texture_data_t& params);
 void set_texture_2d_array_meta(
     byte_t* raw_data,
     const texture_data_array_2d_t&
 );
 
+// Copies the tiles of a sprite sheet layer after layer, in the order of
+// set_texture_2d_array_meta. layers takes tile_w * tile_h * total_tiles
+// pixels. Large sheets are split over threads, unknown formats copy
+// nothing.
+void retile_to_layers(const byte_t* sheet,
+                      const texture_data_array_2d_t& data,
+                      byte_t* layers);
+
 
 }
@@ -0,0 +1,321 @@
+#include <format>
+#include <limits>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+
+#include <Profiler/profiler.hpp>
+
+#include "opengl_proc.hpp"
+#include "texture_atlas.hpp"
+
+
+namespace opengl {
+
+MaxRectsBin::MaxRectsBin(int width, int height)
+    : width_(width)
+    , height_(height)
+    , free_({{0, 0, width, height}})
+{}
+
+std::optional<atlas_rect_t> MaxRectsBin::insert(int w, int h) {
+    if (w <= 0 || h <= 0) { return std::nullopt; }
+
+    const atlas_rect_t* best = nullptr;
+    int best_short = std::numeric_limits<int>::max();
+    int best_long = std::numeric_limits<int>::max();
+    for (const auto& rect : free_) {
+        if (rect.w < w || rect.h < h) { continue; }
+        const int dw = rect.w - w;
+        const int dh = rect.h - h;
+        const int short_side = std::min(dw, dh);
+        const int long_side = std::max(dw, dh);
+        if (short_side < best_short
+            || (short_side == best_short && long_side < best_long)) {
+            best = &rect;
+            best_short = short_side;
+            best_long = long_side;
+        }
+    }
+    if (best == nullptr) { return std::nullopt; }
+
+    const atlas_rect_t used {best->x, best->y, w, h};
+    split(used);
+    prune();
+    used_area_ += size_t(used.area());
+    return used;
+}
+
+float MaxRectsBin::occupancy() const {
+    return float(used_area_) / float(size_t(width_) * size_t(height_));
+}
+
+// Every free rectangle the placement overlaps gives way to the up to four
+// maximal rectangles around it
+void MaxRectsBin::split(const atlas_rect_t& used) {
+    std::vector<atlas_rect_t> out;
+    out.reserve(free_.size() + 4);
+    for (const auto& rect : free_) {
+        const bool overlaps = used.x < rect.x + rect.w
+                           && used.x + used.w > rect.x
+                           && used.y < rect.y + rect.h
+                           && used.y + used.h > rect.y;
+        if (!overlaps) {
+            out.push_back(rect);
+            continue;
+        }
+        if (used.x > rect.x) {
+            out.push_back({rect.x, rect.y, used.x - rect.x, rect.h});
+        }
+        if (used.x + used.w < rect.x + rect.w) {
+            out.push_back({used.x + used.w, rect.y,
+                           rect.x + rect.w - used.x - used.w, rect.h});
+        }
+        if (used.y > rect.y) {
+            out.push_back({rect.x, rect.y, rect.w, used.y - rect.y});
+        }
+        if (used.y + used.h < rect.y + rect.h) {
+            out.push_back({rect.x, used.y + used.h,
+                           rect.w, rect.y + rect.h - used.y - used.h});
+        }
+    }
+    free_ = std::move(out);
+}
+
+void MaxRectsBin::prune() {
+    auto contains = [](const atlas_rect_t& a, const atlas_rect_t& b) {
+        return b.x >= a.x && b.y >= a.y
+            && b.x + b.w <= a.x + a.w && b.y + b.h <= a.y + a.h;
+    };
+    for (size_t i = 0; i < free_.size(); ++i) {
+        for (size_t j = i + 1; j < free_.size();) {
+            if (contains(free_[i], free_[j])) {
+                free_.erase(free_.begin() + j);
+            } else if (contains(free_[j], free_[i])) {
+                free_.erase(free_.begin() + i);
+                --i;
+                break;
+            } else {
+                ++j;
+            }
+        }
+    }
+}
+
+
+static int align_up(int value, int alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Copies image into page at rect, then repeats its border rows and columns
+// over the gutter
+static void blit_with_gutter(ImageData& page, const ImageData& image,
+                             const atlas_rect_t& rect, int padding) {
+    const int channels = int(image.mode);
+    auto pixel = [&](int x, int y) {
+        x = std::clamp(x, 0, image.w - 1);
+        y = std::clamp(y, 0, image.h - 1);
+        return image.data + (size_t(y) * image.w + x) * channels;
+    };
+
+    for (int y = -padding; y < rect.h + padding; ++y) {
+        const int py = rect.y + y;
+        if (py < 0 || py >= page.h) { continue; }
+        for (int x = -padding; x < rect.w + padding; ++x) {
+            const int px = rect.x + x;
+            if (px < 0 || px >= page.w) { continue; }
+            const byte_t* from = pixel(x, y);
+            byte_t* to = page.data + (size_t(py) * page.w + px) * 4;
+            to[0] = from[0];
+            to[1] = from[1];
+            to[2] = from[2];
+            to[3] = channels == 4 ? from[3] : 255;
+        }
+    }
+}
+
+atlas_layout_t pack_atlas(const ImageManager& images,
+                          const atlas_config_t& config) {
+    PROFILE_ZONE("pack_atlas");
+    const int alignment = std::max(config.alignment, 1);
+    const int page_size = align_up(config.page_size, alignment);
+
+    struct item_t final {
+        const std::string* name;
+        const ImageData* image;
+        int w;
+        int h;
+    };
+    std::vector<item_t> items;
+    for (auto it = images.cbegin(); it != images.cend(); ++it) {
+        const auto& image = it->second;
+        if (!image.is_valid()) { continue; }
+        const int w = align_up(image.w + 2 * config.padding, alignment);
+        const int h = align_up(image.h + 2 * config.padding, alignment);
+        if (w > page_size || h > page_size) {
+            throw std::runtime_error(std::format(
+                "Image {} ({}x{}) does not fit a {} atlas page",
+                it->first, image.w, image.h, page_size
+            ));
+        }
+        items.push_back({&it->first, &image, w, h});
+    }
+    // big and long items first, the name keeps the order reproducible
+    std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+        const int side_a = std::max(a.w, a.h);
+        const int side_b = std::max(b.w, b.h);
+        if (side_a != side_b) { return side_a > side_b; }
+        if (a.w * a.h != b.w * b.h) { return a.w * a.h > b.w * b.h; }
+        return *a.name < *b.name;
+    });
+
+    atlas_layout_t layout {.page_size = page_size};
+    std::vector<MaxRectsBin> bins;
+    for (const auto& item : items) {
+        std::optional<atlas_rect_t> slot;
+        uint32_t layer = 0;
+        for (; layer < bins.size() && !slot; ++layer) {
+            slot = bins[layer].insert(item.w, item.h);
+        }
+        if (slot) {
+            --layer;
+        } else {
+            bins.emplace_back(page_size, page_size);
+            layout.pages.push_back(ImageData::create(page_size, page_size,
+                                                     glm::u8vec4(0)));
+            slot = bins.back().insert(item.w, item.h);
+            layer = uint32_t(bins.size() - 1);
+        }
+
+        const atlas_rect_t rect {
+            slot->x + config.padding,
+            slot->y + config.padding,
+            item.image->w,
+            item.image->h
+        };
+        blit_with_gutter(layout.pages[layer], *item.image, rect,
+                         config.padding);
+        const float size = float(page_size);
+        layout.entries[*item.name] = {
+            .uv = {rect.x / size, rect.y / size,
+                   (rect.x + rect.w) / size, (rect.y + rect.h) / size},
+            .layer = layer,
+            .rect = rect
+        };
+    }
+    return layout;
+}
+
+texture_data_t create_atlas_texture(const atlas_layout_t& layout,
+                                    GLenum min_filter) {
+    if (layout.pages.size() != 1) {
+        throw std::runtime_error(std::format(
+            "Atlas has {} pages, a single texture takes one",
+            layout.pages.size()
+        ));
+    }
+
+    texture_data_t texture {
+        .id         = gen_texture(GL_TEXTURE_2D),
+        .target     = GL_TEXTURE_2D,
+        .w          = layout.page_size,
+        .h          = layout.page_size,
+        .format     = GL_RGBA,
+        .type       = GL_UNSIGNED_BYTE,
+        .wrap_s     = GL_CLAMP_TO_EDGE,
+        .wrap_t     = GL_CLAMP_TO_EDGE,
+        .min_filter = min_filter,
+        .mag_filter = GL_LINEAR
+    };
+    texture.bind_with_image(layout.pages.front());
+    return texture;
+}
+
+// The pages stacked vertically are a sheet of one tile per page
+texture_data_array_2d_t create_atlas_array(const atlas_layout_t& layout,
+                                           GLenum min_filter) {
+    const int size = layout.page_size;
+    const size_t page_bytes = size_t(size) * size_t(size) * 4;
+    ImageData sheet;
+    sheet.w = size;
+    sheet.h = size * int(layout.pages.size());
+    sheet.mode = ColorMode::RGBA;
+    sheet.data = new byte_t[page_bytes * layout.pages.size()];
+    for (size_t i = 0; i < layout.pages.size(); ++i) {
+        std::copy(layout.pages[i].data, layout.pages[i].data + page_bytes,
+                  sheet.data + i * page_bytes);
+    }
+
+    texture_data_array_2d_t array {
+        .tex_data = {
+            .id         = gen_texture(GL_TEXTURE_2D_ARRAY),
+            .target     = GL_TEXTURE_2D_ARRAY,
+            .w          = sheet.w,
+            .h          = sheet.h,
+            .format     = GL_RGBA,
+            .type       = GL_UNSIGNED_BYTE,
+            .wrap_s     = GL_CLAMP_TO_EDGE,
+            .wrap_t     = GL_CLAMP_TO_EDGE,
+            .min_filter = min_filter,
+            .mag_filter = GL_LINEAR
+        },
+        .tile_count_w = 1,
+        .tile_count_h = layout.pages.size()
+    };
+    array.bind_with_image(sheet);
+    return array;
+}
+
+void save_atlas(const std::filesystem::path& dir,
+                const atlas_layout_t& layout) {
+    std::filesystem::create_directories(dir);
+    for (size_t i = 0; i < layout.pages.size(); ++i) {
+        const auto path = dir / std::format("page_{}.png", i);
+        if (!ImageData::write(path, layout.pages[i])) {
+            throw std::runtime_error(
+                std::format("Unable to write {}", path.string())
+            );
+        }
+    }
+
+    std::ofstream table(dir / "atlas.txt");
+    table << layout.page_size << ' ' << layout.pages.size() << '\n';
+    for (const auto& [name, entry] : layout.entries) {
+        table << std::quoted(name) << ' ' << entry.layer << ' '
+              << entry.rect.x << ' ' << entry.rect.y << ' '
+              << entry.rect.w << ' ' << entry.rect.h << '\n';
+    }
+}
+
+atlas_layout_t load_atlas(const std::filesystem::path& dir) {
+    std::ifstream table(dir / "atlas.txt");
+    if (!table) {
+        throw std::runtime_error(
+            std::format("No atlas table in {}", dir.string())
+        );
+    }
+
+    atlas_layout_t layout;
+    size_t pages = 0;
+    table >> layout.page_size >> pages;
+    for (size_t i = 0; i < pages; ++i) {
+        layout.pages.push_back(
+            ImageData::read(dir / std::format("page_{}.png", i))
+        );
+    }
+
+    std::string name;
+    atlas_entry_t entry;
+    const float size = float(layout.page_size);
+    while (table >> std::quoted(name) >> entry.layer >> entry.rect.x
+                 >> entry.rect.y >> entry.rect.w >> entry.rect.h) {
+        const auto& rect = entry.rect;
+        entry.uv = {rect.x / size, rect.y / size,
+                    (rect.x + rect.w) / size, (rect.y + rect.h) / size};
+        layout.entries[name] = entry;
+    }
+    return layout;
+}
+
+}
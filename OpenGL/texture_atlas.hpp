@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "texture.hpp"
+#include "image_data.hpp"
+#include "image_manager.hpp"
+
+
+namespace opengl {
+
+struct atlas_rect_t final {
+    int x {0};
+    int y {0};
+    int w {0};
+    int h {0};
+
+    bool operator==(const atlas_rect_t&) const = default;
+    int area() const { return w * h; }
+};
+
+// MaxRects bin with the best short side fit heuristic, free space is kept
+// as the maximal rectangles left over by every placement
+class MaxRectsBin final {
+public:
+    MaxRectsBin(int width, int height);
+
+    std::optional<atlas_rect_t> insert(int w, int h);
+    // Used area over the bin area
+    float occupancy() const;
+
+private:
+    void split(const atlas_rect_t& used);
+    void prune();
+
+private:
+    int width_;
+    int height_;
+    std::vector<atlas_rect_t> free_ {};
+    size_t used_area_               {0};
+};
+
+
+struct atlas_config_t final {
+    int page_size {2048};
+    // Pixels around each image repeating its edges, so bilinear and the
+    // first mips do not bleed the neighbours in
+    int padding   {2};
+    // Placements snap to it, a block of alignment pixels never straddles
+    // two images until mip log2(alignment)
+    int alignment {4};
+};
+
+// Where an image ended up. uv is u0 v0 u1 v1 in the page, v grows with the
+// ImageData rows like every texture made from an ImageData.
+struct atlas_entry_t final {
+    glm::vec4 uv       {0.0f};
+    uint32_t layer     {0};  // page
+    atlas_rect_t rect  {};   // pixels in the page, gutter excluded
+};
+
+struct atlas_layout_t final {
+    std::unordered_map<std::string, atlas_entry_t> entries {};
+    std::vector<ImageData> pages                           {}; // RGBA
+    int page_size                                          {0};
+};
+
+// Packs on the CPU, largest images first, a new page whenever no page
+// has room. Throws when an image does not fit an empty page.
+atlas_layout_t pack_atlas(const ImageManager& images,
+                          const atlas_config_t& config = {});
+
+// One page as a plain texture
+texture_data_t create_atlas_texture(const atlas_layout_t& layout,
+                                    GLenum min_filter = GL_LINEAR);
+// Every page as a layer, entry.layer picks it
+texture_data_array_2d_t create_atlas_array(const atlas_layout_t& layout,
+                                           GLenum min_filter = GL_LINEAR);
+
+// Offline packing: page_<n>.png plus atlas.txt with one
+// "name layer x y w h" line per entry, load_atlas reads both back
+void save_atlas(const std::filesystem::path& dir,
+                const atlas_layout_t& layout);
+atlas_layout_t load_atlas(const std::filesystem::path& dir);
+
+}
@@ -0,0 +1,701 @@
+#include <cmath>
+#include <array>
+#include <cfloat>
+#include <format>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <Profiler/profiler.hpp>
+
+#include "opengl_proc.hpp"
+#include "worker_pool.hpp"
+#include "texture_compression.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RENDER_BLOCKS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// S3TC is an extension glad was not generated with
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+
+namespace opengl {
+
+namespace {
+
+constexpr size_t MIN_BLOCKS_PER_THREAD = 256;
+constexpr uint32_t CACHE_MAGIC = 0x504d4342; // "BCMP"
+constexpr uint32_t CACHE_VERSION = 1;
+
+// The channels as planes, four pixels go through a vector at once
+struct block_t final {
+    alignas(16) float c[4][16];
+};
+
+block_t load_block(const byte_t* rgba) {
+    block_t block;
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 4; ++c) { block.c[c][i] = rgba[i * 4 + c]; }
+    }
+    return block;
+}
+
+using color_t = std::array<float, 4>;
+
+// Closest of the palette entries for each pixel over the channels
+// [first, first + count), returns the summed squared error
+float nearest(const block_t& block, const color_t* palette, int entries,
+              int first, int count, uint8_t* indices) {
+    float total = 0.0f;
+#if RENDER_BLOCKS_SSE2
+    for (int g = 0; g < 16; g += 4) {
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128 best_index = _mm_setzero_ps();
+        for (int e = 0; e < entries; ++e) {
+            __m128 dist = _mm_setzero_ps();
+            for (int c = first; c < first + count; ++c) {
+                const __m128 d = _mm_sub_ps(_mm_load_ps(&block.c[c][g]),
+                                            _mm_set1_ps(palette[e][c]));
+                dist = _mm_add_ps(dist, _mm_mul_ps(d, d));
+            }
+            const __m128 closer = _mm_cmplt_ps(dist, best);
+            best = _mm_min_ps(dist, best);
+            best_index = _mm_or_ps(
+                _mm_and_ps(closer, _mm_set1_ps(float(e))),
+                _mm_andnot_ps(closer, best_index)
+            );
+        }
+        alignas(16) float index[4], error[4];
+        _mm_store_ps(index, best_index);
+        _mm_store_ps(error, best);
+        for (int i = 0; i < 4; ++i) {
+            indices[g + i] = uint8_t(index[i]);
+            total += error[i];
+        }
+    }
+#else
+    for (int i = 0; i < 16; ++i) {
+        float best = FLT_MAX;
+        for (int e = 0; e < entries; ++e) {
+            float dist = 0.0f;
+            for (int c = first; c < first + count; ++c) {
+                const float d = block.c[c][i] - palette[e][c];
+                dist += d * d;
+            }
+            if (dist < best) {
+                best = dist;
+                indices[i] = uint8_t(e);
+            }
+        }
+        total += best;
+    }
+#endif
+    return total;
+}
+
+// Ends of the pixels along their principal axis over the channels
+// [0, count), only the pixels in mask take part
+void principal_ends(const block_t& block, int count, uint16_t mask,
+                    color_t& lo, color_t& hi) {
+    color_t mean {};
+    int used = 0;
+    for (int i = 0; i < 16; ++i) {
+        if (!(mask & (1 << i))) { continue; }
+        for (int c = 0; c < count; ++c) { mean[c] += block.c[c][i]; }
+        ++used;
+    }
+    lo = hi = mean;
+    if (used == 0) { return; }
+    for (int c = 0; c < count; ++c) { mean[c] /= float(used); }
+
+    float cov[4][4] {};
+    for (int i = 0; i < 16; ++i) {
+        if (!(mask & (1 << i))) { continue; }
+        for (int a = 0; a < count; ++a) {
+            for (int b = 0; b < count; ++b) {
+                cov[a][b] += (block.c[a][i] - mean[a])
+                           * (block.c[b][i] - mean[b]);
+            }
+        }
+    }
+    // power iteration, a few rounds settle a 4x4 covariance
+    color_t axis {1.0f, 1.0f, 1.0f, 1.0f};
+    for (int round = 0; round < 8; ++round) {
+        color_t next {};
+        float length = 0.0f;
+        for (int a = 0; a < count; ++a) {
+            for (int b = 0; b < count; ++b) { next[a] += cov[a][b] * axis[b]; }
+            length = std::max(length, std::abs(next[a]));
+        }
+        if (length < 1e-6f) { break; }
+        for (int a = 0; a < count; ++a) { axis[a] = next[a] / length; }
+    }
+    float norm = 0.0f;
+    for (int c = 0; c < count; ++c) { norm += axis[c] * axis[c]; }
+    norm = std::sqrt(norm);
+
+    float t_min = FLT_MAX, t_max = -FLT_MAX;
+    for (int i = 0; i < 16; ++i) {
+        if (!(mask & (1 << i))) { continue; }
+        float t = 0.0f;
+        for (int c = 0; c < count; ++c) {
+            t += (block.c[c][i] - mean[c]) * axis[c] / norm;
+        }
+        t_min = std::min(t_min, t);
+        t_max = std::max(t_max, t);
+    }
+    for (int c = 0; c < count; ++c) {
+        lo[c] = std::clamp(mean[c] + axis[c] / norm * t_min, 0.0f, 255.0f);
+        hi[c] = std::clamp(mean[c] + axis[c] / norm * t_max, 0.0f, 255.0f);
+    }
+}
+
+// Least squares ends for pixels taking lerp(a, b, weights[index]), false
+// when the indices do not pin them down
+bool refit(const block_t& block, int count, uint16_t mask,
+           const uint8_t* indices, const float* weights,
+           color_t& a, color_t& b) {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    color_t xa {}, xb {};
+    for (int i = 0; i < 16; ++i) {
+        if (!(mask & (1 << i))) { continue; }
+        const float w = weights[indices[i]];
+        aa += (1.0f - w) * (1.0f - w);
+        ab += (1.0f - w) * w;
+        bb += w * w;
+        for (int c = 0; c < count; ++c) {
+            xa[c] += (1.0f - w) * block.c[c][i];
+            xb[c] += w * block.c[c][i];
+        }
+    }
+    const float det = aa * bb - ab * ab;
+    if (std::abs(det) < 1e-6f) { return false; }
+    for (int c = 0; c < count; ++c) {
+        a[c] = std::clamp((bb * xa[c] - ab * xb[c]) / det, 0.0f, 255.0f);
+        b[c] = std::clamp((aa * xb[c] - ab * xa[c]) / det, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+uint16_t to_565(const color_t& color) {
+    const int r = int(color[0] * 31.0f / 255.0f + 0.5f);
+    const int g = int(color[1] * 63.0f / 255.0f + 0.5f);
+    const int b = int(color[2] * 31.0f / 255.0f + 0.5f);
+    return uint16_t((r << 11) | (g << 5) | b);
+}
+
+color_t from_565(uint16_t value) {
+    const int r = (value >> 11) & 31;
+    const int g = (value >> 5) & 63;
+    const int b = value & 31;
+    return {float((r << 3) | (r >> 2)), float((g << 2) | (g >> 4)),
+            float((b << 3) | (b >> 2)), 255.0f};
+}
+
+void put_u16(byte_t* out, uint16_t value) {
+    out[0] = byte_t(value);
+    out[1] = byte_t(value >> 8);
+}
+
+// Four colors, or with has_alpha and pixels under half alpha three colors
+// where index 3 reads as transparent
+void encode_bc1(const block_t& block, bool has_alpha, byte_t* out) {
+    uint16_t mask = 0xffff;
+    if (has_alpha) {
+        for (int i = 0; i < 16; ++i) {
+            if (block.c[3][i] < 128.0f) { mask &= uint16_t(~(1 << i)); }
+        }
+    }
+    const bool is_punched = mask != 0xffff;
+
+    color_t lo, hi;
+    principal_ends(block, 3, mask, lo, hi);
+
+    // 0, 1, 1/3 and 2/3 of the way for four colors, the middle for three
+    static constexpr float four_weights[] = {0.0f, 1.0f, 1.0f / 3.0f,
+                                             2.0f / 3.0f};
+    static constexpr float three_weights[] = {0.0f, 1.0f, 0.5f, 0.0f};
+    const float* weights = is_punched ? three_weights : four_weights;
+    const int entries = is_punched ? 3 : 4;
+
+    uint16_t best_c0 = 0, best_c1 = 0;
+    uint8_t best[16] {};
+    float best_error = FLT_MAX;
+    for (int pass = 0; pass < 2; ++pass) {
+        uint16_t c0 = to_565(hi), c1 = to_565(lo);
+        // four colors need c0 > c1, three colors c0 <= c1
+        if (is_punched ? c0 > c1 : c0 < c1) { std::swap(c0, c1); }
+
+        const color_t e0 = from_565(c0), e1 = from_565(c1);
+        color_t palette[4];
+        for (int i = 0; i < 4; ++i) {
+            for (int c = 0; c < 4; ++c) {
+                palette[i][c] = e0[c] + (e1[c] - e0[c]) * weights[i];
+            }
+        }
+        uint8_t indices[16];
+        // equal ends leave a single color, index 0 says it all
+        const float error = c0 == c1 && !is_punched
+            ? nearest(block, palette, 1, 0, 3, indices)
+            : nearest(block, palette, entries, 0, 3, indices);
+        if (error < best_error) {
+            best_error = error;
+            best_c0 = c0;
+            best_c1 = c1;
+            std::copy(indices, indices + 16, best);
+        }
+        color_t a = e0, b = e1;
+        if (pass == 1 || !refit(block, 3, mask, indices, weights, a, b)) {
+            break;
+        }
+        hi = a;
+        lo = b;
+    }
+
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; ++i) {
+        const uint32_t index = mask & (1 << i) ? best[i] : 3;
+        bits |= index << (2 * i);
+    }
+    put_u16(out, best_c0);
+    put_u16(out + 2, best_c1);
+    put_u16(out + 4, uint16_t(bits));
+    put_u16(out + 6, uint16_t(bits >> 16));
+}
+
+// BC4 over the alpha plane, 8 interpolated steps between min and max
+void encode_alpha(const block_t& block, byte_t* out) {
+    float lo = 255.0f, hi = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        lo = std::min(lo, block.c[3][i]);
+        hi = std::max(hi, block.c[3][i]);
+    }
+    const int a0 = int(hi + 0.5f), a1 = int(lo + 0.5f);
+    out[0] = byte_t(a0);
+    out[1] = byte_t(a1);
+
+    uint8_t indices[16] {};
+    if (a0 > a1) {
+        // entry j > 1 sits at (j - 1) / 7 of the way from a0 to a1
+        color_t palette[8] {};
+        palette[0][3] = float(a0);
+        palette[1][3] = float(a1);
+        for (int j = 2; j < 8; ++j) {
+            palette[j][3] = float(((8 - j) * a0 + (j - 1) * a1) / 7);
+        }
+        nearest(block, palette, 8, 3, 1, indices);
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < 16; ++i) {
+        bits |= uint64_t(indices[i]) << (3 * i);
+    }
+    for (int i = 0; i < 6; ++i) { out[2 + i] = byte_t(bits >> (8 * i)); }
+}
+
+// BC7 mode 6: one subset, RGBA ends of 7 bits plus a shared lsb each,
+// 4 bit indices
+constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30,
+                                 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct bc7_end_t final {
+    std::array<int, 4> value {}; // 7 bits
+    int p                    {0};
+
+    int channel(int c) const { return (value[c] << 1) | p; }
+};
+
+bc7_end_t quantize_bc7(const color_t& color) {
+    bc7_end_t best;
+    float best_error = FLT_MAX;
+    for (int p = 0; p < 2; ++p) {
+        bc7_end_t end {.p = p};
+        float error = 0.0f;
+        for (int c = 0; c < 4; ++c) {
+            end.value[c] = std::clamp(
+                int(std::lround((color[c] - float(p)) / 2.0f)), 0, 127
+            );
+            const float d = float(end.channel(c)) - color[c];
+            error += d * d;
+        }
+        if (error < best_error) {
+            best_error = error;
+            best = end;
+        }
+    }
+    return best;
+}
+
+class bit_writer_t final {
+public:
+    explicit bit_writer_t(byte_t* out) : out_(out) {
+        std::fill(out_, out_ + 16, byte_t(0));
+    }
+
+    void put(uint32_t value, int bits) {
+        for (int i = 0; i < bits; ++i, ++at_) {
+            if (value & (1u << i)) { out_[at_ / 8] |= byte_t(1 << (at_ % 8)); }
+        }
+    }
+
+private:
+    byte_t* out_;
+    int at_ {0};
+};
+
+void encode_bc7(const block_t& block, byte_t* out) {
+    color_t lo, hi;
+    principal_ends(block, 4, 0xffff, lo, hi);
+
+    static const auto weights = [] {
+        std::array<float, 16> table {};
+        for (int i = 0; i < 16; ++i) { table[i] = BC7_WEIGHTS[i] / 64.0f; }
+        return table;
+    }();
+
+    bc7_end_t best_ends[2];
+    uint8_t best[16] {};
+    float best_error = FLT_MAX;
+    for (int pass = 0; pass < 2; ++pass) {
+        const bc7_end_t e0 = quantize_bc7(lo), e1 = quantize_bc7(hi);
+        color_t palette[16];
+        for (int i = 0; i < 16; ++i) {
+            for (int c = 0; c < 4; ++c) {
+                palette[i][c] = float(((64 - BC7_WEIGHTS[i]) * e0.channel(c)
+                                      + BC7_WEIGHTS[i] * e1.channel(c) + 32)
+                                      >> 6);
+            }
+        }
+        uint8_t indices[16];
+        const float error = nearest(block, palette, 16, 0, 4, indices);
+        if (error < best_error) {
+            best_error = error;
+            best_ends[0] = e0;
+            best_ends[1] = e1;
+            std::copy(indices, indices + 16, best);
+        }
+        if (pass == 1 || !refit(block, 4, 0xffff, indices,
+                                weights.data(), lo, hi)) {
+            break;
+        }
+    }
+
+    // the anchor pixel stores 3 bits, its top bit has to be 0
+    if (best[0] >= 8) {
+        std::swap(best_ends[0], best_ends[1]);
+        for (auto& index : best) { index = uint8_t(15 - index); }
+    }
+
+    bit_writer_t bits(out);
+    bits.put(1 << 6, 7);
+    for (int c = 0; c < 4; ++c) {
+        bits.put(uint32_t(best_ends[0].value[c]), 7);
+        bits.put(uint32_t(best_ends[1].value[c]), 7);
+    }
+    bits.put(uint32_t(best_ends[0].p), 1);
+    bits.put(uint32_t(best_ends[1].p), 1);
+    bits.put(best[0], 3);
+    for (int i = 1; i < 16; ++i) { bits.put(best[i], 4); }
+}
+
+// The blocks of a level, edge pixels repeat into partial blocks
+std::vector<byte_t> compress_level(const ImageData& image,
+                                   BlockFormat format) {
+    const int channels = int(image.mode);
+    const int blocks_w = (image.w + 3) / 4;
+    const int blocks_h = (image.h + 3) / 4;
+    const size_t size = block_size(format);
+    std::vector<byte_t> out(size_t(blocks_w) * blocks_h * size);
+
+    parallel_for(size_t(blocks_h), size_t(blocks_w) * blocks_h,
+                 MIN_BLOCKS_PER_THREAD, [&](size_t first, size_t last) {
+        byte_t rgba[64];
+        for (int by = int(first); by < int(last); ++by) {
+            for (int bx = 0; bx < blocks_w; ++bx) {
+                for (int i = 0; i < 16; ++i) {
+                    const int x = std::min(bx * 4 + i % 4, image.w - 1);
+                    const int y = std::min(by * 4 + i / 4, image.h - 1);
+                    const byte_t* from = image.data
+                        + (size_t(y) * image.w + x) * channels;
+                    rgba[i * 4 + 0] = from[0];
+                    rgba[i * 4 + 1] = from[1];
+                    rgba[i * 4 + 2] = from[2];
+                    rgba[i * 4 + 3] = channels == 4 ? from[3] : 255;
+                }
+                encode_block(format, rgba,
+                             out.data() + (size_t(by) * blocks_w + bx) * size);
+            }
+        }
+    });
+    return out;
+}
+
+GLsizei level_bytes(const compressed_texture_t& texture, size_t level) {
+    return GLsizei(texture.levels[level].blocks.size());
+}
+
+compressed_texture_t compress_chains(const mip_chain_t* layers, size_t count,
+                                     const compression_config_t& config) {
+    PROFILE_ZONE("compress");
+    if (count == 0 || layers[0].levels.empty()) {
+        throw std::runtime_error("No levels to compress");
+    }
+
+    std::filesystem::path cached;
+    if (!config.cache_dir.empty()) {
+        const uint32_t settings[] = {
+            uint32_t(config.format), uint32_t(layers[0].is_srgb)
+        };
+        uint64_t hash = content_hash(settings, sizeof(settings));
+        for (size_t i = 0; i < count; ++i) {
+            for (const auto& level : layers[i].levels) {
+                hash = content_hash(level, hash);
+            }
+        }
+        cached = config.cache_dir / std::format("{:016x}.bc", hash);
+        if (auto texture = load_compressed(cached)) {
+            return std::move(*texture);
+        }
+    }
+
+    compressed_texture_t out {
+        .format = config.format,
+        .is_srgb = layers[0].is_srgb,
+        .layers = int(count)
+    };
+    const auto& base = layers[0].levels;
+    for (size_t l = 0; l < base.size(); ++l) {
+        compressed_level_t level {.w = base[l].w, .h = base[l].h};
+        for (size_t i = 0; i < count; ++i) {
+            const auto& levels = layers[i].levels;
+            if (l >= levels.size() || levels[l].w != level.w
+                || levels[l].h != level.h) {
+                throw std::runtime_error(std::format(
+                    "Layer chains differ at level {}", l
+                ));
+            }
+            auto blocks = compress_level(levels[l], config.format);
+            level.blocks.insert(level.blocks.end(), blocks.begin(),
+                                blocks.end());
+        }
+        out.levels.push_back(std::move(level));
+    }
+
+    if (!cached.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(config.cache_dir, error);
+        if (error || !save_compressed(cached, out)) {
+            std::cerr << "Unable to cache blocks in " << cached << std::endl;
+        }
+    }
+    return out;
+}
+
+}
+
+GLenum compressed_texture_t::internal_format() const {
+    switch (format) {
+    case BlockFormat::BC1:
+        return is_srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+                       : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case BlockFormat::BC3:
+        return is_srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+                       : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BlockFormat::BC7:
+        return is_srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+                       : GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+    return 0;
+}
+
+size_t compressed_texture_t::size() const {
+    size_t out = 0;
+    for (const auto& level : levels) { out += level.blocks.size(); }
+    return out;
+}
+
+size_t block_size(BlockFormat format) {
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+void encode_block(BlockFormat format, const byte_t* rgba, byte_t* out) {
+    const block_t block = load_block(rgba);
+    switch (format) {
+    case BlockFormat::BC1:
+        encode_bc1(block, true, out);
+        break;
+    case BlockFormat::BC3:
+        encode_alpha(block, out);
+        encode_bc1(block, false, out + 8);
+        break;
+    case BlockFormat::BC7:
+        encode_bc7(block, out);
+        break;
+    }
+}
+
+compressed_texture_t compress(const mip_chain_t& chain,
+                              const compression_config_t& config) {
+    return compress_chains(&chain, 1, config);
+}
+
+compressed_texture_t compress(const std::vector<mip_chain_t>& layers,
+                              const compression_config_t& config) {
+    return compress_chains(layers.data(), layers.size(), config);
+}
+
+bool save_compressed(const std::filesystem::path& path,
+                     const compressed_texture_t& texture) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    auto put = [&](uint32_t value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    put(CACHE_MAGIC);
+    put(CACHE_VERSION);
+    put(uint32_t(texture.format));
+    put(uint32_t(texture.is_srgb));
+    put(uint32_t(texture.layers));
+    put(uint32_t(texture.levels.size()));
+    for (const auto& level : texture.levels) {
+        put(uint32_t(level.w));
+        put(uint32_t(level.h));
+        put(uint32_t(level.blocks.size()));
+        file.write(reinterpret_cast<const char*>(level.blocks.data()),
+                   level.blocks.size());
+    }
+    return bool(file);
+}
+
+std::optional<compressed_texture_t> load_compressed(
+        const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) { return std::nullopt; }
+
+    auto get = [&]() {
+        uint32_t value = 0;
+        file.read(reinterpret_cast<char*>(&value), sizeof(value));
+        return value;
+    };
+    if (get() != CACHE_MAGIC || get() != CACHE_VERSION) {
+        return std::nullopt;
+    }
+    compressed_texture_t texture;
+    const uint32_t format = get();
+    texture.is_srgb = get() != 0;
+    texture.layers = int(get());
+    const uint32_t count = get();
+    if (!file || format > uint32_t(BlockFormat::BC7) || count == 0
+        || count > 32 || texture.layers <= 0) {
+        return std::nullopt;
+    }
+    texture.format = BlockFormat(format);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        compressed_level_t level;
+        level.w = int(get());
+        level.h = int(get());
+        const size_t bytes = get();
+        const size_t expected = size_t((level.w + 3) / 4)
+                              * size_t((level.h + 3) / 4)
+                              * size_t(texture.layers)
+                              * block_size(texture.format);
+        if (!file || level.w <= 0 || level.h <= 0 || bytes != expected) {
+            return std::nullopt;
+        }
+        level.blocks.resize(bytes);
+        file.read(reinterpret_cast<char*>(level.blocks.data()), bytes);
+        texture.levels.push_back(std::move(level));
+    }
+    if (!file) { return std::nullopt; }
+    return texture;
+}
+
+bool is_block_format_supported(BlockFormat format, bool is_srgb) {
+    if (format == BlockFormat::BC7) { return true; }
+    return GLAD_GL_EXT_texture_compression_s3tc
+        && (!is_srgb || GLAD_GL_EXT_texture_sRGB);
+}
+
+GLsizei set_compressed_storage(const compressed_texture_t& texture,
+                               const texture_data_t& params) {
+    if (texture.levels.empty()) { return 0; }
+    if (!is_block_format_supported(texture.format, texture.is_srgb)) {
+        std::cerr << "set_compressed_storage: no S3TC"
+                  << (texture.is_srgb ? " sRGB" : "") << " support"
+                  << std::endl;
+        return 0;
+    }
+    const GLsizei levels = is_mipmap_filter(params.min_filter)
+                         ? GLsizei(texture.levels.size()) : 1;
+    const auto& base = texture.levels.front();
+
+    set_texture_params(params);
+    SAFE_CALL(glTextureParameteri(params.id, GL_TEXTURE_MAX_LEVEL,
+                                  levels - 1));
+    if (params.target == GL_TEXTURE_2D_ARRAY) {
+        SAFE_CALL(glTextureStorage3D(params.id, levels,
+                                     texture.internal_format(),
+                                     base.w, base.h, texture.layers));
+    } else {
+        SAFE_CALL(glTextureStorage2D(params.id, levels,
+                                     texture.internal_format(),
+                                     base.w, base.h));
+    }
+    return levels;
+}
+
+void upload_compressed_level(const compressed_texture_t& texture,
+                             const texture_data_t& params, GLint level,
+                             const byte_t* blocks) {
+    const auto& data = texture.levels[level];
+    if (params.target == GL_TEXTURE_2D_ARRAY) {
+        SAFE_CALL(glCompressedTextureSubImage3D(
+            params.id, level, 0, 0, 0, data.w, data.h, texture.layers,
+            texture.internal_format(), level_bytes(texture, level), blocks
+        ));
+    } else {
+        SAFE_CALL(glCompressedTextureSubImage2D(
+            params.id, level, 0, 0, data.w, data.h,
+            texture.internal_format(), level_bytes(texture, level), blocks
+        ));
+    }
+}
+
+void set_compressed_texture(const compressed_texture_t& texture,
+                            const texture_data_t& params) {
+    PROFILE_ZONE("set_compressed_texture");
+    const GLsizei levels = set_compressed_storage(texture, params);
+    Context::instance().bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    for (GLint level = 0; level < levels; ++level) {
+        upload_compressed_level(texture, params, level,
+                                texture.levels[level].blocks.data());
+    }
+}
+
+void set_compressed_texture_2d_array(const compressed_texture_t& texture,
+                                     const texture_data_array_2d_t& data) {
+    if (texture.layers != data.total_tiles()) {
+        std::cerr << "set_compressed_texture_2d_array: " << texture.layers
+                  << " layers for " << data.total_tiles() << " tiles"
+                  << std::endl;
+        return;
+    }
+    set_compressed_texture(texture, data.tex_data);
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <filesystem>
+
+#include "texture.hpp"
+#include "texture_mips.hpp"
+
+
+namespace opengl {
+
+enum class BlockFormat {
+    BC1,  // RGB with 1 bit alpha, 8 bytes a 4x4 block
+    BC3,  // BC1 colors plus smooth alpha, 16 bytes
+    BC7   // RGBA, 16 bytes, the best looking of the three
+};
+
+// The 4x4 blocks of a level row after row, layer after layer for arrays
+struct compressed_level_t final {
+    int w                      {0};
+    int h                      {0};
+    std::vector<byte_t> blocks {};
+};
+
+struct compressed_texture_t final {
+    BlockFormat format                     {BlockFormat::BC7};
+    bool is_srgb                           {false};
+    int layers                             {1};
+    std::vector<compressed_level_t> levels {};
+
+    GLenum internal_format() const;
+    size_t size() const; // bytes of all levels
+};
+
+struct compression_config_t final {
+    BlockFormat format              {BlockFormat::BC7};
+    // Results are looked up and saved here when set, keyed by the pixels
+    // of every level and the format
+    std::filesystem::path cache_dir {};
+};
+
+size_t block_size(BlockFormat format);
+
+// BC7 is core, BC1 and BC3 need S3TC and their sRGB variants
+// EXT_texture_sRGB too. Asks the loaded GL, so after the context is up.
+bool is_block_format_supported(BlockFormat format, bool is_srgb);
+
+// 16 RGBA pixels row after row into block_size(format) bytes
+void encode_block(BlockFormat format, const byte_t* rgba, byte_t* out);
+
+// CPU only, the blocks of big levels are split over threads. The chains
+// decide sRGB, RGB images get an opaque alpha.
+compressed_texture_t compress(const mip_chain_t& chain,
+                              const compression_config_t& config = {});
+// One chain per layer of an array, all of the same size
+compressed_texture_t compress(const std::vector<mip_chain_t>& layers,
+                              const compression_config_t& config = {});
+
+bool save_compressed(const std::filesystem::path& path,
+                     const compressed_texture_t& texture);
+std::optional<compressed_texture_t> load_compressed(
+    const std::filesystem::path& path
+);
+
+// Immutable storage in the block format, 2D or 2D array after
+// params.target. The size comes from level 0 and the mip count follows
+// params.min_filter. Returns the levels allocated, 0 when the format is
+// not supported.
+GLsizei set_compressed_storage(const compressed_texture_t& texture,
+                               const texture_data_t& params);
+// One level from blocks, or when null from the bound pixel unpack buffer
+void upload_compressed_level(const compressed_texture_t& texture,
+                             const texture_data_t& params, GLint level,
+                             const byte_t* blocks);
+// Storage plus every level, one upload call each
+void set_compressed_texture(const compressed_texture_t& texture,
+                            const texture_data_t& params);
+void set_compressed_texture_2d_array(const compressed_texture_t& texture,
+                                     const texture_data_array_2d_t& data);
+
+}
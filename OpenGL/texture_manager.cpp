@@ -0,0 +1,518 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include <Profiler/profiler.hpp>
+
+#include "image_data.hpp"
+#include "opengl_proc.hpp"
+#include "texture_mips.hpp"
+#include "texture_manager.hpp"
+#include "texture_compression.hpp"
+
+
+namespace opengl {
+
+static bool is_array(const texture_request_t& request) {
+    return request.tile_count_w > 0 && request.tile_count_h > 0;
+}
+
+// The file or the image of the request, as RGBA
+static ImageData read_rgba(const texture_request_t& request) {
+    if (!request.image) { return ImageData::read(request.path); }
+    const ImageData& source = *request.image;
+    if (!source.is_valid() || source.mode == ColorMode::RGBA) {
+        return source;
+    }
+    ImageData out;
+    out.w = source.w;
+    out.h = source.h;
+    out.mode = ColorMode::RGBA;
+    out.data = new byte_t[out.size()];
+    const size_t channels = size_t(source.mode);
+    for (size_t i = 0; i < size_t(out.w) * size_t(out.h); ++i) {
+        std::memcpy(out.data + i * 4, source.data + i * channels, 3);
+        out.data[i * 4 + 3] = 255;
+    }
+    return out;
+}
+
+// One chain per layer, level 0 alone unless is_mipmapped
+static std::vector<mip_chain_t> build_layer_chains(
+        const std::vector<byte_t>& pixels, GLsizei w, GLsizei h,
+        GLsizei layers, const mip_config_t& config, bool is_mipmapped) {
+    std::vector<mip_chain_t> out;
+    const size_t layer_bytes = size_t(w) * size_t(h) * 4;
+    for (GLsizei i = 0; i < std::max<GLsizei>(layers, 1); ++i) {
+        ImageData layer;
+        layer.w = w;
+        layer.h = h;
+        layer.mode = ColorMode::RGBA;
+        layer.data = new byte_t[layer_bytes];
+        std::memcpy(layer.data, pixels.data() + i * layer_bytes, layer_bytes);
+
+        if (is_mipmapped) {
+            out.push_back(build_mip_chain(std::move(layer), config));
+        } else {
+            mip_chain_t chain {.is_srgb = config.is_srgb};
+            chain.levels.push_back(std::move(layer));
+            out.push_back(std::move(chain));
+        }
+    }
+    return out;
+}
+
+// Levels 1 and on, each holds that level of every layer one after another
+static std::vector<std::vector<byte_t>> flatten_mips(
+        const std::vector<mip_chain_t>& chains) {
+    std::vector<std::vector<byte_t>> out;
+    for (const auto& chain : chains) {
+        out.resize(chain.levels.size() - 1);
+        for (size_t l = 1; l < chain.levels.size(); ++l) {
+            const auto& level = chain.levels[l];
+            out[l - 1].insert(out[l - 1].end(), level.data,
+                              level.data + level.size());
+        }
+    }
+    return out;
+}
+
+TextureManager::~TextureManager() {
+    // queued decodes are skipped, the running ones finish
+    if (inbox_) {
+        std::lock_guard lock(inbox_->mutex);
+        inbox_->is_cancelled = true;
+    }
+    decoders_.reset();
+
+    for (auto& [key, any_texture] : map_) {
+        if (!owned_.contains(key)) { continue; }
+        std::visit(overloaded {
+            [](texture_data_t& tex)          { tex.free(); },
+            [](texture_data_array_2d_t& tex) { tex.free(); }
+        }, any_texture);
+    }
+    for (auto& upload : uploads_) {
+        if (!upload.is_created) { continue; }
+        std::visit(overloaded {
+            [](texture_data_t& tex)          { tex.free(); },
+            [](texture_data_array_2d_t& tex) { tex.free(); }
+        }, upload.texture);
+    }
+    placeholder_2d_.free();
+    placeholder_array_.free();
+    if (staging_ != 0 && Context::instance().is_context_active()) {
+        Context::instance().forget_buffer(staging_);
+        SAFE_CALL(glDeleteBuffers(1, &staging_));
+    }
+}
+
+void TextureManager::request(const std::string& key,
+                             const texture_request_t& request,
+                             on_ready_t done) {
+    if (done) { callbacks_[key].push_back(std::move(done)); }
+    if (state(key) == TextureState::LOADING) { return; }
+    if (!decoders_) {
+        inbox_ = std::make_shared<inbox_t>();
+        decoders_ = std::make_unique<WorkerPool>(DECODE_WORKERS, SIZE_MAX,
+                                                 "texture decode");
+    }
+    create_placeholders();
+
+    states_[key] = TextureState::LOADING;
+    ++stats_.requested;
+
+    decoders_->submit([inbox = inbox_, key, request]() {
+        {
+            std::lock_guard lock(inbox->mutex);
+            if (inbox->is_cancelled) { return; }
+        }
+
+        decoded_t out {.key = key, .request = request};
+        try {
+            auto image = read_rgba(request);
+            if (!image.is_valid()) {
+                throw std::runtime_error(request.image
+                    ? "Invalid image for " + key
+                    : "Unable to decode " + request.path.string());
+            }
+            // only the layout matters, the sheet is never uploaded
+            texture_data_array_2d_t sheet {
+                .tex_data = {
+                    .id         = 0,
+                    .target     = GL_TEXTURE_2D_ARRAY,
+                    .w          = image.w,
+                    .h          = image.h,
+                    .format     = GL_RGBA,
+                    .type       = GL_UNSIGNED_BYTE,
+                    .wrap_s     = GL_CLAMP_TO_EDGE,
+                    .wrap_t     = GL_CLAMP_TO_EDGE,
+                    .min_filter = request.min_filter,
+                    .mag_filter = GL_LINEAR,
+                    .is_srgb    = request.mips.is_srgb
+                },
+                .tile_count_w = request.tile_count_w,
+                .tile_count_h = request.tile_count_h
+            };
+            out.pixels.resize(size_t(image.size()));
+            if (is_array(request)) {
+                out.width = sheet.tile_w();
+                out.height = sheet.tile_h();
+                out.layers = sheet.total_tiles();
+                retile_to_layers(image.data, sheet, out.pixels.data());
+            } else {
+                out.width = image.w;
+                out.height = image.h;
+                std::memcpy(out.pixels.data(), image.data, out.pixels.size());
+            }
+            const bool is_mipmapped = is_mipmap_filter(request.min_filter);
+            if (request.compression) {
+                // BC7 is core, S3TC may be missing
+                auto config = *request.compression;
+                if (!is_block_format_supported(config.format,
+                                               request.mips.is_srgb)) {
+                    config.format = BlockFormat::BC7;
+                }
+                out.compressed = compress(
+                    build_layer_chains(out.pixels, out.width, out.height,
+                                       out.layers, request.mips,
+                                       is_mipmapped),
+                    config
+                );
+                out.pixels = {};
+            } else if (is_mipmapped) {
+                out.mips = flatten_mips(
+                    build_layer_chains(out.pixels, out.width, out.height,
+                                       out.layers, request.mips, true)
+                );
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "TextureManager: " << e.what() << std::endl;
+            out.is_failed = true;
+        }
+
+        std::lock_guard lock(inbox->mutex);
+        inbox->decoded.push_back(std::move(out));
+    });
+}
+
+void TextureManager::poll(size_t budget) {
+    PROFILE_ZONE("TextureManager::poll");
+    ++frame_;
+    if (!inbox_) { return; }
+    reload();
+
+    std::vector<decoded_t> decoded;
+    {
+        std::lock_guard lock(inbox_->mutex);
+        decoded.swap(inbox_->decoded);
+    }
+    for (auto& image : decoded) {
+        if (image.is_failed) {
+            finish(image.key, TextureState::FAILED);
+            continue;
+        }
+        uploads_.push_back({.image = std::move(image)});
+    }
+
+    // a texture is only published once all of it is uploaded
+    while (!uploads_.empty() && budget > 0) {
+        auto& front = uploads_.front();
+        if (!upload(front, budget)) { break; }
+
+        const auto key = front.image.key;
+        release(key);
+        map_[key] = std::move(front.texture);
+        owned_.insert(key);
+        track(key, front.bytes, true);
+        sources_[key] = front.image.request;
+        uploads_.pop_front();
+        finish(key, TextureState::RESIDENT);
+    }
+    evict();
+}
+
+TextureState TextureManager::state(const std::string& key) const {
+    auto it = states_.find(key);
+    if (it != states_.end()) { return it->second; }
+    return map_.contains(key) ? TextureState::RESIDENT
+                              : TextureState::MISSING;
+}
+
+size_t TextureManager::memory(const std::string& key) const {
+    auto it = resident_.find(key);
+    return it != resident_.end() ? it->second.bytes : 0;
+}
+
+size_t TextureManager::pending() const {
+    size_t out = 0;
+    for (const auto& [key, state] : states_) {
+        if (state == TextureState::LOADING) { ++out; }
+    }
+    return out;
+}
+
+void TextureManager::create_placeholders() {
+    if (placeholder_2d_.is_valid()) { return; }
+
+    auto image = ImageData::create(1, 1, placeholder_color_);
+    placeholder_2d_ = texture_data_t::create_default_from_image(image);
+    placeholder_array_ = texture_data_array_2d_t::create_default_from_image(
+        image, 1, 1
+    );
+}
+
+// Uploads slices of level 0, rows or layers, then the CPU built levels
+// through the orphaned staging buffer until the budget runs out. True once
+// the last of them went up.
+bool TextureManager::upload(upload_t& upload, size_t& budget) {
+    auto& image = upload.image;
+    const bool is_layered = image.layers > 0;
+    const GLsizei slices = is_layered ? image.layers : image.height;
+    const size_t slice_bytes = size_t(image.width) * 4
+                             * (is_layered ? size_t(image.height) : 1);
+
+    if (!upload.is_created) {
+        texture_data_t params {
+            .id         = gen_texture(is_layered ? GL_TEXTURE_2D_ARRAY
+                                                 : GL_TEXTURE_2D),
+            .target     = GLenum(is_layered ? GL_TEXTURE_2D_ARRAY
+                                            : GL_TEXTURE_2D),
+            .w          = image.width,
+            .h          = image.height,
+            .format     = GL_RGBA,
+            .type       = GL_UNSIGNED_BYTE,
+            .wrap_s     = GL_CLAMP_TO_EDGE,
+            .wrap_t     = GL_CLAMP_TO_EDGE,
+            .min_filter = image.request.min_filter,
+            .mag_filter = GL_LINEAR,
+            .is_srgb    = image.request.mips.is_srgb
+        };
+        if (is_layered) {
+            texture_data_array_2d_t array {
+                .tex_data = params,
+                .tile_count_w = image.request.tile_count_w,
+                .tile_count_h = image.request.tile_count_h
+            };
+            array.tex_data.w = image.width * GLsizei(array.tile_count_w);
+            array.tex_data.h = image.height * GLsizei(array.tile_count_h);
+            if (!image.compressed) {
+                set_texture_2d_array_meta(nullptr, array);
+            }
+            upload.texture = array;
+        } else {
+            if (!image.compressed) { set_texture_meta(nullptr, params); }
+            upload.texture = params;
+        }
+        upload.bytes = image.compressed
+            ? image.compressed->size()
+            : std::visit([](const auto& tex) { return texture_bytes(tex); },
+                         upload.texture);
+        // the blocks carry their own size and format
+        if (image.compressed) {
+            set_compressed_storage(*image.compressed, params);
+        }
+        upload.is_created = true;
+    }
+    if (image.compressed) { return upload_blocks(upload, budget); }
+
+    auto& ctx = Context::instance();
+    const GLuint id = std::visit(overloaded {
+        [](const texture_data_t& tex)          { return tex.id; },
+        [](const texture_data_array_2d_t& tex) { return tex.tex_data.id; }
+    }, upload.texture);
+    auto sub_image = [&](GLint level, GLint first, GLsizei w, GLsizei h,
+                         GLsizei count) {
+        ctx.bind_buffer(GL_PIXEL_UNPACK_BUFFER, staging_);
+        if (is_layered) {
+            SAFE_CALL(glTextureSubImage3D(id, level, 0, 0, first, w, h, count,
+                                          GL_RGBA, GL_UNSIGNED_BYTE,
+                                          nullptr));
+        } else {
+            SAFE_CALL(glTextureSubImage2D(id, level, 0, first, w, count,
+                                          GL_RGBA, GL_UNSIGNED_BYTE,
+                                          nullptr));
+        }
+        ctx.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    };
+
+    if (upload.next < slices) {
+        const GLsizei count = std::clamp<GLsizei>(
+            GLsizei(budget / slice_bytes), 1, slices - upload.next
+        );
+        const size_t bytes = size_t(count) * slice_bytes;
+        if (!stage(image.pixels.data() + upload.next * slice_bytes, bytes)) {
+            return false;
+        }
+        sub_image(0, upload.next, image.width, image.height, count);
+        upload.next += count;
+        budget -= std::min(budget, bytes);
+        ++stats_.uploads;
+        stats_.bytes += bytes;
+        if (upload.next < slices) { return false; }
+    }
+
+    // the next poll picks up the levels left
+    while (upload.level <= image.mips.size() && budget > 0) {
+        const auto& pixels = image.mips[upload.level - 1];
+        const GLint level = GLint(upload.level);
+        if (!stage(pixels.data(), pixels.size())) { return false; }
+        const GLsizei w = std::max(1, image.width >> level);
+        const GLsizei h = std::max(1, image.height >> level);
+        sub_image(level, 0, w, h, is_layered ? image.layers : h);
+        ++upload.level;
+        budget -= std::min(budget, pixels.size());
+        ++stats_.uploads;
+        stats_.bytes += pixels.size();
+    }
+    if (upload.level <= image.mips.size()) { return false; }
+
+    if (image.mips.empty() && is_mipmap_filter(image.request.min_filter)) {
+        SAFE_CALL(glGenerateTextureMipmap(id));
+    }
+    image.pixels = {};
+    image.mips = {};
+    return true;
+}
+
+// A level per slice, a texture of blocks has its mips already
+bool TextureManager::upload_blocks(upload_t& upload, size_t& budget) {
+    const auto& compressed = *upload.image.compressed;
+    const texture_data_t params = std::visit(overloaded {
+        [](const texture_data_t& tex)          { return tex; },
+        [](const texture_data_array_2d_t& tex) { return tex.tex_data; }
+    }, upload.texture);
+    const GLsizei levels = is_mipmap_filter(params.min_filter)
+                         ? GLsizei(compressed.levels.size()) : 1;
+
+    auto& ctx = Context::instance();
+    while (upload.next < levels && budget > 0) {
+        const auto& blocks = compressed.levels[upload.next].blocks;
+        if (!stage(blocks.data(), blocks.size())) { return false; }
+        ctx.bind_buffer(GL_PIXEL_UNPACK_BUFFER, staging_);
+        upload_compressed_level(compressed, params, upload.next, nullptr);
+        ctx.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        ++upload.next;
+        budget -= std::min(budget, blocks.size());
+        ++stats_.uploads;
+        stats_.bytes += blocks.size();
+    }
+    if (upload.next < levels) { return false; }
+
+    upload.image.compressed.reset();
+    return true;
+}
+
+// Orphaning hands back fresh storage, no wait on the previous copy
+bool TextureManager::stage(const byte_t* pixels, size_t bytes) {
+    if (staging_ == 0) { staging_ = gen_vertex_buffers(); }
+    SAFE_CALL(glNamedBufferData(staging_, bytes, nullptr, GL_STREAM_DRAW));
+    void* mapped = glMapNamedBufferRange(staging_, 0, bytes,
+                                         GL_MAP_WRITE_BIT
+                                         | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped == nullptr) { return false; }
+    std::memcpy(mapped, pixels, bytes);
+    SAFE_CALL(glUnmapNamedBuffer(staging_));
+    return true;
+}
+
+void TextureManager::finish(const std::string& key, TextureState state) {
+    states_[key] = state;
+    if (state == TextureState::RESIDENT) { ++stats_.resident; }
+    if (state == TextureState::FAILED) { ++stats_.failed; }
+
+    auto it = callbacks_.find(key);
+    if (it == callbacks_.end()) { return; }
+    auto callbacks = std::move(it->second);
+    callbacks_.erase(it);
+    for (auto& done : callbacks) { done(key, state); }
+}
+
+// Caller textures count but stay, the manager cannot bring them back
+void TextureManager::track(const std::string& key,
+                           const any_texture_t& texture) {
+    sources_.erase(key);
+    if (state(key) == TextureState::EVICTED) { states_.erase(key); }
+    track(key, std::visit([](const auto& tex) { return texture_bytes(tex); },
+                          texture),
+          false);
+}
+
+void TextureManager::track(const std::string& key, size_t bytes,
+                           bool is_evictable) {
+    auto& entry = resident_[key];
+    memory_.used = memory_.used - entry.bytes + bytes;
+    entry = {.bytes = bytes, .last_used = frame_,
+             .is_evictable = is_evictable};
+}
+
+void TextureManager::touch(const std::string& key) const {
+    auto it = resident_.find(key);
+    if (it != resident_.end()) {
+        it->second.last_used = frame_;
+    } else if (state(key) == TextureState::EVICTED) {
+        wanted_.insert(key);
+    }
+}
+
+void TextureManager::reload() {
+    for (const auto& key : wanted_) {
+        auto it = sources_.find(key);
+        if (it == sources_.end() || state(key) != TextureState::EVICTED) {
+            continue;
+        }
+        request(key, it->second);
+        ++memory_.reloads;
+    }
+    wanted_.clear();
+}
+
+void TextureManager::release(const std::string& key) {
+    if (!owned_.contains(key)) { return; }
+    auto it = map_.find(key);
+    if (it != map_.end()) {
+        std::visit(overloaded {
+            [](texture_data_t& tex)          { tex.free(); },
+            [](texture_data_array_2d_t& tex) { tex.free(); }
+        }, it->second);
+    }
+    owned_.erase(key);
+    // the caller's texture is never reloaded from the streamed source
+    sources_.erase(key);
+}
+
+// Least recently got first. What the last frame drew stays even over the
+// budget, reloading it every frame would cost more.
+void TextureManager::evict() {
+    if (memory_.budget == 0 || memory_.used <= memory_.budget) { return; }
+
+    std::vector<std::pair<uint64_t, std::string>> candidates;
+    for (const auto& [key, entry] : resident_) {
+        if (entry.is_evictable && entry.last_used + 1 < frame_) {
+            candidates.emplace_back(entry.last_used, key);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto& [last_used, key] : candidates) {
+        if (memory_.used <= memory_.budget) { break; }
+        auto it = map_.find(key);
+        if (it != map_.end()) {
+            std::visit(overloaded {
+                [](texture_data_t& tex)          { tex.free(); },
+                [](texture_data_array_2d_t& tex) { tex.free(); }
+            }, it->second);
+            map_.erase(it);
+        }
+        owned_.erase(key);
+        memory_.used -= resident_[key].bytes;
+        resident_.erase(key);
+        states_[key] = TextureState::EVICTED;
+        ++memory_.evictions;
+    }
+}
+
+}
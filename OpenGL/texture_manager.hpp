@@ -1,10 +1,19 @@
 #pragma once
 
+#include <deque>
+#include <mutex>
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <filesystem>
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "texture.hpp"
+#include "texture_mips.hpp"
+#include "texture_compression.hpp"
+#include "worker_pool.hpp"
 
 namespace opengl {
 
@@ -14,39 +23,82 @@ template<class... Ts>
 overloaded(Ts...) -> overloaded<Ts...>;
 
 
+enum class TextureState {
+    MISSING,  // never requested nor updated
+    LOADING,  // decoding or uploading, the placeholder stands in
+    RESIDENT,
+    FAILED,
+    EVICTED   // over the memory budget, the next get() brings it back
+};
+
+struct texture_request_t final {
+    std::filesystem::path path {};
+    // Pixels already in memory, read instead of path when set
+    std::shared_ptr<const ImageData> image {};
+    GLenum min_filter          {GL_LINEAR};
+    // Both above 0 make a texture_data_array_2d_t of the sheet
+    size_t tile_count_w        {0};
+    size_t tile_count_h        {0};
+    // How the workers build the mips when min_filter takes them
+    mip_config_t mips          {};
+    // Block compress on the workers too, mips included
+    std::optional<compression_config_t> compression {};
+};
+
+struct texture_streaming_stats_t final {
+    size_t requested {0};
+    size_t resident  {0};
+    size_t failed    {0};
+    size_t uploads   {0}; // sub image calls
+    size_t bytes     {0}; // uploaded
+};
+
+struct texture_memory_stats_t final {
+    size_t budget    {0}; // 0 for no limit
+    size_t used      {0}; // estimated, placeholders aside
+    size_t evictions {0};
+    size_t reloads   {0};
+};
+
+
 class TextureManager final {
 public:
     using texture_map_t  = std::unordered_map<std::string, any_texture_t>;
     using iterator       = texture_map_t::iterator;
     using const_iterator = texture_map_t::const_iterator;
+    using on_ready_t     = std::function<void(const std::string&,
+                                              TextureState)>;
 
     template <typename T> using maybe_texture_t = std::optional<
         std::reference_wrapper<const T>
     >;
 
+    static constexpr size_t DEFAULT_UPLOAD_BUDGET = 4 << 20;
+    static constexpr size_t DECODE_WORKERS        = 2;
+
     TextureManager() = default;
     TextureManager(texture_map_t&& map)
         : map_(std::move(map))
-    {}
-
-    ~TextureManager() {
-        for (auto& [key, any_texture] : map_) {
-            std::visit(overloaded {
-                [](texture_data_t& tex)          { tex.free(); },
-                [](texture_data_array_2d_t& tex) { tex.free(); }
-            }, any_texture);
-        }
+    {
+        for (const auto& [key, texture] : map_) { track(key, texture); }
     }
 
+    ~TextureManager();
+
     void update(const std::string& key, const any_texture_t& val) {
+        release(key);
         map_[key] = val;
+        track(key, val);
     }
 
     void update(const std::string& key, any_texture_t&& val) {
+        release(key);
         map_[key] = std::move(val);
+        track(key, map_[key]);
     }
 
     template<typename T> maybe_texture_t<T> get(const std::string& key) const {
+        touch(key);
         if (!map_.contains(key)) {
             return std::nullopt;
         }
@@ -57,6 +109,39 @@ public:
         return std::nullopt;
     }
 
+    // Streaming. request() returns at once, a worker decodes the file and
+    // builds its mips, poll() uploads it on the render thread through a
+    // pixel unpack buffer, at most budget bytes per call and at least one
+    // row (one layer for arrays) or mip level. done runs from poll() once
+    // the texture is resident or failed. Until then get_or_placeholder()
+    // answers with a 1x1 texture.
+    // Streamed textures belong to the manager, update() ones to the caller.
+    //
+    // Memory. Every texture counts towards the budget, streamed ones are
+    // evicted least recently got first once poll() finds it exceeded, and
+    // requested again from their file or image on the next get(). Call
+    // poll() once a frame, it counts the frames.
+    void request(const std::string& key, const texture_request_t& request,
+                 on_ready_t done = {});
+    void poll(size_t budget = DEFAULT_UPLOAD_BUDGET);
+    TextureState state(const std::string& key) const;
+    size_t pending() const;
+    const texture_streaming_stats_t& streaming_stats() const {
+        return stats_;
+    }
+    // Takes effect when set before the first request
+    void placeholder_color(glm::u8vec4 color) { placeholder_color_ = color; }
+    // Bytes, 0 lifts the limit
+    void memory_budget(size_t bytes) { memory_.budget = bytes; }
+    const texture_memory_stats_t& memory_stats() const { return memory_; }
+    size_t memory(const std::string& key) const;
+
+    template<typename T> const T& get_or_placeholder(
+            const std::string& key) {
+        if (auto texture = get<T>(key)) { return texture->get(); }
+        return placeholder<T>();
+    }
+
     bool contains(const std::string& key) const {
         return map_.contains(key);
     }
@@ -77,8 +162,92 @@ public:
         return map_.end();
     }
 
+private:
+    struct decoded_t final {
+        std::string key                  {};
+        texture_request_t request        {};
+        std::vector<byte_t> pixels       {}; // RGBA, layer after layer
+        GLsizei width                    {0};
+        GLsizei height                   {0};
+        GLsizei layers                   {0}; // 0 for plain textures
+        // levels 1 and on, layer after layer
+        std::vector<std::vector<byte_t>> mips {};
+        // takes over pixels and mips when the request compresses
+        std::optional<compressed_texture_t> compressed {};
+        bool is_failed                   {false};
+    };
+
+    // Shared with the decode tasks, they may outlive the manager
+    struct inbox_t final {
+        std::mutex mutex               {};
+        std::vector<decoded_t> decoded {};
+        bool is_cancelled              {false};
+    };
+
+    struct upload_t final {
+        decoded_t image          {};
+        any_texture_t texture    {};
+        // rows, layers for arrays or levels of a compressed texture
+        GLsizei next             {0};
+        size_t level             {1}; // next of the mips
+        size_t bytes             {0}; // of the whole texture
+        bool is_created          {false};
+    };
+
+    struct resident_t final {
+        size_t bytes               {0};
+        mutable uint64_t last_used {0}; // frame of the last get()
+        bool is_evictable          {false};
+    };
+
+    template<typename T> const T& placeholder();
+    void create_placeholders();
+    bool upload(upload_t& upload, size_t& budget);
+    bool upload_blocks(upload_t& upload, size_t& budget);
+    bool stage(const byte_t* pixels, size_t bytes);
+    void finish(const std::string& key, TextureState state);
+    // Frees the texture under key when the manager owns it
+    void release(const std::string& key);
+    void track(const std::string& key, const any_texture_t& texture);
+    void track(const std::string& key, size_t bytes, bool is_evictable);
+    void touch(const std::string& key) const;
+    void reload();
+    void evict();
+
 private:
     texture_map_t map_;
+
+    std::unordered_map<std::string, TextureState> states_ {};
+    std::unordered_set<std::string> owned_                {};
+    std::unordered_map<std::string, resident_t> resident_ {};
+    // what brings an evicted texture back
+    std::unordered_map<std::string, texture_request_t> sources_ {};
+    mutable std::unordered_set<std::string> wanted_       {};
+    uint64_t frame_                                       {0};
+    texture_memory_stats_t memory_                        {};
+    std::unordered_map<std::string,
+                       std::vector<on_ready_t>> callbacks_ {};
+    std::shared_ptr<inbox_t> inbox_                       {};
+    std::unique_ptr<WorkerPool> decoders_                 {};
+    std::deque<upload_t> uploads_                         {};
+    GLuint staging_                                       {0};
+    texture_data_t placeholder_2d_                        {};
+    texture_data_array_2d_t placeholder_array_            {};
+    glm::u8vec4 placeholder_color_                        {128, 128, 128,
+                                                           255};
+    texture_streaming_stats_t stats_                      {};
 };
 
+template<> inline const texture_data_t&
+TextureManager::placeholder<texture_data_t>() {
+    create_placeholders();
+    return placeholder_2d_;
+}
+
+template<> inline const texture_data_array_2d_t&
+TextureManager::placeholder<texture_data_array_2d_t>() {
+    create_placeholders();
+    return placeholder_array_;
+}
+
 }
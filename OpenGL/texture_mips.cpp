@@ -0,0 +1,518 @@
+#include <cmath>
+#include <array>
+#include <format>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+
+#include <Profiler/profiler.hpp>
+
+#include "opengl_proc.hpp"
+#include "worker_pool.hpp"
+#include "texture_mips.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RENDER_MIPS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+
+namespace opengl {
+
+namespace {
+
+constexpr size_t MIN_PIXELS_PER_THREAD = 1 << 16;
+constexpr uint32_t CACHE_MAGIC = 0x5350494d; // "MIPS"
+constexpr uint32_t CACHE_VERSION = 1;
+
+// One RGBA pixel of floats
+#if RENDER_MIPS_SSE2
+using lane_t = __m128;
+lane_t load(const float* p) { return _mm_loadu_ps(p); }
+void store(float* p, lane_t v) { _mm_storeu_ps(p, v); }
+lane_t add(lane_t a, lane_t b) { return _mm_add_ps(a, b); }
+lane_t scale(lane_t a, float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+#else
+struct lane_t final { float v[4]; };
+lane_t load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+void store(float* p, lane_t v) { std::copy(v.v, v.v + 4, p); }
+lane_t add(lane_t a, lane_t b) {
+    return {{a.v[0] + b.v[0], a.v[1] + b.v[1],
+             a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+}
+lane_t scale(lane_t a, float s) {
+    return {{a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s}};
+}
+#endif
+
+struct srgb_tables_t final {
+    std::array<float, 256> to_linear {};
+    std::array<byte_t, 4096> to_srgb {};
+};
+
+const srgb_tables_t& srgb_tables() {
+    static const srgb_tables_t tables = [] {
+        srgb_tables_t out;
+        for (size_t i = 0; i < out.to_linear.size(); ++i) {
+            const double c = double(i) / 255.0;
+            out.to_linear[i] = float(c <= 0.04045
+                ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+        }
+        for (size_t i = 0; i < out.to_srgb.size(); ++i) {
+            const double l = double(i) / double(out.to_srgb.size() - 1);
+            const double c = l <= 0.0031308
+                ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+            out.to_srgb[i] = byte_t(std::lround(c * 255.0));
+        }
+        return out;
+    }();
+    return tables;
+}
+
+// Filters of width 3 destination pixels, alpha 4, sampled at the 12 source
+// pixels around a destination pixel
+constexpr int KAISER_TAPS = 12;
+
+const std::array<float, KAISER_TAPS>& kaiser_weights() {
+    static const auto weights = [] {
+        constexpr double width = 3.0;
+        constexpr double alpha = 4.0;
+        constexpr double pi = 3.14159265358979323846;
+        auto bessel_i0 = [](double x) {
+            double sum = 1.0, term = 1.0;
+            for (int k = 1; k < 32; ++k) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+            }
+            return sum;
+        };
+
+        std::array<float, KAISER_TAPS> out {};
+        double total = 0.0;
+        std::array<double, KAISER_TAPS> raw {};
+        for (int k = 0; k < KAISER_TAPS; ++k) {
+            // distance in destination pixels between the centers
+            const double d = (k - (KAISER_TAPS - 1) / 2.0) / 2.0;
+            const double sinc = std::sin(pi * d) / (pi * d);
+            const double t = d / width;
+            const double window =
+                bessel_i0(alpha * std::sqrt(std::max(0.0, 1.0 - t * t)))
+                / bessel_i0(alpha);
+            raw[k] = sinc * window;
+            total += raw[k];
+        }
+        for (int k = 0; k < KAISER_TAPS; ++k) {
+            out[k] = float(raw[k] / total);
+        }
+        return out;
+    }();
+    return weights;
+}
+
+// RGBA floats, linear light for sRGB sources
+struct float_image_t final {
+    std::vector<float> pixels {};
+    int w                     {0};
+    int h                     {0};
+
+    float* row(int y) { return pixels.data() + size_t(y) * w * 4; }
+    const float* row(int y) const {
+        return pixels.data() + size_t(y) * w * 4;
+    }
+};
+
+float_image_t to_float(const ImageData& image, bool is_srgb) {
+    const auto& tables = srgb_tables();
+    const int channels = int(image.mode);
+    float_image_t out {
+        .pixels = std::vector<float>(size_t(image.w) * image.h * 4),
+        .w = image.w,
+        .h = image.h
+    };
+    parallel_for(size_t(image.h), out.pixels.size() / 4,
+                 MIN_PIXELS_PER_THREAD, [&](size_t first, size_t last) {
+        const size_t end = last * image.w;
+        for (size_t i = first * image.w; i < end; ++i) {
+            const byte_t* from = image.data + i * channels;
+            float* to = out.pixels.data() + i * 4;
+            for (int c = 0; c < 3; ++c) {
+                to[c] = is_srgb ? tables.to_linear[from[c]]
+                                : from[c] / 255.0f;
+            }
+            to[3] = channels == 4 ? from[3] / 255.0f : 1.0f;
+        }
+    });
+    return out;
+}
+
+ImageData to_bytes(const float_image_t& level, ColorMode mode,
+                   bool is_srgb) {
+    const auto& tables = srgb_tables();
+    const int channels = int(mode);
+    ImageData out;
+    out.w = level.w;
+    out.h = level.h;
+    out.mode = mode;
+    out.data = new byte_t[out.size()];
+
+    const float top = float(tables.to_srgb.size() - 1);
+    parallel_for(size_t(level.h), level.pixels.size() / 4,
+                 MIN_PIXELS_PER_THREAD, [&](size_t first, size_t last) {
+        const size_t end = last * level.w;
+        for (size_t i = first * level.w; i < end; ++i) {
+            const float* from = level.pixels.data() + i * 4;
+            byte_t* to = out.data + i * channels;
+            for (int c = 0; c < channels; ++c) {
+                const float v = std::clamp(from[c], 0.0f, 1.0f);
+                to[c] = is_srgb && c < 3
+                    ? tables.to_srgb[size_t(v * top + 0.5f)]
+                    : byte_t(v * 255.0f + 0.5f);
+            }
+        }
+    });
+    return out;
+}
+
+float_image_t box_float(const float_image_t& src) {
+    float_image_t dst {.w = std::max(1, src.w / 2),
+                       .h = std::max(1, src.h / 2)};
+    dst.pixels.resize(size_t(dst.w) * dst.h * 4);
+    parallel_for(size_t(dst.h), dst.pixels.size() / 4,
+                 MIN_PIXELS_PER_THREAD, [&](size_t first, size_t last) {
+        for (int y = int(first); y < int(last); ++y) {
+            const float* r0 = src.row(std::min(2 * y, src.h - 1));
+            const float* r1 = src.row(std::min(2 * y + 1, src.h - 1));
+            float* to = dst.pixels.data() + size_t(y) * dst.w * 4;
+            for (int x = 0; x < dst.w; ++x) {
+                const int x0 = std::min(2 * x, src.w - 1) * 4;
+                const int x1 = std::min(2 * x + 1, src.w - 1) * 4;
+                const lane_t sum = add(add(load(r0 + x0), load(r0 + x1)),
+                                       add(load(r1 + x0), load(r1 + x1)));
+                store(to + x * 4, scale(sum, 0.25f));
+            }
+        }
+    });
+    return dst;
+}
+
+// Separable, rows first into tmp then columns
+float_image_t kaiser_float(const float_image_t& src) {
+    const auto& weights = kaiser_weights();
+    constexpr int first_tap = -(KAISER_TAPS / 2 - 1);
+
+    float_image_t tmp {.w = std::max(1, src.w / 2), .h = src.h};
+    tmp.pixels.resize(size_t(tmp.w) * tmp.h * 4);
+    parallel_for(size_t(tmp.h), tmp.pixels.size() / 4,
+                 MIN_PIXELS_PER_THREAD, [&](size_t first, size_t last) {
+        for (int y = int(first); y < int(last); ++y) {
+            const float* from = src.row(y);
+            float* to = tmp.row(y);
+            for (int x = 0; x < tmp.w; ++x) {
+                lane_t sum = scale(load(from), 0.0f);
+                for (int k = 0; k < KAISER_TAPS; ++k) {
+                    const int sx = std::clamp(2 * x + first_tap + k,
+                                              0, src.w - 1);
+                    sum = add(sum, scale(load(from + sx * 4), weights[k]));
+                }
+                store(to + x * 4, sum);
+            }
+        }
+    });
+
+    float_image_t dst {.w = tmp.w, .h = std::max(1, src.h / 2)};
+    dst.pixels.resize(size_t(dst.w) * dst.h * 4);
+    parallel_for(size_t(dst.h), dst.pixels.size() / 4,
+                 MIN_PIXELS_PER_THREAD, [&](size_t first, size_t last) {
+        for (int y = int(first); y < int(last); ++y) {
+            float* to = dst.row(y);
+            for (int x = 0; x < dst.w; ++x) {
+                lane_t sum = scale(load(tmp.row(0)), 0.0f);
+                for (int k = 0; k < KAISER_TAPS; ++k) {
+                    const int sy = std::clamp(2 * y + first_tap + k,
+                                              0, tmp.h - 1);
+                    sum = add(sum,
+                              scale(load(tmp.row(sy) + x * 4), weights[k]));
+                }
+                store(to + x * 4, sum);
+            }
+        }
+    });
+    return dst;
+}
+
+// 2x2 rounded average straight on the bytes, the common linear case
+ImageData box_bytes(const ImageData& src) {
+    const int channels = int(src.mode);
+    ImageData dst;
+    dst.w = std::max(1, src.w / 2);
+    dst.h = std::max(1, src.h / 2);
+    dst.mode = src.mode;
+    dst.data = new byte_t[dst.size()];
+
+    const size_t src_row = size_t(src.w) * channels;
+    const size_t dst_row = size_t(dst.w) * channels;
+    parallel_for(size_t(dst.h), size_t(dst.w) * dst.h,
+                 MIN_PIXELS_PER_THREAD, [&](size_t first, size_t last) {
+        for (int y = int(first); y < int(last); ++y) {
+            const byte_t* r0 = src.data
+                             + size_t(std::min(2 * y, src.h - 1)) * src_row;
+            const byte_t* r1 = src.data
+                             + size_t(std::min(2 * y + 1, src.h - 1))
+                             * src_row;
+            byte_t* to = dst.data + size_t(y) * dst_row;
+            int x = 0;
+#if RENDER_MIPS_SSE2
+            // 8 source pixels of 2 rows into 4, 16 bit sums
+            if (channels == 4) {
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i two = _mm_set1_epi16(2);
+                for (; x + 4 <= dst.w && 2 * (x + 4) <= src.w; x += 4) {
+                    auto wide = [&](const byte_t* row, int offset) {
+                        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                            row + size_t(2 * x + offset) * 4
+                        ));
+                    };
+                    const __m128i a = wide(r0, 0), b = wide(r0, 4);
+                    const __m128i c = wide(r1, 0), d = wide(r1, 4);
+                    // pixel pairs summed over both rows
+                    const __m128i s0 = _mm_add_epi16(
+                        _mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(c, zero));
+                    const __m128i s1 = _mm_add_epi16(
+                        _mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(c, zero));
+                    const __m128i s2 = _mm_add_epi16(
+                        _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(d, zero));
+                    const __m128i s3 = _mm_add_epi16(
+                        _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(d, zero));
+                    // then each pair folded, the low half holds the sum
+                    auto fold = [](__m128i s) {
+                        return _mm_add_epi16(s, _mm_srli_si128(s, 8));
+                    };
+                    __m128i lo = _mm_unpacklo_epi64(fold(s0), fold(s1));
+                    __m128i hi = _mm_unpacklo_epi64(fold(s2), fold(s3));
+                    lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+                    hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(to + x * 4),
+                                     _mm_packus_epi16(lo, hi));
+                }
+            }
+#endif
+            for (; x < dst.w; ++x) {
+                const size_t x0 = size_t(std::min(2 * x, src.w - 1))
+                                * channels;
+                const size_t x1 = size_t(std::min(2 * x + 1, src.w - 1))
+                                * channels;
+                for (int c = 0; c < channels; ++c) {
+                    const int sum = r0[x0 + c] + r0[x1 + c]
+                                  + r1[x0 + c] + r1[x1 + c];
+                    to[size_t(x) * channels + c] = byte_t((sum + 2) >> 2);
+                }
+            }
+        }
+    });
+    return dst;
+}
+
+// The pixels and everything that changes the result
+std::string cache_name(const ImageData& image, const mip_config_t& config) {
+    const int32_t settings[] = {
+        int32_t(config.filter), int32_t(config.is_srgb)
+    };
+    const uint64_t hash = content_hash(
+        settings, sizeof(settings), content_hash(image)
+    );
+    return std::format("{:016x}.mips", hash);
+}
+
+// Rows of RGB levels are not 4 byte aligned, the caller gets its state back
+struct unpack_alignment_guard_t final {
+    GLint alignment {4};
+
+    unpack_alignment_guard_t() {
+        SAFE_CALL(glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment));
+        SAFE_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        Context::instance().bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    ~unpack_alignment_guard_t() {
+        SAFE_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, alignment));
+    }
+};
+
+GLint pixel_format(const ImageData& image) {
+    return image.mode == ColorMode::RGB ? GL_RGB : GL_RGBA;
+}
+
+}
+
+mip_chain_t build_mip_chain(ImageData image, const mip_config_t& config) {
+    PROFILE_ZONE("build_mip_chain");
+    if (!image.is_valid() || image.size() <= 0) {
+        throw std::runtime_error("No pixels to build mips from");
+    }
+
+    std::filesystem::path cached;
+    if (!config.cache_dir.empty()) {
+        cached = config.cache_dir / cache_name(image, config);
+        if (auto chain = load_mip_chain(cached)) {
+            const auto& base = chain->levels.front();
+            if (base.w == image.w && base.h == image.h
+                && base.mode == image.mode
+                && chain->is_srgb == config.is_srgb) {
+                return std::move(*chain);
+            }
+        }
+    }
+
+    mip_chain_t chain {.is_srgb = config.is_srgb};
+    const bool is_linear_box = config.filter == MipFilter::BOX
+                            && !config.is_srgb;
+    if (is_linear_box) {
+        chain.levels.push_back(std::move(image));
+        while (chain.levels.back().w > 1 || chain.levels.back().h > 1) {
+            auto next = box_bytes(chain.levels.back());
+            chain.levels.push_back(std::move(next));
+        }
+    } else {
+        // the float chain carries on from the unrounded level
+        auto level = to_float(image, config.is_srgb);
+        const ColorMode mode = image.mode;
+        chain.levels.push_back(std::move(image));
+        while (level.w > 1 || level.h > 1) {
+            level = config.filter == MipFilter::KAISER ? kaiser_float(level)
+                                                       : box_float(level);
+            chain.levels.push_back(to_bytes(level, mode, config.is_srgb));
+        }
+    }
+
+    if (!cached.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(config.cache_dir, error);
+        if (error || !save_mip_chain(cached, chain)) {
+            std::cerr << "Unable to cache mips in " << cached << std::endl;
+        }
+    }
+    return chain;
+}
+
+bool save_mip_chain(const std::filesystem::path& path,
+                    const mip_chain_t& chain) {
+    if (chain.levels.empty()) { return false; }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    auto put = [&](uint32_t value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    put(CACHE_MAGIC);
+    put(CACHE_VERSION);
+    put(uint32_t(chain.levels.size()));
+    put(uint32_t(chain.levels.front().mode));
+    put(uint32_t(chain.is_srgb));
+    for (const auto& level : chain.levels) {
+        put(uint32_t(level.w));
+        put(uint32_t(level.h));
+        file.write(reinterpret_cast<const char*>(level.data), level.size());
+    }
+    return bool(file);
+}
+
+std::optional<mip_chain_t> load_mip_chain(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) { return std::nullopt; }
+
+    auto get = [&]() {
+        uint32_t value = 0;
+        file.read(reinterpret_cast<char*>(&value), sizeof(value));
+        return value;
+    };
+    if (get() != CACHE_MAGIC || get() != CACHE_VERSION) {
+        return std::nullopt;
+    }
+    const uint32_t count = get();
+    const auto mode = ColorMode(get());
+    const bool is_srgb = get() != 0;
+    if (!file || count == 0 || count > 32
+        || (mode != ColorMode::RGB && mode != ColorMode::RGBA)) {
+        return std::nullopt;
+    }
+
+    mip_chain_t chain {.is_srgb = is_srgb};
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t w = get();
+        const uint32_t h = get();
+        if (!file || w == 0 || h == 0 || w > (1u << 16) || h > (1u << 16)) {
+            return std::nullopt;
+        }
+        ImageData level;
+        level.w = int(w);
+        level.h = int(h);
+        level.mode = mode;
+        level.data = new byte_t[level.size()];
+        file.read(reinterpret_cast<char*>(level.data), level.size());
+        chain.levels.push_back(std::move(level));
+    }
+    if (!file) { return std::nullopt; }
+    return chain;
+}
+
+void set_texture_mips(const mip_chain_t& chain,
+                      const texture_data_t& params) {
+    PROFILE_ZONE("set_texture_mips");
+    texture_data_t storage = params;
+    storage.is_srgb = chain.is_srgb;
+    set_texture_meta(nullptr, storage);
+    if (chain.levels.empty()) { return; }
+
+    GLint levels = 1;
+    SAFE_CALL(glGetTextureParameteriv(params.id, GL_TEXTURE_IMMUTABLE_LEVELS,
+                                      &levels));
+    unpack_alignment_guard_t guard;
+    const GLint count = std::min(levels, GLint(chain.levels.size()));
+    for (GLint i = 0; i < count; ++i) {
+        const auto& level = chain.levels[i];
+        SAFE_CALL(glTextureSubImage2D(params.id, i, 0, 0, level.w, level.h,
+                                      pixel_format(level), GL_UNSIGNED_BYTE,
+                                      level.data));
+    }
+}
+
+void set_texture_2d_array_mips(const std::vector<mip_chain_t>& layers,
+                               const texture_data_array_2d_t& data) {
+    PROFILE_ZONE("set_texture_2d_array_mips");
+    if (layers.size() != size_t(data.total_tiles())) {
+        std::cerr << "set_texture_2d_array_mips: " << layers.size()
+                  << " chains for " << data.total_tiles() << " layers"
+                  << std::endl;
+        return;
+    }
+    texture_data_array_2d_t storage = data;
+    storage.tex_data.is_srgb = !layers.empty() && layers.front().is_srgb;
+    set_texture_2d_array_meta(nullptr, storage);
+    if (layers.empty()) { return; }
+
+    const GLuint id = data.tex_data.id;
+    GLint levels = 1;
+    SAFE_CALL(glGetTextureParameteriv(id, GL_TEXTURE_IMMUTABLE_LEVELS,
+                                      &levels));
+    unpack_alignment_guard_t guard;
+    std::vector<byte_t> packed;
+    for (GLint i = 0; i < levels; ++i) {
+        // a level of every layer goes up in one call
+        packed.clear();
+        for (const auto& chain : layers) {
+            if (size_t(i) >= chain.levels.size()) { return; }
+            const auto& level = chain.levels[i];
+            packed.insert(packed.end(), level.data,
+                          level.data + level.size());
+        }
+        const auto& level = layers.front().levels[i];
+        SAFE_CALL(glTextureSubImage3D(id, i, 0, 0, 0, level.w, level.h,
+                                      GLsizei(layers.size()),
+                                      pixel_format(level), GL_UNSIGNED_BYTE,
+                                      packed.data()));
+    }
+}
+
+}
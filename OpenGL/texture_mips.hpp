@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <filesystem>
+
+#include "texture.hpp"
+#include "image_data.hpp"
+
+
+namespace opengl {
+
+enum class MipFilter {
+    BOX,    // 2x2 average
+    KAISER  // Kaiser windowed sinc, keeps the minified detail sharper
+};
+
+struct mip_config_t final {
+    MipFilter filter                {MipFilter::BOX};
+    // Filters in linear light, the texture gets an sRGB internal format.
+    // Alpha is always linear.
+    bool is_srgb                    {false};
+    // Chains are looked up and saved here when set, keyed by the pixels
+    // and the settings
+    std::filesystem::path cache_dir {};
+};
+
+// Level 0 is the source image, every next level halves it down to 1x1
+struct mip_chain_t final {
+    std::vector<ImageData> levels {};
+    bool is_srgb                  {false};
+};
+
+// CPU only and thread safe, meant for worker threads. Rows of big levels
+// are split over threads on their own.
+mip_chain_t build_mip_chain(ImageData image, const mip_config_t& config = {});
+
+// Raw little header plus the levels, no compression
+bool save_mip_chain(const std::filesystem::path& path,
+                    const mip_chain_t& chain);
+std::optional<mip_chain_t> load_mip_chain(const std::filesystem::path& path);
+
+// Allocate immutable storage like set_texture_meta and upload every level
+// of the chain. The internal format follows chain.is_srgb, w and h must be
+// the size of level 0.
+void set_texture_mips(const mip_chain_t& chain, const texture_data_t& params);
+// One chain per layer, each the size of a tile
+void set_texture_2d_array_mips(const std::vector<mip_chain_t>& layers,
+                               const texture_data_array_2d_t& data);
+
+}
@@ -0,0 +1,92 @@
+#include <algorithm>
+
+#include <Profiler/profiler.hpp>
+
+#include "worker_pool.hpp"
+
+
+namespace opengl {
+
+WorkerPool::WorkerPool(size_t workers, size_t max_queued,
+                       const std::string& name)
+    : max_queued_(std::max<size_t>(max_queued, 1))
+{
+    workers = std::max<size_t>(workers, 1);
+    threads_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        threads_.emplace_back(&WorkerPool::run, this,
+                              name + " " + std::to_string(i));
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lock(mutex_);
+        is_stopping_ = true;
+    }
+    has_work_.notify_all();
+    has_room_.notify_all();
+    // queued tasks still run, the pool drains before it goes
+    for (auto& thread : threads_) { thread.join(); }
+}
+
+bool WorkerPool::try_submit(task_t task) {
+    {
+        std::lock_guard lock(mutex_);
+        if (tasks_.size() >= max_queued_) { return false; }
+        tasks_.push_back(std::move(task));
+    }
+    has_work_.notify_one();
+    return true;
+}
+
+void WorkerPool::submit(task_t task) {
+    {
+        std::unique_lock lock(mutex_);
+        has_room_.wait(lock, [this]() {
+            return tasks_.size() < max_queued_ || is_stopping_;
+        });
+        tasks_.push_back(std::move(task));
+    }
+    has_work_.notify_one();
+}
+
+void WorkerPool::wait_idle() {
+    std::unique_lock lock(mutex_);
+    is_idle_.wait(lock, [this]() {
+        return tasks_.empty() && running_ == 0;
+    });
+}
+
+size_t WorkerPool::queued() const {
+    std::lock_guard lock(mutex_);
+    return tasks_.size();
+}
+
+void WorkerPool::run([[maybe_unused]] const std::string& thread_name) {
+    PROFILE_THREAD(thread_name);
+    while (true) {
+        task_t task;
+        {
+            std::unique_lock lock(mutex_);
+            has_work_.wait(lock, [this]() {
+                return !tasks_.empty() || is_stopping_;
+            });
+            if (tasks_.empty()) { return; }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+            ++running_;
+        }
+        has_room_.notify_one();
+
+        task();
+
+        {
+            std::lock_guard lock(mutex_);
+            --running_;
+            if (tasks_.empty() && running_ == 0) { is_idle_.notify_all(); }
+        }
+    }
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+
+namespace opengl {
+
+// Fixed set of threads working off a bounded FIFO. Tasks must not touch GL,
+// the context stays with the thread that made it current.
+class WorkerPool final {
+public:
+    using task_t = std::function<void()>;
+
+    // max_queued counts tasks waiting, not the ones running
+    WorkerPool(size_t workers, size_t max_queued,
+               const std::string& name = "worker");
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Refuses the task when the queue is full
+    bool try_submit(task_t task);
+    // Waits for room in the queue
+    void submit(task_t task);
+    // Blocks until the queue is empty and no task runs
+    void wait_idle();
+
+    size_t queued() const;
+    size_t workers() const { return threads_.size(); }
+
+private:
+    void run([[maybe_unused]] const std::string& thread_name);
+
+private:
+    mutable std::mutex mutex_            {};
+    std::condition_variable has_work_    {};
+    std::condition_variable has_room_    {};
+    std::condition_variable is_idle_     {};
+    std::deque<task_t> tasks_            {};
+    std::vector<std::thread> threads_    {};
+    size_t max_queued_;
+    size_t running_                      {0};
+    bool is_stopping_                    {false};
+};
+
+
+// fn(first, last) over [0, count) in contiguous chunks on short lived
+// threads, one more thread for every min_work of the total work. For data
+// parallel loops, long lived background work goes to a WorkerPool.
+template<typename F>
+void parallel_for(size_t count, size_t work, size_t min_work, const F& fn) {
+    if (count == 0) { return; }
+    const size_t workers = std::clamp<size_t>(
+        work / std::max<size_t>(min_work, 1), 1,
+        std::min<size_t>(count, std::max<size_t>(
+            std::thread::hardware_concurrency(), 1
+        ))
+    );
+    if (workers == 1) {
+        fn(size_t(0), count);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    const size_t chunk = (count + workers - 1) / workers;
+    for (size_t first = chunk; first < count; first += chunk) {
+        threads.emplace_back(std::cref(fn), first,
+                             std::min(first + chunk, count));
+    }
+    fn(size_t(0), std::min(chunk, count));
+    for (auto& thread : threads) { thread.join(); }
+}
+
+}
@@ -0,0 +1,145 @@
+#include <mutex>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include "profiler.hpp"
+
+
+namespace profiler {
+
+using steady_t = std::chrono::steady_clock;
+
+// now() and steady_clock read together, the start of every trace
+struct time_origin_t final {
+    uint64_t ticks;
+    steady_t::time_point time;
+
+    static time_origin_t capture() {
+        return {.ticks = now(), .time = steady_t::now()};
+    }
+};
+
+struct registry_t final {
+    std::mutex mutex {};
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers {};
+    time_origin_t origin {time_origin_t::capture()};
+};
+
+// Buffers outlive their threads, a finished worker still shows up
+static registry_t& registry() {
+    static registry_t self;
+    return self;
+}
+
+
+ThreadBuffer::ThreadBuffer(uint32_t tid)
+    : events_(new event_t[CAPACITY])
+    , tid_(tid)
+{}
+
+std::vector<event_t> ThreadBuffer::snapshot() const {
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t begin = std::max(tail_, head > CAPACITY ? head - CAPACITY
+                                                         : size_t(0));
+    std::vector<event_t> out;
+    out.reserve(head - begin);
+    for (size_t i = begin; i < head; ++i) {
+        out.push_back(events_[i % CAPACITY]);
+    }
+    return out;
+}
+
+ThreadBuffer& thread_buffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        const auto tid = uint32_t(reg.buffers.size() + 1);
+        reg.buffers.push_back(std::make_unique<ThreadBuffer>(tid));
+        buffer = reg.buffers.back().get();
+    }
+    return *buffer;
+}
+
+void thread_name(std::string name) {
+    auto& buffer = thread_buffer();
+    std::lock_guard lock(registry().mutex);
+    buffer.name(std::move(name));
+}
+
+static std::string escape(std::string_view in) {
+    std::string out;
+    out.reserve(in.size());
+    for (char c : in) {
+        if (c == '"' || c == '\\') { out += '\\'; }
+        out += c;
+    }
+    return out;
+}
+
+std::string chrome_trace() {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+
+    // rdtsc ticks per microsecond, measured over the whole run
+    const auto current = time_origin_t::capture();
+    const double elapsed_us = std::chrono::duration<double, std::micro>(
+        current.time - reg.origin.time
+    ).count();
+    const double ticks = double(current.ticks - reg.origin.ticks);
+    const double ticks_per_us = elapsed_us > 0.0 && ticks > 0.0
+        ? ticks / elapsed_us
+        : 1.0;
+    auto to_us = [&](uint64_t t) {
+        return double(int64_t(t - reg.origin.ticks)) / ticks_per_us;
+    };
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool is_first = true;
+    auto separate = [&]() {
+        if (!is_first) { out += ','; }
+        is_first = false;
+    };
+    for (const auto& buffer : reg.buffers) {
+        if (!buffer->name().empty()) {
+            separate();
+            out += std::format(
+                "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                "\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+                buffer->tid(), escape(buffer->name())
+            );
+        }
+        for (const auto& event : buffer->snapshot()) {
+            separate();
+            out += std::format(
+                "{{\"name\":\"{}\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,"
+                "\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                escape(event.name), buffer->tid(), to_us(event.begin),
+                double(event.end - event.begin) / ticks_per_us
+            );
+        }
+    }
+    out += "]}";
+    return out;
+}
+
+bool write_chrome_trace(const std::filesystem::path& path) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Could not write trace " << path << std::endl;
+        return false;
+    }
+    file << chrome_trace();
+    return bool(file);
+}
+
+void clear() {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    for (auto& buffer : reg.buffers) { buffer->clear(); }
+}
+
+}
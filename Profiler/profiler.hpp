@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#   define PROFILE_HAS_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#   define PROFILE_HAS_RDTSC 1
+#else
+#   include <chrono>
+#   define PROFILE_HAS_RDTSC 0
+#endif
+
+
+// CPU zones recorded into per thread buffers and exported as Chrome trace
+// JSON, open the file in chrome://tracing or ui.perfetto.dev.
+//
+//   void upload() {
+//       PROFILE_ZONE("upload");
+//       ...
+//   }
+//   profiler::write_chrome_trace("frame.json");
+//
+// Zones compile to nothing unless RENDER_PROFILE is 1, see utils.cmake.
+namespace profiler {
+
+// Raw timestamp, rdtsc ticks on x86 and steady_clock nanoseconds elsewhere.
+// The export calibrates ticks against steady_clock.
+inline uint64_t now() {
+#if PROFILE_HAS_RDTSC
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct event_t final {
+    const char* name {nullptr}; // has to outlive the export, use literals
+    uint64_t begin   {0};
+    uint64_t end     {0};
+};
+
+// Events of one thread. Only the owning thread writes, readers see every
+// event up to the released head. The buffer is a ring, the oldest events
+// are overwritten once CAPACITY is reached.
+class ThreadBuffer final {
+public:
+    static constexpr size_t CAPACITY = 1 << 16;
+
+    explicit ThreadBuffer(uint32_t tid);
+
+    void record(const char* name, uint64_t begin, uint64_t end) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        events_[head % CAPACITY] = {.name = name, .begin = begin, .end = end};
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // Oldest first, at most CAPACITY events
+    std::vector<event_t> snapshot() const;
+    void clear() { tail_ = head_.load(std::memory_order_acquire); }
+
+    uint32_t tid() const { return tid_; }
+    const std::string& name() const { return name_; }
+    void name(std::string name) { name_ = std::move(name); }
+
+private:
+    std::unique_ptr<event_t[]> events_;
+    std::atomic<size_t> head_ {0};
+    size_t tail_              {0};
+    uint32_t tid_;
+    std::string name_         {};
+};
+
+// Buffer of the calling thread, registered on first use. The lock is taken
+// once per thread, recording itself never locks.
+ThreadBuffer& thread_buffer();
+// Shows up as the thread name in the trace
+void thread_name(std::string name);
+
+class Zone final {
+public:
+    explicit Zone(const char* name)
+        : name_(name)
+        , begin_(now())
+    {}
+
+    ~Zone() { thread_buffer().record(name_, begin_, now()); }
+
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+
+private:
+    const char* name_;
+    uint64_t begin_;
+};
+
+// Events of every thread. Call it while the other threads are idle, events
+// overwritten during the export come out torn.
+std::string chrome_trace();
+bool write_chrome_trace(const std::filesystem::path& path);
+// Drops the events recorded so far
+void clear();
+
+}
+
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#if RENDER_PROFILE
+#   define PROFILE_ZONE(name) \
+        ::profiler::Zone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#   define PROFILE_THREAD(name) ::profiler::thread_name(name)
+#else
+#   define PROFILE_ZONE(name) ((void)0)
+#   define PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,80 @@
+#include <array>
+
+#include <benchmark/benchmark.h>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <UI/ui.hpp>
+#include <OpenGL/opengl_proc.hpp>
+
+
+// Hidden window holding the context for the whole benchmark run
+static opengl::Context& shared_context() {
+    static opengl::Context& ctx = []() -> opengl::Context& {
+        ui::init_glfw(4, 6);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        ui::create_window(64, 64, "state_benchmark");
+        opengl::Context::instance().initialize();
+        return opengl::Context::instance();
+    }();
+    return ctx;
+}
+
+static std::array<GLuint, 2> shared_vaos() {
+    static std::array<GLuint, 2> vaos = []() {
+        shared_context();
+        return std::array<GLuint, 2> {
+            opengl::gen_vertex_array(),
+            opengl::gen_vertex_array()
+        };
+    }();
+    return vaos;
+}
+
+
+// Old draw() pattern: the VAO is bound and unbound around every draw
+static void BM_raw_bind_unbind_vao(benchmark::State& state) {
+    const auto vaos = shared_vaos();
+    size_t i = 0;
+    for (auto _ : state) {
+        glBindVertexArray(vaos[i++ & 1]);
+        glBindVertexArray(0);
+    }
+    opengl::Context::instance().sync_state();
+}
+BENCHMARK(BM_raw_bind_unbind_vao);
+
+static void BM_cached_bind_vao_same(benchmark::State& state) {
+    const auto vaos = shared_vaos();
+    auto& ctx = shared_context();
+    ctx.reset_state_stats();
+    for (auto _ : state) {
+        opengl::bind_vao(vaos[0]);
+    }
+    state.counters["elided"] = ctx.state_stats().elided;
+    opengl::bind_vao(0);
+}
+BENCHMARK(BM_cached_bind_vao_same);
+
+static void BM_raw_query_program(benchmark::State& state) {
+    shared_context();
+    for (auto _ : state) {
+        GLint program = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        benchmark::DoNotOptimize(program);
+    }
+}
+BENCHMARK(BM_raw_query_program);
+
+static void BM_cached_query_program(benchmark::State& state) {
+    auto& ctx = shared_context();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ctx.active_program());
+    }
+}
+BENCHMARK(BM_cached_query_program);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,134 @@
+#include <array>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <UI/ui.hpp>
+#include <OpenGL/opengl_proc.hpp>
+#include <OpenGL/opengl_program.hpp>
+#include <OpenGL/opengl_render_data.hpp>
+
+
+static const std::string VERTEX_SHADER = R"(
+#version 460 core
+layout (location = 0) in vec3 in_pos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+    gl_Position = projection * view * model * vec4(in_pos, 1.0);
+}
+)";
+
+static const std::string FRAGMENT_SHADER = R"(
+#version 460 core
+out vec4 frag_color;
+
+uniform vec4 color;
+
+void main() {
+    frag_color = color;
+}
+)";
+
+
+// Hidden window holding the context for the whole benchmark run
+static GLuint shared_program() {
+    static GLuint program = []() {
+        ui::init_glfw(4, 6);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        ui::create_window(64, 64, "uniforms_benchmark");
+        opengl::Context::instance().initialize();
+        return opengl::create_program(VERTEX_SHADER, FRAGMENT_SHADER);
+    }();
+    return program;
+}
+
+static const std::array<glm::mat4, 2> MATRICES {
+    glm::mat4(1.0f),
+    glm::mat4(2.0f)
+};
+
+
+static void BM_string_set_mat4(benchmark::State& state) {
+    GLuint program = shared_program();
+    opengl::use(program);
+    size_t i = 0;
+    for (auto _ : state) {
+        opengl::set_mat4(program, "model", MATRICES[i++ & 1]);
+    }
+    opengl::use(0);
+}
+BENCHMARK(BM_string_set_mat4);
+
+static void BM_program_set_mat4(benchmark::State& state) {
+    auto program = opengl::Program::create(shared_program());
+    auto model = program.uniform("model");
+    size_t i = 0;
+    for (auto _ : state) {
+        program.set(model, MATRICES[i++ & 1]);
+    }
+    state.counters["uploads"] = program.stats().uploads;
+}
+BENCHMARK(BM_program_set_mat4);
+
+static void BM_program_set_mat4_redundant(benchmark::State& state) {
+    auto program = opengl::Program::create(shared_program());
+    auto model = program.uniform("model");
+    for (auto _ : state) {
+        program.set(model, MATRICES[0]);
+    }
+    state.counters["skipped"] = program.stats().skipped;
+}
+BENCHMARK(BM_program_set_mat4_redundant);
+
+
+// Per entity pattern of the frame loops: shared camera and a model per entity
+static void BM_string_entities(benchmark::State& state) {
+    GLuint program = shared_program();
+    const auto entities = state.range(0);
+    for (auto _ : state) {
+        for (int64_t e = 0; e < entities; ++e) {
+            opengl::use(program);
+            opengl::set_mat4(program, "projection", MATRICES[0]);
+            opengl::set_mat4(program, "view", MATRICES[0]);
+            opengl::set_mat4(program, "model", MATRICES[e & 1]);
+            opengl::set_vec4(program, "color", glm::vec4(1.0f));
+        }
+    }
+    opengl::use(0);
+    state.SetItemsProcessed(state.iterations() * entities);
+}
+BENCHMARK(BM_string_entities)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_program_entities(benchmark::State& state) {
+    auto program = opengl::Program::create(shared_program());
+    auto projection = program.uniform("projection");
+    auto view = program.uniform("view");
+    auto model = program.uniform("model");
+    auto color = program.uniform("color");
+    const auto entities = state.range(0);
+    for (auto _ : state) {
+        for (int64_t e = 0; e < entities; ++e) {
+            opengl::use(program.id());
+            program.set(projection, MATRICES[0]);
+            program.set(view, MATRICES[0]);
+            program.set(model, MATRICES[e & 1]);
+            program.set(color, glm::vec4(1.0f));
+        }
+    }
+    opengl::use(0);
+    state.SetItemsProcessed(state.iterations() * entities);
+    state.counters["uploads"] = program.stats().uploads;
+    state.counters["skipped"] = program.stats().skipped;
+}
+BENCHMARK(BM_program_entities)->Arg(16)->Arg(256)->Arg(4096);
+
+
+BENCHMARK_MAIN();
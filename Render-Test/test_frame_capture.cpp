@@ -0,0 +1,63 @@
+#include <atomic>
+#include <future>
+
+#include <gtest/gtest.h>
+#include <OpenGL/worker_pool.hpp>
+#include <OpenGL/opengl_frame_recorder.hpp>
+
+TEST(FrameCapture, test_flip_rows) {
+    std::vector<glm::u8vec4> pixels {
+        {0, 0, 0, 0}, {1, 0, 0, 0},
+        {2, 0, 0, 0}, {3, 0, 0, 0},
+        {4, 0, 0, 0}, {5, 0, 0, 0}
+    };
+    opengl::flip_rows(pixels, 2);
+    ASSERT_EQ(pixels[0].r, 4);
+    ASSERT_EQ(pixels[1].r, 5);
+    ASSERT_EQ(pixels[2].r, 2);
+    ASSERT_EQ(pixels[5].r, 1);
+}
+
+TEST(FrameCapture, test_y4m) {
+    ASSERT_EQ(opengl::y4m_header(640, 480, 60),
+              "YUV4MPEG2 W640 H480 F60:1 Ip A1:1 C444\n");
+
+    const auto yuv = opengl::rgba_to_yuv444({
+        {0, 0, 0, 255}, {255, 255, 255, 255}, {255, 0, 0, 255}
+    });
+    ASSERT_EQ(yuv.size(), 9);
+    // black and white end at the limited range bounds, grey has no chroma
+    ASSERT_EQ(yuv[0], 16);
+    ASSERT_EQ(yuv[1], 235);
+    ASSERT_EQ(yuv[3], 128);
+    ASSERT_EQ(yuv[4], 128);
+    ASSERT_EQ(yuv[7], 128);
+    // red pushes V up
+    ASSERT_EQ(yuv[2], 82);
+    ASSERT_EQ(yuv[8], 240);
+}
+
+TEST(WorkerPool, test_bounded_queue) {
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    std::atomic<int> done {0};
+
+    opengl::WorkerPool pool(1, 2);
+    auto task = [gate, &done]() { gate.wait(); ++done; };
+    // one task runs, two wait, the fourth has no room
+    ASSERT_TRUE(pool.try_submit(task));
+    while (pool.queued() != 0) { std::this_thread::yield(); }
+    ASSERT_TRUE(pool.try_submit(task));
+    ASSERT_TRUE(pool.try_submit(task));
+    ASSERT_FALSE(pool.try_submit(task));
+
+    release.set_value();
+    pool.wait_idle();
+    ASSERT_EQ(done, 3);
+    ASSERT_EQ(pool.queued(), 0);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <OpenGL/opengl_frame_graph.hpp>
+
+using strings_t = std::vector<std::string>;
+
+TEST(FrameGraph, test_culling) {
+    opengl::FrameGraph graph;
+    const opengl::attachment_desc_t desc {.size = {64, 64}};
+    auto scene = graph.create("scene", desc);
+    auto debug = graph.create("debug", desc);
+    auto minimap = graph.create("minimap", desc);
+
+    graph.add_pass("scene", [&](auto& pass) { pass.write(scene); }, {});
+    graph.add_pass("debug", [&](auto& pass) {
+        pass.read(scene);
+        pass.write(debug);
+    }, {});
+    graph.add_pass("minimap", [&](auto& pass) { pass.write(minimap); }, {});
+    graph.add_pass("screen", [&](auto& pass) {
+        pass.read(scene);
+        pass.side_effect();
+    }, {});
+
+    ASSERT_TRUE(graph.compile());
+    ASSERT_EQ(graph.schedule(), strings_t({"scene", "screen"}));
+    ASSERT_EQ(graph.stats().culled, 2);
+    ASSERT_EQ(graph.stats().slots, 1);
+
+    // an output keeps its writers
+    graph.output(minimap);
+    ASSERT_TRUE(graph.compile());
+    ASSERT_EQ(graph.schedule(), strings_t({"scene", "minimap", "screen"}));
+}
+
+TEST(FrameGraph, test_aliasing_and_resolves) {
+    opengl::FrameGraph graph;
+    const opengl::attachment_desc_t desc {.size = {64, 64}};
+    auto scene = graph.create("scene", {.size = {64, 64}, .samples = 4});
+    auto ping = graph.create("ping", desc);
+    auto pong = graph.create("pong", desc);
+    auto bloom = graph.create("bloom", desc);
+    auto half = graph.create("half", {.size = {32, 32}});
+
+    graph.add_pass("scene", [&](auto& pass) { pass.write(scene); }, {});
+    graph.add_pass("ping", [&](auto& pass) {
+        pass.read(scene);
+        pass.write(ping);
+    }, {});
+    graph.add_pass("pong", [&](auto& pass) {
+        pass.read(ping);
+        pass.write(pong);
+    }, {});
+    graph.add_pass("bloom", [&](auto& pass) {
+        pass.read(pong);
+        pass.read(scene);
+        pass.write(bloom);
+    }, {});
+    graph.add_pass("half", [&](auto& pass) {
+        pass.read(bloom);
+        pass.write(half);
+    }, {});
+    graph.output(half);
+
+    ASSERT_TRUE(graph.compile());
+    // scene is resolved once, nothing writes it between the two reads
+    ASSERT_EQ(graph.stats().resolves, 1);
+    // ping is dead once pong ran, bloom takes its texture
+    ASSERT_EQ(graph.slot(bloom), graph.slot(ping));
+    ASSERT_NE(graph.slot(pong), graph.slot(ping));
+    ASSERT_NE(graph.slot(half), graph.slot(bloom));
+    // scene, its resolved twin, ping/bloom, pong and half
+    ASSERT_EQ(graph.stats().slots, 5);
+}
+
+TEST(FrameGraph, test_mismatched_writes) {
+    opengl::FrameGraph graph;
+    auto color = graph.create("color", {.size = {64, 64}});
+    auto depth = graph.create("depth", {.format = GL_DEPTH_STENCIL,
+                                        .size = {32, 32}});
+    graph.add_pass("scene", [&](auto& pass) {
+        pass.write(color);
+        pass.write(depth);
+        pass.side_effect();
+    }, {});
+    ASSERT_FALSE(graph.compile());
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
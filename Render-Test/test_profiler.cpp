@@ -0,0 +1,67 @@
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <Profiler/profiler.hpp>
+
+static size_t count(const std::string& in, const std::string& what) {
+    size_t out = 0;
+    for (auto pos = in.find(what); pos != std::string::npos;
+         pos = in.find(what, pos + what.size())) {
+        ++out;
+    }
+    return out;
+}
+
+TEST(Profiler, test_zones_are_exported) {
+    profiler::clear();
+    {
+        profiler::Zone outer("outer");
+        profiler::Zone inner("inner \"quoted\"");
+    }
+    const auto trace = profiler::chrome_trace();
+    ASSERT_EQ(trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0);
+    ASSERT_EQ(count(trace, "\"name\":\"outer\""), 1);
+    ASSERT_EQ(count(trace, "\"name\":\"inner \\\"quoted\\\"\""), 1);
+    ASSERT_EQ(count(trace, "\"ph\":\"X\""), 2);
+
+    profiler::clear();
+    ASSERT_EQ(count(profiler::chrome_trace(), "\"ph\":\"X\""), 0);
+}
+
+TEST(Profiler, test_threads_get_own_buffers) {
+    profiler::clear();
+    const profiler::ThreadBuffer* worker_buffer = nullptr;
+    std::thread worker([&worker_buffer]() {
+        profiler::thread_name("worker");
+        profiler::Zone zone("job");
+        worker_buffer = &profiler::thread_buffer();
+    });
+    worker.join();
+    { profiler::Zone zone("main"); }
+
+    const auto trace = profiler::chrome_trace();
+    ASSERT_EQ(count(trace, "\"args\":{\"name\":\"worker\"}"), 1);
+    ASSERT_EQ(count(trace, "\"name\":\"job\""), 1);
+    ASSERT_EQ(count(trace, "\"name\":\"main\""), 1);
+    ASSERT_NE(worker_buffer, &profiler::thread_buffer());
+}
+
+TEST(Profiler, test_ring_keeps_newest_events) {
+    profiler::clear();
+    auto& buffer = profiler::thread_buffer();
+    const size_t total = profiler::ThreadBuffer::CAPACITY + 10;
+    for (size_t i = 0; i < total; ++i) {
+        buffer.record("e", i, i + 1);
+    }
+    const auto events = buffer.snapshot();
+    ASSERT_EQ(events.size(), profiler::ThreadBuffer::CAPACITY);
+    ASSERT_EQ(events.front().begin, 10);
+    ASSERT_EQ(events.back().begin, total - 1);
+    buffer.clear();
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,38 @@
+#include <string>
+
+#include <gtest/gtest.h>
+#include <OpenGL/opengl_program_cache.hpp>
+
+static const std::string SOURCE = "#version 460 core\nvoid main() {}\n";
+
+TEST(ProgramCache, test_defines_after_version) {
+    const auto out = opengl::inject_defines(SOURCE, {"SHADOWS", "LIGHTS 4"});
+    ASSERT_EQ(out, "#version 460 core\n"
+                   "#define SHADOWS\n"
+                   "#define LIGHTS 4\n"
+                   "void main() {}\n");
+}
+
+TEST(ProgramCache, test_defines_without_version) {
+    ASSERT_EQ(opengl::inject_defines("void main() {}", {"A"}),
+              "#define A\nvoid main() {}");
+    ASSERT_EQ(opengl::inject_defines("#version 460", {"A"}),
+              "#version 460\n#define A\n");
+    ASSERT_EQ(opengl::inject_defines(SOURCE, {}), SOURCE);
+}
+
+TEST(ProgramCache, test_hash_inputs) {
+    using opengl::program_hash;
+    const auto base = program_hash("v", "f", {}, "driver");
+    ASSERT_EQ(base, program_hash("v", "f", {}, "driver"));
+    ASSERT_NE(base, program_hash("v", "f", {}, "driver 2"));
+    ASSERT_NE(base, program_hash("v", "f", {"A"}, "driver"));
+    ASSERT_NE(base, program_hash("f", "v", {}, "driver"));
+    // moving characters between parts changes the key
+    ASSERT_NE(program_hash("ab", "c", {}, ""), program_hash("a", "bc", {}, ""));
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
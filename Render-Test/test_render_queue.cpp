@@ -0,0 +1,57 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <OpenGL/opengl_render_queue.hpp>
+
+TEST(RenderQueue, test_key_order) {
+    using opengl::make_sort_key;
+    // pass dominates everything else
+    ASSERT_LT(make_sort_key(0, 9, 9, 9, 1.0f), make_sort_key(1, 0, 0, 0, 0));
+    // then program, vao, texture and depth
+    ASSERT_LT(make_sort_key(0, 1, 9, 9, 1.0f), make_sort_key(0, 2, 0, 0, 0));
+    ASSERT_LT(make_sort_key(0, 1, 1, 9, 1.0f), make_sort_key(0, 1, 2, 0, 0));
+    ASSERT_LT(make_sort_key(0, 1, 1, 1, 1.0f), make_sort_key(0, 1, 1, 2, 0));
+    ASSERT_LT(make_sort_key(0, 1, 1, 1, 0.2f), make_sort_key(0, 1, 1, 1, 0.8f));
+}
+
+TEST(RenderQueue, test_depth_clamped) {
+    using opengl::make_sort_key;
+    ASSERT_EQ(make_sort_key(0, 1, 1, 1, -1.0f), make_sort_key(0, 1, 1, 1, 0));
+    ASSERT_EQ(make_sort_key(0, 1, 1, 1, 2.0f), make_sort_key(0, 1, 1, 1, 1));
+}
+
+TEST(RenderQueue, test_radix_sort) {
+    std::vector<opengl::queue_key_t> keys;
+    uint64_t state = 88172645463325252ull;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        keys.push_back({.key = state, .index = i});
+    }
+    std::vector<opengl::queue_key_t> scratch;
+    opengl::radix_sort(keys, scratch);
+    for (size_t i = 1; i < keys.size(); ++i) {
+        ASSERT_LE(keys[i - 1].key, keys[i].key);
+    }
+}
+
+TEST(RenderQueue, test_radix_sort_stable) {
+    std::vector<opengl::queue_key_t> keys {
+        {.key = 2, .index = 0},
+        {.key = 1, .index = 1},
+        {.key = 2, .index = 2},
+        {.key = 1, .index = 3}
+    };
+    std::vector<opengl::queue_key_t> scratch;
+    opengl::radix_sort(keys, scratch);
+    ASSERT_EQ(keys[0].index, 1);
+    ASSERT_EQ(keys[1].index, 3);
+    ASSERT_EQ(keys[2].index, 0);
+    ASSERT_EQ(keys[3].index, 2);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+#include <OpenGL/opengl_render_target.hpp>
+
+TEST(ResizePolicy, test_growth_has_slack) {
+    opengl::resize_policy_t policy {.slack = 0.25f};
+    ASSERT_TRUE(policy.update({100, 40}));
+    ASSERT_EQ(policy.capacity, glm::ivec2(125, 50));
+
+    // dragging within the slack keeps the storage
+    ASSERT_FALSE(policy.update({110, 44}));
+    ASSERT_FALSE(policy.update({125, 50}));
+
+    // only the dimension that outgrew its capacity moves
+    ASSERT_TRUE(policy.update({126, 20}));
+    ASSERT_EQ(policy.capacity, glm::ivec2(158, 50));
+    ASSERT_FALSE(policy.update({0, 10}));
+}
+
+TEST(ResizePolicy, test_shrink_waits) {
+    opengl::resize_policy_t policy {.slack = 0.0f, .shrink_frames = 3};
+    ASSERT_TRUE(policy.update({200, 200}));
+
+    ASSERT_FALSE(policy.update({50, 200}));
+    ASSERT_FALSE(policy.update({50, 200}));
+    // a size back within half the capacity restarts the count
+    ASSERT_FALSE(policy.update({150, 200}));
+    ASSERT_FALSE(policy.update({50, 200}));
+    ASSERT_FALSE(policy.update({50, 200}));
+    ASSERT_TRUE(policy.update({50, 200}));
+    ASSERT_EQ(policy.capacity, glm::ivec2(50, 200));
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
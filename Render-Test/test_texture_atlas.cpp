@@ -0,0 +1,84 @@
+#include <format>
+#include <random>
+
+#include <gtest/gtest.h>
+#include <OpenGL/texture_atlas.hpp>
+
+static bool overlaps(const opengl::atlas_rect_t& a,
+                     const opengl::atlas_rect_t& b) {
+    return a.x < b.x + b.w && a.x + a.w > b.x
+        && a.y < b.y + b.h && a.y + a.h > b.y;
+}
+
+TEST(MaxRectsBin, test_fills_without_overlap) {
+    opengl::MaxRectsBin bin(64, 64);
+    std::vector<opengl::atlas_rect_t> used;
+    for (int i = 0; i < 16; ++i) {
+        auto rect = bin.insert(16, 16);
+        ASSERT_TRUE(rect.has_value());
+        for (const auto& other : used) { ASSERT_FALSE(overlaps(*rect, other)); }
+        used.push_back(*rect);
+    }
+    ASSERT_FLOAT_EQ(bin.occupancy(), 1.0f);
+    ASSERT_FALSE(bin.insert(1, 1).has_value());
+}
+
+TEST(TextureAtlas, test_pack) {
+    opengl::ImageManager images;
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> side(4, 60);
+    for (int i = 0; i < 64; ++i) {
+        const glm::u8vec4 color(i, 255 - i, i * 3, 255);
+        images.update(std::format("sprite_{}", i), opengl::ImageData::create(
+            side(random), side(random), color
+        ));
+    }
+    images.update("rgb", opengl::ImageData::create(5, 3, glm::u8vec3(9)));
+
+    const opengl::atlas_config_t config {.page_size = 256, .padding = 2};
+    const auto layout = opengl::pack_atlas(images, config);
+    ASSERT_EQ(layout.entries.size(), 65);
+    ASSERT_GE(layout.pages.size(), 2);
+
+    for (auto it = images.cbegin(); it != images.cend(); ++it) {
+        const auto& entry = layout.entries.at(it->first);
+        const auto& image = it->second;
+        const auto& page = layout.pages[entry.layer];
+        ASSERT_EQ(entry.rect.w, image.w);
+        ASSERT_EQ(entry.rect.h, image.h);
+        ASSERT_EQ(entry.rect.x % config.alignment, config.padding);
+        ASSERT_FLOAT_EQ(entry.uv.x * 256.0f, float(entry.rect.x));
+        ASSERT_FLOAT_EQ(entry.uv.w * 256.0f, float(entry.rect.y + image.h));
+
+        // gutters repeat the edge, the image itself is copied as is
+        for (int y : {-2, 0, image.h - 1, image.h + 1}) {
+            for (int x : {-2, 0, image.w - 1, image.w + 1}) {
+                const size_t at = (size_t(entry.rect.y + y) * page.w
+                                   + entry.rect.x + x) * 4;
+                ASSERT_EQ(page.data[at], image.data[0]) << it->first;
+                ASSERT_EQ(page.data[at + 3], 255);
+            }
+        }
+
+        for (const auto& [name, other] : layout.entries) {
+            if (name == it->first || other.layer != entry.layer) { continue; }
+            const opengl::atlas_rect_t padded {
+                entry.rect.x - 2, entry.rect.y - 2,
+                entry.rect.w + 4, entry.rect.h + 4
+            };
+            ASSERT_FALSE(overlaps(padded, other.rect)) << name;
+        }
+    }
+}
+
+TEST(TextureAtlas, test_too_large) {
+    opengl::ImageManager images;
+    images.update("huge", opengl::ImageData::create(300, 10, glm::u8vec3(0)));
+    ASSERT_THROW(opengl::pack_atlas(images, {.page_size = 256}),
+                 std::runtime_error);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
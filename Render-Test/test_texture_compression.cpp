@@ -0,0 +1,223 @@
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+
+#include <gtest/gtest.h>
+#include <OpenGL/texture_compression.hpp>
+
+using pixels_t = std::array<opengl::byte_t, 64>;
+
+// Reference decoders, enough of the formats to check the encoder
+static std::array<int, 4> color_565(uint16_t v) {
+    const int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2),
+            255};
+}
+
+static pixels_t decode_bc1(const opengl::byte_t* in, bool is_bc3_color) {
+    const uint16_t c0 = uint16_t(in[0] | in[1] << 8);
+    const uint16_t c1 = uint16_t(in[2] | in[3] << 8);
+    const uint32_t bits = uint32_t(in[4]) | uint32_t(in[5]) << 8
+                        | uint32_t(in[6]) << 16 | uint32_t(in[7]) << 24;
+    const auto e0 = color_565(c0), e1 = color_565(c1);
+    std::array<std::array<int, 4>, 4> palette {e0, e1};
+    for (int c = 0; c < 3; ++c) {
+        if (c0 > c1 || is_bc3_color) {
+            palette[2][c] = (2 * e0[c] + e1[c]) / 3;
+            palette[3][c] = (e0[c] + 2 * e1[c]) / 3;
+        } else {
+            palette[2][c] = (e0[c] + e1[c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = c0 > c1 || is_bc3_color ? 255 : 0;
+
+    pixels_t out {};
+    for (int i = 0; i < 16; ++i) {
+        const auto& color = palette[(bits >> (2 * i)) & 3];
+        for (int c = 0; c < 4; ++c) {
+            out[i * 4 + c] = opengl::byte_t(color[c]);
+        }
+    }
+    return out;
+}
+
+static pixels_t decode_bc3(const opengl::byte_t* in) {
+    pixels_t out = decode_bc1(in + 8, true);
+    const int a0 = in[0], a1 = in[1];
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i) { bits |= uint64_t(in[2 + i]) << (8 * i); }
+    for (int i = 0; i < 16; ++i) {
+        const int j = int((bits >> (3 * i)) & 7);
+        int a = j == 0 ? a0 : j == 1 ? a1 : 0;
+        if (j > 1 && a0 > a1) { a = ((8 - j) * a0 + (j - 1) * a1) / 7; }
+        if (j > 1 && a0 <= a1) {
+            a = j == 6 ? 0 : j == 7 ? 255 : ((6 - j) * a0 + (j - 1) * a1) / 5;
+        }
+        out[i * 4 + 3] = opengl::byte_t(a);
+    }
+    return out;
+}
+
+// Mode 6 only
+static pixels_t decode_bc7(const opengl::byte_t* in) {
+    int at = 0;
+    auto get = [&](int bits) {
+        int value = 0;
+        for (int i = 0; i < bits; ++i, ++at) {
+            value |= ((in[at / 8] >> (at % 8)) & 1) << i;
+        }
+        return value;
+    };
+    EXPECT_EQ(get(7), 1 << 6);
+    int ends[2][4];
+    for (int c = 0; c < 4; ++c) {
+        ends[0][c] = get(7);
+        ends[1][c] = get(7);
+    }
+    const int p0 = get(1), p1 = get(1);
+    static constexpr int weights[16] = {0, 4, 9, 13, 17, 21, 26, 30,
+                                        34, 38, 43, 47, 51, 55, 60, 64};
+    pixels_t out {};
+    for (int i = 0; i < 16; ++i) {
+        const int w = weights[get(i == 0 ? 3 : 4)];
+        for (int c = 0; c < 4; ++c) {
+            const int e0 = ends[0][c] << 1 | p0, e1 = ends[1][c] << 1 | p1;
+            out[i * 4 + c] = opengl::byte_t(((64 - w) * e0 + w * e1 + 32) >> 6);
+        }
+    }
+    return out;
+}
+
+static double rmse(const pixels_t& a, const pixels_t& b, int channels) {
+    double sum = 0.0;
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            const double d = double(a[i * 4 + c]) - double(b[i * 4 + c]);
+            sum += d * d;
+        }
+    }
+    return std::sqrt(sum / (16.0 * channels));
+}
+
+// Colors along a line with some noise off it, what a block can hold
+static pixels_t gradient_block(int seed) {
+    pixels_t out {};
+    for (int i = 0; i < 16; ++i) {
+        const int noise = (i * 7 + seed) % 5 - 2;
+        out[i * 4 + 0] = opengl::byte_t(40 + 4 * i + seed + noise);
+        out[i * 4 + 1] = opengl::byte_t(200 - 3 * i - noise);
+        out[i * 4 + 2] = opengl::byte_t(90 + 2 * i + noise);
+        out[i * 4 + 3] = opengl::byte_t(255 - 12 * i);
+    }
+    return out;
+}
+
+TEST(TextureCompression, test_bc1_round_trip) {
+    for (int seed = 0; seed < 40; seed += 7) {
+        const auto block = gradient_block(seed);
+        opengl::byte_t out[8];
+        // alpha above half everywhere keeps four colors
+        auto opaque = block;
+        for (int i = 0; i < 16; ++i) { opaque[i * 4 + 3] = 255; }
+        opengl::encode_block(opengl::BlockFormat::BC1, opaque.data(), out);
+        ASSERT_GT(out[0] | out[1] << 8, out[2] | out[3] << 8);
+        ASSERT_LT(rmse(decode_bc1(out, false), opaque, 3), 6.0);
+    }
+}
+
+TEST(TextureCompression, test_bc1_punch_through) {
+    auto block = gradient_block(0);
+    for (int i = 0; i < 16; ++i) {
+        block[i * 4 + 3] = i % 3 == 0 ? 0 : 255;
+    }
+    opengl::byte_t out[8];
+    opengl::encode_block(opengl::BlockFormat::BC1, block.data(), out);
+    const auto decoded = decode_bc1(out, false);
+    for (int i = 0; i < 16; ++i) {
+        ASSERT_EQ(decoded[i * 4 + 3], block[i * 4 + 3]);
+    }
+}
+
+TEST(TextureCompression, test_bc3_and_bc7_round_trip) {
+    for (int seed = 0; seed < 40; seed += 7) {
+        const auto block = gradient_block(seed);
+        opengl::byte_t out[16];
+        opengl::encode_block(opengl::BlockFormat::BC3, block.data(), out);
+        const auto bc3 = decode_bc3(out);
+        ASSERT_LT(rmse(bc3, block, 3), 6.0);
+        // half of a step over alpha 75 to 255
+        for (int i = 0; i < 16; ++i) {
+            ASSERT_NEAR(bc3[i * 4 + 3], block[i * 4 + 3], 13);
+        }
+
+        opengl::encode_block(opengl::BlockFormat::BC7, block.data(), out);
+        ASSERT_LT(rmse(decode_bc7(out), block, 4), 3.0);
+    }
+}
+
+TEST(TextureCompression, test_flat_blocks_are_exact) {
+    pixels_t block {};
+    for (int i = 0; i < 16; ++i) {
+        block[i * 4 + 0] = 255;
+        block[i * 4 + 1] = 0;
+        block[i * 4 + 2] = 0;
+        block[i * 4 + 3] = 255;
+    }
+    opengl::byte_t out[16];
+    opengl::encode_block(opengl::BlockFormat::BC1, block.data(), out);
+    ASSERT_EQ(decode_bc1(out, false), block);
+    // mode 6 shares the lowest bit over the channels of an end
+    opengl::encode_block(opengl::BlockFormat::BC7, block.data(), out);
+    const auto bc7 = decode_bc7(out);
+    for (size_t i = 0; i < block.size(); ++i) {
+        ASSERT_NEAR(bc7[i], block[i], 1);
+    }
+}
+
+TEST(TextureCompression, test_compress_chain_and_cache) {
+    const auto dir = std::filesystem::temp_directory_path() / "bc_test";
+    std::filesystem::remove_all(dir);
+
+    // 10 x 6 leaves partial blocks on the edges
+    std::vector<glm::u8vec4> pixels;
+    for (int i = 0; i < 60; ++i) {
+        pixels.push_back({uint8_t(i * 4), uint8_t(255 - i), 128, 255});
+    }
+    const auto chain = opengl::build_mip_chain(
+        opengl::ImageData::create(10, 6, pixels)
+    );
+    const opengl::compression_config_t config {
+        .format = opengl::BlockFormat::BC7,
+        .cache_dir = dir
+    };
+    const auto texture = opengl::compress(chain, config);
+    ASSERT_EQ(texture.levels.size(), chain.levels.size());
+    ASSERT_EQ(texture.levels[0].blocks.size(), 3 * 2 * 16);
+    ASSERT_EQ(texture.levels[1].blocks.size(), 2 * 1 * 16);
+    ASSERT_EQ(texture.levels.back().blocks.size(), 16);
+
+    const auto cached = opengl::compress(chain, config);
+    ASSERT_EQ(cached.size(), texture.size());
+    for (size_t i = 0; i < texture.levels.size(); ++i) {
+        ASSERT_EQ(cached.levels[i].blocks, texture.levels[i].blocks);
+    }
+    ASSERT_EQ(std::distance(std::filesystem::directory_iterator(dir),
+                            std::filesystem::directory_iterator()), 1);
+
+    // two layers under one key, BC1 halves the size
+    const auto array = opengl::compress(
+        std::vector<opengl::mip_chain_t>{chain, chain},
+        {.format = opengl::BlockFormat::BC1}
+    );
+    ASSERT_EQ(array.layers, 2);
+    ASSERT_EQ(array.levels[0].blocks.size(), 2 * 3 * 2 * 8);
+    std::filesystem::remove_all(dir);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,327 @@
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <UI/headless.hpp>
+#include <OpenGL/opengl_proc.hpp>
+#include <OpenGL/texture_manager.hpp>
+
+// Needs a GL context, the cases skip where UI was built without EGL or no
+// EGL display is around
+class TextureManager : public testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        headless_ = ui::headless_context_t::create(4, 5);
+        if (headless_.is_valid()) {
+            opengl::Context::instance().initialize(headless_.api());
+        }
+    }
+
+    static void TearDownTestSuite() {
+        headless_.free();
+    }
+
+    void SetUp() override {
+        if (!headless_.is_valid()) { GTEST_SKIP() << "no GL context"; }
+    }
+
+    static std::shared_ptr<const opengl::ImageData> image(int w, int h,
+            glm::u8vec3 color = {10, 20, 30}) {
+        return std::make_shared<const opengl::ImageData>(
+            opengl::ImageData::create(w, h, color)
+        );
+    }
+
+    // Polls until nothing is loading, the decode runs on the workers
+    static void finish(opengl::TextureManager& manager,
+                       size_t budget = opengl::TextureManager::
+                                       DEFAULT_UPLOAD_BUDGET) {
+        for (int i = 0; i < 2000 && manager.pending() > 0; ++i) {
+            manager.poll(budget);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Polls key in, asserting each call uploads a slice at most, the
+    // placeholder stands in until then
+    template<typename T> static size_t stream(
+            opengl::TextureManager& manager, const std::string& key,
+            size_t budget) {
+        size_t polls = 0;
+        for (int i = 0; i < 2000; ++i) {
+            if (manager.state(key) != opengl::TextureState::LOADING) {
+                break;
+            }
+            EXPECT_FALSE(manager.get<T>(key).has_value());
+            const size_t before = manager.streaming_stats().uploads;
+            manager.poll(budget);
+            const size_t uploads = manager.streaming_stats().uploads;
+            EXPECT_LE(uploads - before, 1u);
+            if (uploads == before) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            } else {
+                ++polls;
+            }
+        }
+        return polls;
+    }
+
+    // Streams in a, b and c, got in that order a frame apart
+    static void request_abc(opengl::TextureManager& manager) {
+        for (auto key : {"a", "b", "c"}) {
+            manager.request(key, {.image = image(16, 16)});
+        }
+        finish(manager);
+        for (auto key : {"a", "b", "c"}) {
+            manager.poll();
+            ASSERT_TRUE(manager.get<opengl::texture_data_t>(key));
+        }
+    }
+
+    static inline ui::headless_context_t headless_ {};
+};
+
+TEST_F(TextureManager, test_rows_sliced_by_budget) {
+    opengl::TextureManager manager;
+    manager.request("rows", {.image = image(16, 16)});
+    ASSERT_EQ(manager.state("rows"), opengl::TextureState::LOADING);
+    const auto& placeholder =
+        manager.get_or_placeholder<opengl::texture_data_t>("rows");
+    ASSERT_EQ(placeholder.w, 1);
+    ASSERT_EQ(placeholder.h, 1);
+
+    // two RGBA rows of 16 a poll
+    const size_t polls = stream<opengl::texture_data_t>(manager, "rows",
+                                                        2 * 16 * 4);
+    ASSERT_EQ(manager.state("rows"), opengl::TextureState::RESIDENT);
+    ASSERT_EQ(polls, 8u);
+    ASSERT_EQ(manager.streaming_stats().uploads, 8u);
+    ASSERT_EQ(manager.streaming_stats().bytes, 16u * 16u * 4u);
+
+    const auto& texture =
+        manager.get_or_placeholder<opengl::texture_data_t>("rows");
+    ASSERT_NE(texture.id, placeholder.id);
+    ASSERT_EQ(texture.w, 16);
+    ASSERT_EQ(texture.h, 16);
+}
+
+TEST_F(TextureManager, test_slice_per_poll_below_budget) {
+    opengl::TextureManager manager;
+    manager.request("rows", {.image = image(8, 4)});
+    ASSERT_EQ(stream<opengl::texture_data_t>(manager, "rows", 1), 4u);
+    ASSERT_EQ(manager.state("rows"), opengl::TextureState::RESIDENT);
+    ASSERT_EQ(manager.streaming_stats().uploads, 4u);
+}
+
+TEST_F(TextureManager, test_layers_sliced_by_budget) {
+    opengl::TextureManager manager;
+    // a 2x2 sheet of 8x8 tiles, a layer a poll
+    manager.request("sheet", {
+        .image = image(16, 16),
+        .tile_count_w = 2,
+        .tile_count_h = 2
+    });
+    const auto& placeholder =
+        manager.get_or_placeholder<opengl::texture_data_array_2d_t>("sheet");
+    ASSERT_EQ(placeholder.total_tiles(), 1u);
+
+    const size_t polls = stream<opengl::texture_data_array_2d_t>(
+        manager, "sheet", 8 * 8 * 4
+    );
+    ASSERT_EQ(manager.state("sheet"), opengl::TextureState::RESIDENT);
+    ASSERT_EQ(polls, 4u);
+    ASSERT_EQ(manager.streaming_stats().bytes, 16u * 16u * 4u);
+
+    auto sheet = manager.get<opengl::texture_data_array_2d_t>("sheet");
+    ASSERT_TRUE(sheet.has_value());
+    ASSERT_EQ(sheet->get().total_tiles(), 4u);
+    ASSERT_EQ(sheet->get().tile_w(), 8);
+}
+
+TEST_F(TextureManager, test_callback_on_resident) {
+    opengl::TextureManager manager;
+    std::vector<std::pair<std::string, opengl::TextureState>> calls;
+    auto done = [&calls](const std::string& key, opengl::TextureState state) {
+        calls.emplace_back(key, state);
+    };
+    manager.request("a", {.image = image(4, 4)}, done);
+    // a second request while loading only adds its callback
+    manager.request("a", {.image = image(4, 4)}, done);
+    ASSERT_TRUE(calls.empty());
+
+    finish(manager);
+    ASSERT_EQ(manager.state("a"), opengl::TextureState::RESIDENT);
+    ASSERT_EQ(calls.size(), 2u);
+    for (const auto& [key, state] : calls) {
+        ASSERT_EQ(key, "a");
+        ASSERT_EQ(state, opengl::TextureState::RESIDENT);
+    }
+    const auto& stats = manager.streaming_stats();
+    ASSERT_EQ(stats.requested, 1u);
+    ASSERT_EQ(stats.resident, 1u);
+    ASSERT_EQ(stats.failed, 0u);
+}
+
+TEST_F(TextureManager, test_missing_file_fails) {
+    opengl::TextureManager manager;
+    std::optional<opengl::TextureState> called;
+    manager.request("missing", {.path = "no/such/texture.png"},
+                    [&called](const std::string&, opengl::TextureState s) {
+                        called = s;
+                    });
+    finish(manager);
+
+    ASSERT_EQ(manager.state("missing"), opengl::TextureState::FAILED);
+    ASSERT_EQ(called, opengl::TextureState::FAILED);
+    ASSERT_FALSE(manager.contains("missing"));
+    ASSERT_EQ(manager.streaming_stats().failed, 1u);
+    ASSERT_EQ(manager.streaming_stats().uploads, 0u);
+    ASSERT_EQ(manager.get_or_placeholder<opengl::texture_data_t>("missing").w,
+              1);
+}
+
+TEST_F(TextureManager, test_request_again_frees_old) {
+    opengl::TextureManager manager;
+    manager.request("a", {.image = image(4, 4)});
+    finish(manager);
+    const GLuint old = manager.get<opengl::texture_data_t>("a")->get().id;
+    ASSERT_TRUE(glIsTexture(old));
+
+    manager.request("a", {.image = image(8, 8)});
+    // the old texture stands in until the new one is up
+    ASSERT_TRUE(glIsTexture(old));
+    finish(manager);
+    ASSERT_EQ(manager.state("a"), opengl::TextureState::RESIDENT);
+
+    const auto& texture = manager.get<opengl::texture_data_t>("a")->get();
+    ASSERT_NE(texture.id, old);
+    ASSERT_EQ(texture.w, 8);
+    ASSERT_FALSE(glIsTexture(old));
+    ASSERT_EQ(manager.streaming_stats().resident, 2u);
+}
+
+TEST_F(TextureManager, test_bc1_falls_back_without_s3tc) {
+    opengl::TextureManager manager;
+    manager.request("bc1", {
+        .image = image(8, 8),
+        .mips = {.is_srgb = true},
+        .compression = opengl::compression_config_t {
+            .format = opengl::BlockFormat::BC1
+        }
+    });
+    finish(manager);
+    ASSERT_EQ(manager.state("bc1"), opengl::TextureState::RESIDENT);
+
+    const GLuint id = manager.get<opengl::texture_data_t>("bc1")->get().id;
+    GLint format = 0;
+    SAFE_CALL(glGetTextureLevelParameteriv(id, 0, GL_TEXTURE_INTERNAL_FORMAT,
+                                           &format));
+    const bool is_s3tc = opengl::is_block_format_supported(
+        opengl::BlockFormat::BC1, true
+    );
+    ASSERT_EQ(GLenum(format), is_s3tc
+        ? GLenum(GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT)
+        : GLenum(GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM));
+}
+
+TEST_F(TextureManager, test_least_recently_got_evicted) {
+    opengl::TextureManager manager;
+    request_abc(manager);
+    const size_t bytes = manager.memory("a");
+    ASSERT_GT(bytes, 0u);
+    ASSERT_EQ(manager.memory_stats().used, 3 * bytes);
+
+    manager.memory_budget(2 * bytes);
+    manager.poll();
+    ASSERT_EQ(manager.state("a"), opengl::TextureState::EVICTED);
+    ASSERT_EQ(manager.state("b"), opengl::TextureState::RESIDENT);
+    ASSERT_EQ(manager.state("c"), opengl::TextureState::RESIDENT);
+    ASSERT_FALSE(manager.contains("a"));
+    ASSERT_EQ(manager.memory("a"), 0u);
+    ASSERT_EQ(manager.memory_stats().used, 2 * bytes);
+    ASSERT_EQ(manager.memory_stats().evictions, 1u);
+}
+
+TEST_F(TextureManager, test_last_frame_kept_over_budget) {
+    opengl::TextureManager manager;
+    request_abc(manager);
+    const size_t bytes = manager.memory("a");
+
+    // all three drawn the last frame, none goes
+    manager.memory_budget(1);
+    for (auto key : {"a", "b", "c"}) {
+        manager.get<opengl::texture_data_t>(key);
+    }
+    manager.poll();
+    ASSERT_EQ(manager.memory_stats().evictions, 0u);
+    ASSERT_EQ(manager.memory_stats().used, 3 * bytes);
+
+    // a budget of one keeps the one the last frame drew
+    manager.memory_budget(bytes);
+    manager.get<opengl::texture_data_t>("b");
+    manager.poll();
+    ASSERT_EQ(manager.state("a"), opengl::TextureState::EVICTED);
+    ASSERT_EQ(manager.state("b"), opengl::TextureState::RESIDENT);
+    ASSERT_EQ(manager.state("c"), opengl::TextureState::EVICTED);
+    ASSERT_EQ(manager.memory_stats().evictions, 2u);
+    ASSERT_EQ(manager.memory_stats().used, bytes);
+}
+
+TEST_F(TextureManager, test_evicted_reloads_on_get) {
+    opengl::TextureManager manager;
+    request_abc(manager);
+    manager.memory_budget(2 * manager.memory("a"));
+    manager.poll();
+    ASSERT_EQ(manager.state("a"), opengl::TextureState::EVICTED);
+    ASSERT_EQ(manager.memory_stats().reloads, 0u);
+
+    // the placeholder stands in, the next poll requests it again
+    manager.memory_budget(0);
+    ASSERT_EQ(manager.get_or_placeholder<opengl::texture_data_t>("a").w, 1);
+    manager.poll();
+    ASSERT_EQ(manager.memory_stats().reloads, 1u);
+    ASSERT_EQ(manager.state("a"), opengl::TextureState::LOADING);
+    finish(manager);
+
+    ASSERT_EQ(manager.state("a"), opengl::TextureState::RESIDENT);
+    auto texture = manager.get<opengl::texture_data_t>("a");
+    ASSERT_TRUE(texture.has_value());
+    ASSERT_EQ(texture->get().w, 16);
+    ASSERT_EQ(manager.memory_stats().used, 3 * manager.memory("a"));
+    ASSERT_EQ(manager.memory_stats().reloads, 1u);
+    ASSERT_EQ(manager.memory_stats().evictions, 1u);
+}
+
+TEST_F(TextureManager, test_updated_never_evicted) {
+    auto owned = opengl::texture_data_t::create_default_from_image(
+        opengl::ImageData::create(16, 16, glm::u8vec3 {1, 2, 3})
+    );
+    {
+        opengl::TextureManager manager;
+        manager.update("mine", owned);
+        manager.request("a", {.image = image(16, 16)});
+        finish(manager);
+        const size_t bytes = manager.memory("mine");
+        ASSERT_GT(bytes, 0u);
+        ASSERT_EQ(manager.memory_stats().used, bytes + manager.memory("a"));
+
+        manager.memory_budget(1);
+        manager.poll();
+        manager.poll();
+        ASSERT_EQ(manager.state("a"), opengl::TextureState::EVICTED);
+        ASSERT_EQ(manager.state("mine"), opengl::TextureState::RESIDENT);
+        ASSERT_TRUE(manager.contains("mine"));
+        ASSERT_EQ(manager.memory_stats().used, bytes);
+        ASSERT_EQ(manager.memory_stats().evictions, 1u);
+    }
+    // the caller's to free
+    ASSERT_TRUE(glIsTexture(owned.id));
+    owned.free();
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
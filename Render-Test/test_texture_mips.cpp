@@ -0,0 +1,133 @@
+#include <vector>
+#include <filesystem>
+
+#include <gtest/gtest.h>
+#include <OpenGL/texture_mips.hpp>
+
+static opengl::ImageData gradient(int w, int h, opengl::ColorMode mode) {
+    const int channels = int(mode);
+    opengl::ImageData image;
+    image.w = w;
+    image.h = h;
+    image.mode = mode;
+    image.data = new opengl::byte_t[image.size()];
+    for (int i = 0; i < image.size(); ++i) {
+        image.data[i] = opengl::byte_t((i / channels) * 13 + i % channels * 71);
+    }
+    return image;
+}
+
+TEST(TextureMips, test_level_sizes) {
+    const auto chain = opengl::build_mip_chain(
+        gradient(20, 6, opengl::ColorMode::RGB)
+    );
+    ASSERT_EQ(chain.levels.size(), 5);
+    const std::vector<std::pair<int, int>> sizes {
+        {20, 6}, {10, 3}, {5, 1}, {2, 1}, {1, 1}
+    };
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        ASSERT_EQ(chain.levels[i].w, sizes[i].first);
+        ASSERT_EQ(chain.levels[i].h, sizes[i].second);
+        ASSERT_EQ(chain.levels[i].mode, opengl::ColorMode::RGB);
+    }
+}
+
+TEST(TextureMips, test_box_matches_reference) {
+    // wide enough for the vector loop and its scalar tail
+    const auto source = gradient(38, 10, opengl::ColorMode::RGBA);
+    const auto chain = opengl::build_mip_chain(source);
+    const auto& level = chain.levels[1];
+    ASSERT_EQ(level.w, 19);
+    for (int y = 0; y < level.h; ++y) {
+        for (int x = 0; x < level.w; ++x) {
+            for (int c = 0; c < 4; ++c) {
+                auto at = [&](int sx, int sy) {
+                    return int(source.data[(sy * source.w + sx) * 4 + c]);
+                };
+                const int sum = at(2 * x, 2 * y) + at(2 * x + 1, 2 * y)
+                              + at(2 * x, 2 * y + 1)
+                              + at(2 * x + 1, 2 * y + 1);
+                ASSERT_EQ(level.data[(y * level.w + x) * 4 + c],
+                          (sum + 2) / 4);
+            }
+        }
+    }
+}
+
+TEST(TextureMips, test_srgb_averages_light) {
+    // black and white stripes, a gray of half the light is 188 in sRGB
+    opengl::ImageData image = opengl::ImageData::create(
+        2, 2, std::vector<glm::u8vec4>{
+            {0, 0, 0, 0}, {255, 255, 255, 255},
+            {0, 0, 0, 0}, {255, 255, 255, 255}
+        }
+    );
+    const auto linear = opengl::build_mip_chain(image);
+    ASSERT_EQ(linear.levels[1].data[0], 128);
+
+    const auto chain = opengl::build_mip_chain(image, {.is_srgb = true});
+    ASSERT_TRUE(chain.is_srgb);
+    ASSERT_NEAR(chain.levels[1].data[0], 188, 1);
+    // alpha stays linear
+    ASSERT_NEAR(chain.levels[1].data[3], 128, 1);
+}
+
+TEST(TextureMips, test_kaiser_keeps_flat_color) {
+    const auto image = opengl::ImageData::create(
+        64, 16, glm::u8vec4{200, 100, 50, 255}
+    );
+    const auto chain = opengl::build_mip_chain(
+        image, {.filter = opengl::MipFilter::KAISER}
+    );
+    ASSERT_EQ(chain.levels.size(), 7);
+    for (const auto& level : chain.levels) {
+        for (int i = 0; i < level.size(); i += 4) {
+            ASSERT_NEAR(level.data[i + 0], 200, 1);
+            ASSERT_NEAR(level.data[i + 1], 100, 1);
+            ASSERT_NEAR(level.data[i + 2], 50, 1);
+            ASSERT_EQ(level.data[i + 3], 255);
+        }
+    }
+}
+
+TEST(TextureMips, test_disk_cache) {
+    const auto dir = std::filesystem::temp_directory_path() / "mips_test";
+    std::filesystem::remove_all(dir);
+
+    const opengl::mip_config_t config {
+        .filter = opengl::MipFilter::KAISER,
+        .is_srgb = true,
+        .cache_dir = dir
+    };
+    const auto source = gradient(32, 32, opengl::ColorMode::RGBA);
+    const auto built = opengl::build_mip_chain(source, config);
+    ASSERT_EQ(std::distance(std::filesystem::directory_iterator(dir),
+                            std::filesystem::directory_iterator()), 1);
+
+    const auto path = std::filesystem::directory_iterator(dir)->path();
+    const auto loaded = opengl::load_mip_chain(path);
+    ASSERT_TRUE(loaded.has_value());
+    ASSERT_TRUE(loaded->is_srgb);
+    ASSERT_EQ(loaded->levels.size(), built.levels.size());
+    for (size_t i = 0; i < built.levels.size(); ++i) {
+        const auto& a = built.levels[i];
+        const auto& b = loaded->levels[i];
+        ASSERT_EQ(a.w, b.w);
+        ASSERT_EQ(a.h, b.h);
+        ASSERT_TRUE(std::equal(a.data, a.data + a.size(), b.data));
+    }
+
+    // a second build is served from the file
+    const auto cached = opengl::build_mip_chain(source, config);
+    ASSERT_EQ(cached.levels.size(), built.levels.size());
+    ASSERT_TRUE(std::equal(cached.levels[3].data,
+                           cached.levels[3].data + cached.levels[3].size(),
+                           built.levels[3].data));
+    ASSERT_FALSE(opengl::load_mip_chain(dir / "missing.mips").has_value());
+    std::filesystem::remove_all(dir);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,198 @@
+#include <array>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <UI/headless.hpp>
+#include <OpenGL/opengl_proc.hpp>
+#include <OpenGL/opengl_render_data.hpp>
+#include <OpenGL/opengl_texture_units.hpp>
+
+// Needs a GL context, the cases skip where UI was built without EGL or no
+// EGL display is around
+class TextureUnits : public testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        headless_ = ui::headless_context_t::create(4, 5);
+        if (headless_.is_valid()) {
+            opengl::Context::instance().initialize(headless_.api());
+        }
+    }
+
+    static void TearDownTestSuite() {
+        opengl::SamplerCache::instance().clear();
+        headless_.free();
+    }
+
+    void SetUp() override {
+        if (!headless_.is_valid()) { GTEST_SKIP() << "no GL context"; }
+        for (auto& texture : textures_) {
+            texture = opengl::gen_texture(GL_TEXTURE_2D);
+        }
+        // nothing bound, so every case starts from a known cache
+        std::array<opengl::texture_binding_t, 4> none {};
+        opengl::Context::instance().bind_textures(0, none.data(), none.size());
+        opengl::Context::instance().reset_state_stats();
+    }
+
+    void TearDown() override {
+        if (!headless_.is_valid()) { return; }
+        for (auto texture : textures_) {
+            opengl::Context::instance().forget_texture(texture);
+        }
+        SAFE_CALL(glDeleteTextures(GLsizei(textures_.size()),
+                                   textures_.data()));
+    }
+
+    static GLint bound(GLuint unit) {
+        GLint id = 0;
+        SAFE_CALL(glGetIntegeri_v(GL_TEXTURE_BINDING_2D, unit, &id));
+        return id;
+    }
+
+    static inline ui::headless_context_t headless_ {};
+    std::array<GLuint, 4> textures_ {};
+};
+
+TEST_F(TextureUnits, test_unchanged_rebind_is_elided) {
+    auto& ctx = opengl::Context::instance();
+    std::array<opengl::texture_binding_t, 2> bindings {{
+        {.texture = textures_[0]},
+        {.texture = textures_[1]}
+    }};
+    ASSERT_EQ(ctx.bind_textures(0, bindings.data(), 2), 2u);
+    ASSERT_EQ(ctx.state_stats().issued, 1u);
+
+    ASSERT_EQ(ctx.bind_textures(0, bindings.data(), 2), 0u);
+    ASSERT_EQ(ctx.state_stats().issued, 1u);
+    ASSERT_EQ(bound(0), GLint(textures_[0]));
+    ASSERT_EQ(bound(1), GLint(textures_[1]));
+}
+
+TEST_F(TextureUnits, test_only_changed_runs_flushed) {
+    auto& ctx = opengl::Context::instance();
+    std::array<opengl::texture_binding_t, 4> bindings {};
+    for (size_t i = 0; i < bindings.size(); ++i) {
+        bindings[i].texture = textures_[i];
+    }
+    ctx.bind_textures(0, bindings.data(), bindings.size());
+    ctx.reset_state_stats();
+
+    // units 1 and 2 form one run, 0 and 3 stay
+    std::swap(bindings[1].texture, bindings[2].texture);
+    ASSERT_EQ(ctx.bind_textures(0, bindings.data(), bindings.size()), 2u);
+    ASSERT_EQ(ctx.state_stats().issued, 1u);
+    for (GLuint unit = 0; unit < bindings.size(); ++unit) {
+        ASSERT_EQ(bound(unit), GLint(bindings[unit].texture));
+    }
+
+    // two runs apart, one call each
+    bindings[0].texture = textures_[3];
+    bindings[3].texture = textures_[0];
+    ctx.reset_state_stats();
+    ASSERT_EQ(ctx.bind_textures(0, bindings.data(), bindings.size()), 2u);
+    ASSERT_EQ(ctx.state_stats().issued, 2u);
+    ASSERT_EQ(bound(0), GLint(textures_[3]));
+    ASSERT_EQ(bound(3), GLint(textures_[0]));
+}
+
+TEST_F(TextureUnits, test_samplers_shared) {
+    auto& cache = opengl::SamplerCache::instance();
+    const opengl::sampler_params_t nearest {
+        .min_filter = GL_NEAREST,
+        .mag_filter = GL_NEAREST
+    };
+    const GLuint first = cache.get(nearest);
+    ASSERT_NE(first, 0u);
+    ASSERT_EQ(cache.get(nearest), first);
+    const size_t size = cache.size();
+
+    auto clamped = nearest;
+    clamped.wrap_s = GL_CLAMP_TO_EDGE;
+    ASSERT_NE(cache.get(clamped), first);
+    ASSERT_EQ(cache.size(), size + 1);
+}
+
+TEST_F(TextureUnits, test_explicit_binding_kept) {
+    static constexpr auto VERTEX = R"(
+        #version 450 core
+        void main() { gl_Position = vec4(0.0, 0.0, 0.0, 1.0); }
+    )";
+    static constexpr auto FRAGMENT = R"(
+        #version 450 core
+        layout(binding = 3) uniform sampler2D bound_3;
+        uniform sampler2D first;
+        uniform sampler2D second;
+        out vec4 color;
+        void main() {
+            vec2 uv = gl_FragCoord.xy;
+            color = texture(bound_3, uv) + texture(first, uv)
+                  + texture(second, uv);
+        }
+    )";
+    auto program = opengl::Program::create(
+        opengl::compile_program(VERTEX, FRAGMENT)
+    );
+    ASSERT_TRUE(program.is_valid());
+
+    const GLint explicit_unit = program.texture_unit(
+        program.uniform("bound_3")
+    );
+    const GLint first = program.texture_unit(program.uniform("first"));
+    const GLint second = program.texture_unit(program.uniform("second"));
+    ASSERT_EQ(explicit_unit, 3);
+    ASSERT_NE(first, second);
+    ASSERT_NE(first, 3);
+    ASSERT_NE(second, 3);
+    ASSERT_EQ(program.texture_units(), 4);
+    program.free();
+}
+
+TEST_F(TextureUnits, test_sampler_array_takes_a_run) {
+    static constexpr auto VERTEX = R"(
+        #version 450 core
+        void main() { gl_Position = vec4(0.0, 0.0, 0.0, 1.0); }
+    )";
+    static constexpr auto FRAGMENT = R"(
+        #version 450 core
+        uniform sampler2D single;
+        uniform sampler2D layers[3];
+        layout(binding = 6) uniform sampler2D bound[2];
+        out vec4 color;
+        void main() {
+            vec2 uv = gl_FragCoord.xy;
+            color = texture(single, uv) + texture(bound[0], uv)
+                  + texture(bound[1], uv);
+            for (int i = 0; i < 3; ++i) { color += texture(layers[i], uv); }
+        }
+    )";
+    auto program = opengl::Program::create(
+        opengl::compile_program(VERTEX, FRAGMENT)
+    );
+    ASSERT_TRUE(program.is_valid());
+
+    auto element = [&program](const char* name, GLint index) {
+        const auto element = std::string(name) + "["
+                           + std::to_string(index) + "]";
+        const GLint location = glGetUniformLocation(program.id(),
+                                                    element.c_str());
+        GLint unit = -1;
+        SAFE_CALL(glGetUniformiv(program.id(), location, &unit));
+        return unit;
+    };
+    const GLint single = program.texture_unit(program.uniform("single"));
+    const GLint first = program.texture_unit(program.uniform("layers"));
+    for (GLint i = 0; i < 3; ++i) {
+        ASSERT_EQ(element("layers", i), first + i);
+        ASSERT_NE(first + i, single);
+        ASSERT_LT(first + i, 6);
+    }
+    ASSERT_EQ(program.texture_unit(program.uniform("bound")), 6);
+    ASSERT_EQ(element("bound", 1), 7);
+    ASSERT_EQ(program.texture_units(), 8);
+    program.free();
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
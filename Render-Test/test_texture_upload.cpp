@@ -0,0 +1,83 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <OpenGL/texture.hpp>
+
+static opengl::texture_data_array_2d_t sheet(int w, int h, GLint format,
+                                             size_t tcw, size_t tch) {
+    return {
+        .tex_data = {.w = w, .h = h, .format = format},
+        .tile_count_w = tcw,
+        .tile_count_h = tch
+    };
+}
+
+TEST(TextureUpload, test_retile_small) {
+    // 2 x 2 tiles of 2 x 1 red pixels, numbered by position in the sheet
+    const std::vector<opengl::byte_t> pixels {
+        0, 1, 2, 3,
+        4, 5, 6, 7
+    };
+    std::vector<opengl::byte_t> layers(pixels.size());
+    opengl::retile_to_layers(pixels.data(), sheet(4, 2, GL_RED, 2, 2),
+                             layers.data());
+    ASSERT_EQ(layers, pixels);
+
+    // 2 x 1 tiles of 2 x 2
+    std::vector<opengl::byte_t> tall(pixels.size());
+    opengl::retile_to_layers(pixels.data(), sheet(4, 2, GL_RED, 2, 1),
+                             tall.data());
+    ASSERT_EQ(tall, std::vector<opengl::byte_t>({0, 1, 4, 5, 2, 3, 6, 7}));
+}
+
+TEST(TextureUpload, test_retile_threaded) {
+    const int w = 2048, h = 1024;
+    const size_t tcw = 32, tch = 16;
+    const auto data = sheet(w, h, GL_RGBA, tcw, tch);
+    std::vector<opengl::byte_t> pixels(size_t(w) * h * 4);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = opengl::byte_t(i * 7 + i / 4093);
+    }
+
+    std::vector<opengl::byte_t> layers(pixels.size());
+    opengl::retile_to_layers(pixels.data(), data, layers.data());
+
+    const size_t tw = data.tile_w(), th = data.tile_h();
+    for (size_t i = 0; i < tcw * tch; ++i) {
+        for (size_t y = 0; y < th; ++y) {
+            const size_t sx = (i % tcw) * tw;
+            const size_t sy = (i / tcw) * th + y;
+            const auto* from = &pixels[(sy * w + sx) * 4];
+            const auto* to = &layers[((i * th) + y) * tw * 4];
+            ASSERT_TRUE(std::equal(from, from + tw * 4, to)) << i << " " << y;
+        }
+    }
+}
+
+TEST(TextureUpload, test_texture_bytes) {
+    opengl::texture_data_t params {
+        .w = 16, .h = 8, .format = GL_RGBA, .min_filter = GL_LINEAR
+    };
+    ASSERT_EQ(opengl::texture_bytes(params), 16 * 8 * 4);
+
+    // 16x8, 8x4, 4x2, 2x1, 1x1
+    params.min_filter = GL_LINEAR_MIPMAP_LINEAR;
+    ASSERT_EQ(opengl::texture_bytes(params), (128 + 32 + 8 + 2 + 1) * 4);
+
+    // three channels take four
+    params.format = GL_RGB;
+    params.min_filter = GL_NEAREST;
+    ASSERT_EQ(opengl::texture_bytes(params), 16 * 8 * 4);
+
+    // 4 x 2 tiles of 4 x 4 red
+    auto data = sheet(16, 8, GL_RED, 4, 2);
+    data.tex_data.min_filter = GL_LINEAR;
+    ASSERT_EQ(opengl::texture_bytes(data), 8 * 16);
+    data.tex_data.min_filter = GL_NEAREST_MIPMAP_NEAREST;
+    ASSERT_EQ(opengl::texture_bytes(data), 8 * (16 + 4 + 1));
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
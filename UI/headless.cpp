@@ -0,0 +1,184 @@
+#include <vector>
+#include <cstring>
+#include <iostream>
+
+#if RENDER_HAS_EGL
+#   include <EGL/egl.h>
+#   include <EGL/eglext.h>
+#endif
+
+#include "headless.hpp"
+
+
+namespace ui {
+
+#if RENDER_HAS_EGL
+
+static bool has_extension(EGLDisplay display, const char* name) {
+    const char* list = eglQueryString(display, EGL_EXTENSIONS);
+    if (list == nullptr) { return false; }
+
+    const size_t length = std::strlen(name);
+    for (const char* it = std::strstr(list, name); it != nullptr;
+         it = std::strstr(it + length, name)) {
+        const bool is_start = it == list || it[-1] == ' ';
+        const bool is_end = it[length] == ' ' || it[length] == '\0';
+        if (is_start && is_end) { return true; }
+    }
+    return false;
+}
+
+// Surfaceless Mesa first, then the first device, then whatever is default
+static EGLDisplay open_display() {
+    auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+        eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display == nullptr) {
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    if (has_extension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+        EGLDisplay display = get_platform_display(
+            EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr
+        );
+        if (display != EGL_NO_DISPLAY) { return display; }
+    }
+
+    auto query_devices = (PFNEGLQUERYDEVICESEXTPROC)
+        eglGetProcAddress("eglQueryDevicesEXT");
+    if (query_devices != nullptr &&
+        has_extension(EGL_NO_DISPLAY, "EGL_EXT_platform_device")) {
+        EGLDeviceEXT device = nullptr;
+        EGLint count = 0;
+        if (query_devices(1, &device, &count) && count > 0) {
+            EGLDisplay display = get_platform_display(
+                EGL_PLATFORM_DEVICE_EXT, device, nullptr
+            );
+            if (display != EGL_NO_DISPLAY) { return display; }
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static bool is_egl_current() {
+    return eglGetCurrentContext() != EGL_NO_CONTEXT;
+}
+
+headless_context_t headless_context_t::create(int major, int minor,
+                                              opengl::ErrorMode mode) {
+    using opengl::ErrorMode;
+
+    headless_context_t self;
+    opengl::Context::instance().error_mode(mode);
+
+    EGLDisplay display = open_display();
+    EGLint egl_major = 0, egl_minor = 0;
+    if (display == EGL_NO_DISPLAY ||
+        !eglInitialize(display, &egl_major, &egl_minor)) {
+        std::cerr << "Failed to open an EGL display" << std::endl;
+        return self;
+    }
+    self.display = display;
+
+    const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE,        8,
+        EGL_GREEN_SIZE,      8,
+        EGL_BLUE_SIZE,       8,
+        EGL_ALPHA_SIZE,      8,
+        EGL_DEPTH_SIZE,      24,
+        EGL_STENCIL_SIZE,    8,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint count = 0;
+    if (!eglChooseConfig(display, config_attribs, &config, 1, &count) ||
+        count == 0 || !eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "No EGL config for desktop OpenGL" << std::endl;
+        self.free();
+        return self;
+    }
+
+    // same rules as init_glfw, debug contexts only for the callback modes
+    const bool is_debug = mode == ErrorMode::DEBUG_CALLBACK
+                          || mode == ErrorMode::PER_CALL;
+    std::vector<EGLint> context_attribs {
+        EGL_CONTEXT_MAJOR_VERSION,       major,
+        EGL_CONTEXT_MINOR_VERSION,       minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_CONTEXT_OPENGL_DEBUG,        is_debug ? EGL_TRUE : EGL_FALSE
+    };
+    if (mode == ErrorMode::OFF &&
+        has_extension(display, "EGL_KHR_create_context_no_error")) {
+        context_attribs.push_back(EGL_CONTEXT_OPENGL_NO_ERROR_KHR);
+        context_attribs.push_back(EGL_TRUE);
+    }
+    context_attribs.push_back(EGL_NONE);
+
+    self.context = eglCreateContext(display, config, EGL_NO_CONTEXT,
+                                    context_attribs.data());
+    if (self.context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create an EGL context " << major << "."
+                  << minor << std::endl;
+        self.context = nullptr;
+        self.free();
+        return self;
+    }
+
+    if (!has_extension(display, "EGL_KHR_surfaceless_context")) {
+        const EGLint pbuffer_attribs[] = {
+            EGL_WIDTH, 1,
+            EGL_HEIGHT, 1,
+            EGL_NONE
+        };
+        self.surface = eglCreatePbufferSurface(display, config,
+                                               pbuffer_attribs);
+    }
+    if (!self.make_current()) {
+        std::cerr << "Failed to make the EGL context current" << std::endl;
+        self.free();
+    }
+    return self;
+}
+
+bool headless_context_t::make_current() const {
+    EGLSurface draw = surface ? surface : EGL_NO_SURFACE;
+    return eglMakeCurrent(display, draw, draw, context) == EGL_TRUE;
+}
+
+opengl::context_api_t headless_context_t::api() {
+    return {
+        .load_proc = (GLADloadproc)eglGetProcAddress,
+        .is_current = is_egl_current
+    };
+}
+
+void headless_context_t::free() {
+    if (display == nullptr) { return; }
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != nullptr) { eglDestroySurface(display, surface); }
+    if (context != nullptr) { eglDestroyContext(display, context); }
+    eglTerminate(display);
+    display = nullptr;
+    context = nullptr;
+    surface = nullptr;
+}
+
+#else
+
+headless_context_t headless_context_t::create(int, int, opengl::ErrorMode) {
+    std::cerr << "Headless contexts need EGL, UI was built without it"
+              << std::endl;
+    return {};
+}
+
+bool headless_context_t::make_current() const { return false; }
+
+opengl::context_api_t headless_context_t::api() { return {}; }
+
+void headless_context_t::free() {}
+
+#endif
+
+}
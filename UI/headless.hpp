@@ -0,0 +1,37 @@
+#pragma once
+
+#include <OpenGL/opengl_context.hpp>
+
+
+namespace ui {
+
+// OpenGL context without a window or a display server, for render servers
+// and CI. Made through EGL: a surfaceless display (Mesa, llvmpipe included)
+// or the first EGL device, falling back to the default display. There is no
+// default framebuffer, draw into opengl::framebuffer_data_t targets and take
+// the frames with framebuffer_data_t::read().
+//
+//   auto headless = ui::headless_context_t::create(4, 6);
+//   if (!headless.is_valid()) { return EXIT_FAILURE; }
+//   opengl::Context::instance().initialize(headless.api());
+struct headless_context_t final {
+    void* display {nullptr}; // EGLDisplay
+    void* context {nullptr}; // EGLContext
+    void* surface {nullptr}; // EGLSurface, 1x1 pbuffer or none
+
+public:
+    // Also stores the mode in opengl::Context, like init_glfw
+    static headless_context_t create(
+        int major, int minor,
+        opengl::ErrorMode mode = opengl::DEFAULT_ERROR_MODE
+    );
+
+    bool is_valid() const { return context != nullptr; }
+    bool make_current() const;
+    // For opengl::Context::initialize
+    static opengl::context_api_t api();
+
+    void free();
+};
+
+}
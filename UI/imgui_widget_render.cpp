@@ -1,7 +1,10 @@
+#include <format>
 #include <iostream>
 #include <glad/glad.h>
 
 #include <OpenGL/opengl_proc.hpp>
+#include <OpenGL/opengl_gpu_profiler.hpp>
+#include <Profiler/profiler.hpp>
 
 #include "imgui_widget_render.hpp"
 
@@ -29,39 +32,45 @@ void ImGuiWidgetRender::visit(Window& widget) {
 }
 
 void ImGuiWidgetRender::visit(Canvas& widget) {
+    PROFILE_ZONE("Canvas::render");
     ImVec2 parent_size = ImGui::GetWindowSize();
     ImVec2 size = absolute_vec2(parent_size, convert(widget.size()));
     ImVec2 s_size = screen_size();
 
     widget.update(size.x, size.y);
-    const auto& fbuff = widget.fbuff();
+    const auto& target = widget.target();
+    if (target.colors.empty()) { return; }
     const auto& back = widget.background();
-    opengl::bind_fbo(fbuff.fbo);
-    opengl::background(back, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    opengl::viewport(0, 0, size.x, size.y);
-    for (const auto& entity : widget.entities()) {
-        const auto& render_data = entity->render_data();
-        auto program = render_data.program;
-        opengl::use(program);
-        opengl::set_mat4(program, "projection", widget.projection());
-        opengl::set_mat4(program, "view", widget.view());
-        opengl::set_mat4(program, "model", entity->model());
-        opengl::bind_vao(render_data.vao);
-        opengl::draw(entity->draw_command());
-        opengl::bind_vao(0);
-        opengl::use(0);
+    // the offscreen pass is timed as a GPU zone named after the canvas
+    {
+        opengl::GpuZone zone(widget.title());
+        opengl::bind_fbo(target.fbo);
+        opengl::viewport(0, 0, target.size.x, target.size.y);
+        opengl::background(back, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT
+                                 | GL_STENCIL_BUFFER_BIT);
+        auto& frame_constants = widget.frame_constants();
+        frame_constants.update(opengl::frame_constants_t::create(
+            widget.projection(),
+            widget.view()
+        ));
+        frame_constants.bind();
+        for (const auto& entity : widget.entities()) {
+            queue_.push(0, entity->program(), entity->draw_command())
+                  .uniform(entity->uniforms().model, entity->model());
+        }
+        queue_.flush();
+        opengl::viewport(0, 0, s_size.x, s_size.y);
+        opengl::bind_fbo(0);
     }
-    opengl::viewport(0, 0, s_size.x, s_size.y);
-    opengl::bind_fbo(0);
 
     ImGui::BeginChild(widget.title().data(), size);
 
     ImVec2 pos = ImGui::GetCursorScreenPos();
     ImVec2 uv_min = ImVec2(0.0f, 0.0f);                 // Top-left
-    ImVec2 uv_max = ImVec2(1.0f, 1.0f);                 // Lower-right
+    ImVec2 uv_max = convert(target.uv_max());           // Lower-right
     ImVec4 tint_col = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);   // No tints
     ImGui::GetWindowDrawList()->AddImage(
-        (void*)(intptr_t)fbuff.texture.id,
+        (void*)(intptr_t)target.colors[0].id,
         pos,
         ImVec2(pos.x + size.x, pos.y + size.y),
         uv_min, uv_max,
@@ -71,6 +80,49 @@ void ImGuiWidgetRender::visit(Canvas& widget) {
     ImGui::EndChild();
 }
 
+void ImGuiWidgetRender::visit(GpuProfilerView& widget) {
+    static constexpr ImGuiTableFlags TABLE = ImGuiTableFlags_Borders
+                                            | ImGuiTableFlags_RowBg;
+
+    ImVec2 parent_size = ImGui::GetWindowSize();
+    ImVec2 size = absolute_vec2(parent_size, convert(widget.size()));
+    const auto& profiler = opengl::GpuProfiler::instance();
+
+    ImGui::BeginChild(widget.title().data(), size);
+    ImGui::TextUnformatted(std::format("GPU frame {:.3f} ms, {} dropped",
+                                       profiler.frame_ms(),
+                                       profiler.dropped_frames()).c_str());
+    if (ImGui::BeginTable(widget.title().data(), 5, TABLE)) {
+        ImGui::TableSetupColumn("zone");
+        ImGui::TableSetupColumn("last ms");
+        ImGui::TableSetupColumn("avg ms");
+        ImGui::TableSetupColumn("max ms");
+        ImGui::TableSetupColumn("calls");
+        ImGui::TableHeadersRow();
+        for (const auto& zone : profiler.zones()) {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            const std::string indent(zone.depth * 2, ' ');
+            ImGui::TextUnformatted((indent + zone.name).c_str());
+            ImGui::TableSetColumnIndex(1);
+            ImGui::TextUnformatted(std::format("{:.3f}", zone.last_ms).c_str());
+            ImGui::TableSetColumnIndex(2);
+            ImGui::TextUnformatted(std::format("{:.3f}", zone.avg_ms).c_str());
+            ImGui::TableSetColumnIndex(3);
+            ImGui::TextUnformatted(std::format("{:.3f}", zone.max_ms).c_str());
+            ImGui::TableSetColumnIndex(4);
+            ImGui::TextUnformatted(std::to_string(zone.calls).c_str());
+        }
+        ImGui::EndTable();
+    }
+    ImGui::EndChild();
+}
+
+// Counters of the last flushed canvas
+const opengl::render_queue_stats_t& ImGuiWidgetRender::queue_stats() const {
+    return queue_.stats();
+}
+
 ImVec2 ImGuiWidgetRender::absolute_vec2(const ImVec2& parent_size,
                                         const ImVec2& rel_vec) const {
     return {
@@ -11,10 +11,16 @@ class ImGuiWidgetRender final : public Visitor {
 public:
     void visit(Window& widget) override;
     void visit(Canvas& widget) override;
+    void visit(GpuProfilerView& widget) override;
+
+    const opengl::render_queue_stats_t& queue_stats() const;
 
 private:
     ImVec2 absolute_vec2(const ImVec2& parent_vec, const ImVec2& rel_vec) const;
     ImVec2 screen_size() const;
+
+private:
+    opengl::RenderQueue queue_;
 };
 
 }
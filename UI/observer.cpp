@@ -1,3 +1,5 @@
+#include <Profiler/profiler.hpp>
+
 #include "observer.hpp"
 
 
@@ -143,6 +145,7 @@ void Publisher::predicate(std::function<bool(void)> p) {
 
 template <typename Event>
 inline void Publisher::templated_emit(const Event& e) const {
+    PROFILE_ZONE("Publisher::emit");
     for (Listener* l : _listeners) {
         if (bool(predicate_) && predicate_()) {
             l->consume(e);
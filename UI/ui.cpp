@@ -7,12 +7,19 @@
 
 namespace ui {
 
-bool init_glfw(int major, int minor) {
+bool init_glfw(int major, int minor, opengl::ErrorMode mode) {
+    using opengl::ErrorMode;
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+    // debug contexts are slower, ask for one only when the callback is used
+    const bool is_debug = mode == ErrorMode::DEBUG_CALLBACK
+                          || mode == ErrorMode::PER_CALL;
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, is_debug);
+    glfwWindowHint(GLFW_CONTEXT_NO_ERROR, mode == ErrorMode::OFF);
+    opengl::Context::instance().error_mode(mode);
     glfwWindowHint(GLFW_DOUBLEBUFFER, GLFW_TRUE);
     glfwWindowHint(GLFW_DEPTH_BITS, 64);
     glfwWindowHint(GLFW_STENCIL_BITS, 8);
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <OpenGL/opengl_context.hpp>
+
 struct GLFWwindow;
 namespace ui {
 
-bool init_glfw(int major, int minor);
+// Also stores the mode in opengl::Context, initialize() applies it
+bool init_glfw(int major, int minor,
+               opengl::ErrorMode mode = opengl::DEFAULT_ERROR_MODE);
 bool init_glfw_lite();
 void unload_glfw();
 
@@ -94,6 +94,16 @@ const opengl::render_data_t& CanvasEntity::render_data() const {
     return render_data_;
 }
 
+opengl::Program& CanvasEntity::program() {
+    // a failed link draws nothing instead of dereferencing null
+    static opengl::Program no_program;
+    return render_data_.program_ref->program_or(no_program);
+}
+
+const CanvasEntity::uniforms_t& CanvasEntity::uniforms() const {
+    return uniforms_;
+}
+
 void CanvasEntity::model(const glm::mat4& v) {
     model_ = v;
 }
@@ -113,22 +123,8 @@ opengl::draw_elements_command_t CanvasEntity::draw_command() const {
 std::shared_ptr<Canvas> Canvas::create(const glm::vec2& size,
                                        const std::string& title) {
     std::shared_ptr<Canvas> out(new Canvas(size, title));
-    out->fbuff_data_ = {
-        .fbo = opengl::gen_framebuffer(),
-        .attachment_point = GL_COLOR_ATTACHMENT0,
-        .texture = {
-            .id = opengl::gen_texture(),
-            .target = GL_TEXTURE_2D,
-            .w = 0,
-            .h = 0,
-            .format = GL_RGBA,
-            .type = GL_UNSIGNED_BYTE,
-            .wrap_s = GL_CLAMP_TO_EDGE,
-            .wrap_t = GL_CLAMP_TO_EDGE,
-            .min_filter = GL_LINEAR,
-            .mag_filter = GL_LINEAR
-        }
-    };
+    out->target_ = opengl::render_target_t::create({});
+    out->frame_constants_ = opengl::frame_uniform_buffer_t::create();
     return out;
 }
 
@@ -141,7 +137,8 @@ std::shared_ptr<Canvas> Canvas::create(const glm::vec2& size,
 }
 
 Canvas::~Canvas() {
-    //opengl::free_framebuffer(&fbuff_data_.fbo);
+    target_.free();
+    frame_constants_.free();
 }
 
 void Canvas::accept(Visitor& v) {
@@ -149,18 +146,15 @@ void Canvas::accept(Visitor& v) {
 }
 
 void Canvas::update(GLuint w, GLuint h) {
-    fbuff_data_.texture.w = w;
-    fbuff_data_.texture.h = h;
-    opengl::set_texture_meta(nullptr, fbuff_data_.texture);
-    opengl::attach_texture(fbuff_data_, fbuff_data_.texture);
+    target_.resize(GLsizei(w), GLsizei(h));
 }
 
 void Canvas::append(entity_sptr_t&& entity) {
     entities_.push_back(std::move(entity));
 }
 
-const opengl::framebuffer_data_t& Canvas::fbuff() const {
-    return fbuff_data_;
+const opengl::render_target_t& Canvas::target() const {
+    return target_;
 }
 
 const entities_list_t& Canvas::entities() const {
@@ -175,6 +169,10 @@ const glm::mat4& Canvas::view() const {
     return view_;
 }
 
+opengl::frame_uniform_buffer_t& Canvas::frame_constants() {
+    return frame_constants_;
+}
+
 void Canvas::background(const glm::vec4& b) {
     background_ = b;
 }
@@ -183,4 +181,15 @@ const glm::vec4& Canvas::background() const {
     return background_;
 }
 
+
+std::shared_ptr<GpuProfilerView> GpuProfilerView::create(
+        const glm::vec2& size,
+        const std::string& title) {
+    return std::shared_ptr<GpuProfilerView>(new GpuProfilerView(size, title));
+}
+
+void GpuProfilerView::accept(Visitor& v) {
+    v.visit(*this);
+}
+
 }
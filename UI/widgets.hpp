@@ -82,7 +82,8 @@ public:
            const typename informat_t::vertex_input_t& vertex_input,
            const opengl::elements_input_t& elements_input) {
         std::shared_ptr<CanvasEntity> self(new CanvasEntity());
-        self->render_data_.program = opengl::create_program(vertex, fragment);
+        self->render_data_.program_ref =
+            opengl::ProgramRegistry::instance().acquire_sync(vertex, fragment);
         self->render_data_.vao = opengl::gen_vertex_array();
         self->render_data_.ebo = opengl::gen_element_buffer();
         self->render_data_.vertex_buffers = informat_t::gen_buffers(
@@ -90,10 +91,21 @@ public:
             self->render_data_.ebo, elements_input
         );
         self->count_ = elements_input.size();
+        auto& program = self->program();
+        self->render_data_.program = program.id();
+        self->uniforms_ = {
+            .model = program.uniform("model")
+        };
         return self;
     }
 
+    struct uniforms_t final {
+        opengl::uniform_handle_t model;
+    };
+
     const opengl::render_data_t& render_data() const;
+    opengl::Program& program();
+    const uniforms_t& uniforms() const;
     void model(const glm::mat4& v);
     const glm::mat4& model() const;
 
@@ -101,6 +113,7 @@ public:
 
 private:
     opengl::render_data_t render_data_;
+    uniforms_t uniforms_;
     glm::mat4 model_ {glm::mat4(1.0)};
     GLsizei count_    {0};
 };
@@ -123,13 +136,15 @@ public:
     ~Canvas() override;
 
     void accept(Visitor& v) override;
+    // Size drawn at, the target only reallocates past its hysteresis
     void update(GLuint w, GLuint h);
     void append(entity_sptr_t&& entity);
 
-    const opengl::framebuffer_data_t& fbuff() const;
+    const opengl::render_target_t& target() const;
     const entities_list_t& entities() const;
     const glm::mat4& projection() const;
     const glm::mat4& view() const;
+    opengl::frame_uniform_buffer_t& frame_constants();
 
     void background(const glm::vec4& b);
     const glm::vec4& background() const;
@@ -138,7 +153,8 @@ private:
     using Widget::Widget;
 
 private:
-    opengl::framebuffer_data_t fbuff_data_ {};
+    opengl::render_target_t target_     {};
+    opengl::frame_uniform_buffer_t frame_constants_ {};
     entities_list_t entities_           {};
     glm::mat4 projection_               {glm::mat4(1.0)};
     glm::mat4 view_                     {glm::mat4(1.0)};
@@ -146,12 +162,28 @@ private:
 };
 
 
+// Table of the opengl::GpuProfiler zones
+class GpuProfilerView final : public Widget {
+public:
+    static std::shared_ptr<GpuProfilerView> create(
+        const glm::vec2& size,
+        const std::string& title
+    );
+
+    void accept(Visitor& v) override;
+
+private:
+    using Widget::Widget;
+};
+
+
 class Visitor {
 public:
     virtual ~Visitor() = default;
 
     virtual void visit(Window& w) = 0;
     virtual void visit(Canvas& w) = 0;
+    virtual void visit(GpuProfilerView& w) = 0;
 };
 
 }
@@ -5,6 +5,22 @@ set(RENDER_BOOST_INCLUDE_DIR "" CACHE PATH
 set(RENDER_BOOST_LINK_DIR "" CACHE PATH
     "Variable with boost library link path")
 
+# glGetError after every SAFE_CALL, always on for Debug builds
+option(RENDER_GL_CHECK_CALLS "Compile per call GL error checks" OFF)
+if (RENDER_GL_CHECK_CALLS)
+    set(RENDER_GL_CHECK_CALLS_VALUE 1)
+else ()
+    set(RENDER_GL_CHECK_CALLS_VALUE "$<IF:$<CONFIG:Debug>,1,0>")
+endif ()
+
+# PROFILE_ZONE markers, cheap enough to stay on in release builds
+option(RENDER_PROFILE "Compile CPU profiler zones" ON)
+if (RENDER_PROFILE)
+    set(RENDER_PROFILE_VALUE 1)
+else ()
+    set(RENDER_PROFILE_VALUE 0)
+endif ()
+
 
 function (copy_files)
     cmake_parse_arguments(THIS "" "" "FILES" ${ARGV})
@@ -38,7 +54,9 @@ function (create_executable)
     target_link_directories(${THIS_TARGET} PRIVATE ${RENDER_BOOST_LINK_DIR})
     set_property(TARGET ${THIS_TARGET} PROPERTY CXX_STANDARD 20)
     target_compile_definitions(${THIS_TARGET} PRIVATE
-                               "DEBUG=$<IF:$<CONFIG:Debug>,1,0>")
+                               "DEBUG=$<IF:$<CONFIG:Debug>,1,0>"
+                               "RENDER_GL_CHECK_CALLS=${RENDER_GL_CHECK_CALLS_VALUE}"
+                               "RENDER_PROFILE=${RENDER_PROFILE_VALUE}")
     if (THIS_SHADERS)
         message("Copying shaders: ${THIS_SHADERS}")
         copy_files(FILES ${THIS_SHADERS})
@@ -65,7 +83,9 @@ function (create_library)
     target_link_directories(${THIS_TARGET} PRIVATE ${RENDER_BOOST_LINK_DIR})
     set_property(TARGET ${THIS_TARGET} PROPERTY CXX_STANDARD 20)
     target_compile_definitions(${THIS_TARGET} PRIVATE
-                               "DEBUG=$<IF:$<CONFIG:Debug>,1,0>")
+                               "DEBUG=$<IF:$<CONFIG:Debug>,1,0>"
+                               "RENDER_GL_CHECK_CALLS=${RENDER_GL_CHECK_CALLS_VALUE}"
+                               "RENDER_PROFILE=${RENDER_PROFILE_VALUE}")
     if (THIS_SHADERS)
         message("Copying shaders: ${THIS_SHADERS}")
         copy_files(FILES ${THIS_SHADERS})
@@ -89,3 +109,16 @@ function (create_test_executable)
         MESHES ${THIS_MESHES}
     )
 endfunction(create_test_executable)
+
+
+function (create_benchmark_executable)
+    cmake_parse_arguments(THIS "" "TARGET" "HEADERS;SOURCES;LIBS;SHADERS;MESHES" ${ARGV})
+    create_executable(
+        TARGET  ${THIS_TARGET}
+        SOURCES ${THIS_SOURCES}
+        HEADERS ${THIS_HEADERS}
+        LIBS ${THIS_LIBS} benchmark::benchmark
+        SHADERS ${THIS_SHADERS}
+        MESHES ${THIS_MESHES}
+    )
+endfunction(create_benchmark_executable)